@@ -14,6 +14,7 @@ class LocalFileHandler extends BaseClass {
     this.soundBoardFolder = `${this.config.mp3FilesFolder}/soundboards`;
 
     this.espUploadUrl = `http://${this.config.esp32Ip}/upload`;
+    this.espManifestUrl = `http://${this.config.esp32Ip}/manifest`;
 
     if(this.fs.existsSync(this.config.mp3FilesFolder) === false) {
       this.logInfo(`Local main sound folder: ${this.config.mp3FilesFolder} does not exists creating it.`);
@@ -146,6 +147,34 @@ class LocalFileHandler extends BaseClass {
       throw new Error('No file found');
     }
 
+    const localPath = `${this.soundBoardFolder}/${boardName}/${localFile}`;
+    const instance = this;
+
+    // the esp knows the crc32 and the size of what was uploaded, the same sound is not sent again
+    // size is what the esp stored after dropping tags and silence, it is never the size of the local file
+    this.request.get(this.espManifestUrl, (err, resp, body) => {
+      if(err === null && resp.statusCode === 200) {
+        const espFile = JSON.parse(body).find(file => file.name === `/${espBtnNr}.mp3`);
+        const localData = instance.fs.readFileSync(localPath);
+        const localHash = instance.crc32(localData);
+        if(espFile !== undefined && espFile.uploadSize === localData.length && espFile.hash === localHash) {
+          instance.logInfo(`File: ${localFile} is already on the esp with crc32: ${localHash}, not uploading it.`);
+          callBack();
+          return;
+        }
+      }
+
+      instance.postFileToEsp(localPath, espBtnNr, callBack);
+    });
+  }
+
+  /**
+   * Posts the file to the upload of the esp
+   * @param localFile
+   * @param espBtnNr
+   * @param callBack
+   */
+  postFileToEsp(localFile, espBtnNr, callBack) {
     this.logInfo(`Uploading file: ${localFile} to: ${this.espUploadUrl}`);
 
     const instance = this;
@@ -162,7 +191,7 @@ class LocalFileHandler extends BaseClass {
     });
 
     const form = req.form();
-    form.append('file', this.fs.createReadStream(`${this.soundBoardFolder}/${boardName}/${localFile}`), {
+    form.append('file', this.fs.createReadStream(localFile), {
       filename: `${espBtnNr}.mp3`,
       contentType: 'audio/mp3'
     });
@@ -170,6 +199,29 @@ class LocalFileHandler extends BaseClass {
 
   }
 
+  /**
+   * The crc32 of the data as the esp computes it while the upload comes in, as 8 hex digits
+   * @param data
+   */
+  crc32(data) {
+    if(this.crc32Table === undefined) {
+      this.crc32Table = [];
+      for(let n = 0; n < 256; n++) {
+        let c = n;
+        for(let k = 0; k < 8; k++) {
+          c = (c & 1) ? (0xEDB88320 ^ (c >>> 1)) : (c >>> 1);
+        }
+        this.crc32Table.push(c >>> 0);
+      }
+    }
+
+    let crc = 0xFFFFFFFF;
+    for(let i = 0; i < data.length; i++) {
+      crc = this.crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >>> 8);
+    }
+    return ((crc ^ 0xFFFFFFFF) >>> 0).toString(16).padStart(8, '0');
+  }
+
   /**
    * Tries to locate the current file for the given board name and esp btn nr.
    * @param boardName
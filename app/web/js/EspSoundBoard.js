@@ -13,6 +13,10 @@ class EspSoundBoard {
 
     this.esp32Config = {};
 
+    // the events of the esp32 and the sound it plays
+    this.esp32Events = null;
+    this.esp32PlayingSound = -1;
+
     // the currently selected soundboard
     this.currentSoundboard = null;
 
@@ -55,8 +59,8 @@ class EspSoundBoard {
 
       instance.currentSoundboard = instance.config.soundBoards.find(board => board.name === $('#boardSelector').val());
 
-      // load the infos from the board
-      instance._readInfoFromEsp32();
+      // the board tells when its files changed, then the infos are loaded
+      instance._listenToEsp32Events();
     });
   }
 
@@ -106,6 +110,39 @@ class EspSoundBoard {
     this.mp3Player.playUrl(`prelisten?url=${currentVal}`);
   }
 
+  /**
+   * Listens to the events of the esp32 instead of polling it
+   * @private
+   */
+  _listenToEsp32Events() {
+
+    const instance = this;
+    if(instance.esp32Events !== null) {
+      instance.esp32Events.close();
+    }
+
+    instance.esp32Events = new EventSource(`http://${instance.config.config.esp32Ip}/events`);
+
+    // the files changed, also sent when the connection is opened
+    instance.esp32Events.addEventListener('files', () => {
+      instance._readInfoFromEsp32();
+    });
+
+    instance.esp32Events.addEventListener('sound', (event) => {
+      instance.esp32PlayingSound = JSON.parse(event.data).sound;
+      instance._markPlayingSound();
+    });
+  }
+
+  /**
+   * Marks the row of the sound the esp32 plays
+   * @private
+   */
+  _markPlayingSound() {
+    $('#soundButtons tr').removeClass('teal lighten-4');
+    $(`#soundButtons tr[data-esp-btn="${this.esp32PlayingSound}"]`).addClass('teal lighten-4');
+  }
+
   /**
    * Reads the info data from the esp32
    * @private
@@ -130,7 +167,7 @@ class EspSoundBoard {
     this.config.config.buttonsMapping.forEach(mapping => {
 
 
-      const rowHtml = $(`<tr></tr>`);
+      const rowHtml = $(`<tr data-esp-btn="${mapping.espBtn}"></tr>`);
 
 
       rowHtml.append($(`<td><strong>${mapping.name}</strong></td>`));
@@ -166,6 +203,8 @@ class EspSoundBoard {
 
       $('#soundButtons').append(rowHtml);
     });
+
+    this._markPlayingSound();
   }
 
   /**
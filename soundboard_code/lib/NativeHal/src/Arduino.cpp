@@ -0,0 +1,383 @@
+#include <ctype.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ### time ###
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+  return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ### logging ###
+
+static std::mutex logMutex;
+
+void nativeLog(char level, const char* tag, const char* format, ...) {
+  va_list args;
+  std::lock_guard<std::mutex> lock(logMutex);
+
+  fprintf(stderr, "[%c][%s] ", level, tag);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+// ### gpio ###
+
+struct nativePin_struct {
+  uint8_t level;
+  int mode;                                     // Interrupt mode, 0 = none
+  void (*handler)(void*);
+  void* arg;
+};
+
+static nativePin_struct pins[NATIVE_GPIO_COUNT];
+static std::mutex pinMutex;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NATIVE_GPIO_COUNT) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(pinMutex);
+  if ((mode & PULLUP) == PULLUP) {
+    pins[pin].level = HIGH;
+  } else if ((mode & PULLDOWN) == PULLDOWN) {
+    pins[pin].level = LOW;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= NATIVE_GPIO_COUNT) {
+    return LOW;
+  }
+  std::lock_guard<std::mutex> lock(pinMutex);
+  return pins[pin].level;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  nativeSetPin(pin, val);
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+  if (pin >= NATIVE_GPIO_COUNT) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(pinMutex);
+  pins[pin].handler = handler;
+  pins[pin].arg = arg;
+  pins[pin].mode = mode;
+}
+
+/**
+   Changes the level of a pin and runs its interrupt handler like the esp32 would on the edge
+*/
+void nativeSetPin(uint8_t pin, uint8_t level) {
+  if (pin >= NATIVE_GPIO_COUNT) {
+    return;
+  }
+
+  void (*handler)(void*) = NULL;
+  void* arg = NULL;
+  {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    nativePin_struct &p = pins[pin];
+    level = level ? HIGH : LOW;
+    if (p.level != level && p.handler != NULL &&
+        (((p.mode & RISING) && level == HIGH) || ((p.mode & FALLING) && level == LOW))) {
+      handler = p.handler;
+      arg = p.arg;
+    }
+    p.level = level;
+  }
+
+  if (handler != NULL) {
+    handler(arg);
+  }
+}
+
+void ledcSetup(uint8_t, double, uint8_t) {
+}
+
+void ledcAttachPin(uint8_t, uint8_t) {
+}
+
+void ledcWrite(uint8_t, uint32_t) {
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ### String ###
+
+static std::string numberToString(unsigned long long value, unsigned char base, bool negative) {
+  char buf[66];
+  char* p = buf + sizeof(buf) - 1;
+
+  if (base < 2) {
+    base = 10;
+  }
+  *p = 0;
+  do {
+    uint8_t digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) {
+    *--p = '-';
+  }
+  return std::string(p);
+}
+
+static std::string signedToString(long long value, unsigned char base) {
+  if (base == 10 && value < 0) {
+    return numberToString(0ULL - (unsigned long long) value, base, true);
+  }
+  return numberToString((unsigned long long) value, base, false);
+}
+
+String::String(const char* cstr) : _buffer(cstr ? cstr : "") {}
+String::String(const String &str) : _buffer(str._buffer) {}
+String::String(const std::string &str) : _buffer(str) {}
+String::String(int value, unsigned char base) : _buffer(signedToString(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buffer(numberToString(value, base, false)) {}
+
+String &String::operator=(const String &rhs) {
+  _buffer = rhs._buffer;
+  return *this;
+}
+
+String &String::operator=(const char* cstr) {
+  _buffer = cstr ? cstr : "";
+  return *this;
+}
+
+bool String::concat(const String &str) {
+  _buffer += str._buffer;
+  return true;
+}
+
+bool String::concat(const char* cstr) {
+  if (cstr == NULL) {
+    return false;
+  }
+  _buffer += cstr;
+  return true;
+}
+
+bool String::concat(char c) {
+  _buffer += c;
+  return true;
+}
+
+bool String::equals(const String &s) const {
+  return _buffer == s._buffer;
+}
+
+bool String::equals(const char* cstr) const {
+  return _buffer == (cstr ? cstr : "");
+}
+
+bool String::startsWith(const String &prefix) const {
+  return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const {
+  return offset <= _buffer.length() && _buffer.compare(offset, prefix._buffer.length(), prefix._buffer) == 0 &&
+         offset + prefix._buffer.length() <= _buffer.length();
+}
+
+bool String::endsWith(const String &suffix) const {
+  return _buffer.length() >= suffix._buffer.length() &&
+         _buffer.compare(_buffer.length() - suffix._buffer.length(), suffix._buffer.length(), suffix._buffer) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return index < _buffer.length() ? _buffer[index] : 0;
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= _buffer.length()) {
+    dummy = 0;
+    return dummy;
+  }
+  return _buffer[index];
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    unsigned int temp = endIndex;
+    endIndex = beginIndex;
+    beginIndex = temp;
+  }
+  if (beginIndex >= _buffer.length()) {
+    return String();
+  }
+  if (endIndex > _buffer.length()) {
+    endIndex = _buffer.length();
+  }
+  return String(_buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < _buffer.length()) {
+    _buffer.erase(index, count);
+  }
+}
+
+String operator+(const String &lhs, const char* rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const char* lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+// ### Print ###
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char small[64];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(small, sizeof(small), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  if ((size_t) len < sizeof(small)) {
+    return write((const uint8_t*) small, len);
+  }
+
+  std::string big(len + 1, '\0');
+  va_start(args, format);
+  vsnprintf(&big[0], big.size(), format, args);
+  va_end(args);
+  return write((const uint8_t*) big.data(), len);
+}
+
+size_t Print::print(const String &s) {
+  return write((const uint8_t*) s.c_str(), s.length());
+}
+
+size_t Print::print(const char* str) {
+  return write(str);
+}
+
+size_t Print::print(int num, int base) {
+  return print(String(num, base));
+}
+
+size_t Print::print(unsigned int num, int base) {
+  return print(String(num, base));
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+// ### Serial ###
+
+void HardwareSerial::begin(unsigned long) {
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::available() {
+  return 0;
+}
+
+int HardwareSerial::read() {
+  return -1;
+}
+
+int HardwareSerial::peek() {
+  return -1;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+// ### ESP ###
+
+// the heap the firmware took since the first call, counted against NATIVE_HEAP_SIZE
+static uint32_t nativeHeapUsed() {
+  static const size_t base = mallinfo2().uordblks;
+  size_t used = mallinfo2().uordblks;
+  return used > base ? used - base : 0;
+}
+
+static uint32_t nativeMinFreeHeap = NATIVE_HEAP_SIZE;
+
+uint32_t EspClass::getFreeHeap() {
+  uint32_t used = nativeHeapUsed();
+  uint32_t free = used < NATIVE_HEAP_SIZE ? NATIVE_HEAP_SIZE - used : 0;
+  if (free < nativeMinFreeHeap) {
+    nativeMinFreeHeap = free;
+  }
+  return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  getFreeHeap();
+  return nativeMinFreeHeap;
+}
+
+// glibc does not fragment like the esp32 heap, the free heap is one block
+uint32_t EspClass::getMaxAllocHeap() {
+  return getFreeHeap();
+}
+
+uint32_t EspClass::getFlashChipSize() {
+  return 4 * 1024 * 1024;
+}
+
+uint64_t EspClass::getEfuseMac() {
+  return 0x0000AABBCCDDEEFFULL;
+}
+
+void EspClass::restart() {
+  ESP_LOGI("Native", "Restart requested, exiting");
+  fflush(stdout);
+  exit(0);
+}
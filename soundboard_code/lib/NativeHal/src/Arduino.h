@@ -0,0 +1,228 @@
+/**
+   Linux stand-in for the parts of the arduino-esp32 core the soundboard uses.
+   Only built in the native environment, on the esp32 the real core is used.
+*/
+#ifndef NATIVE_ARDUINO_h
+#define NATIVE_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x02
+#define PULLUP         0x04
+#define INPUT_PULLUP   0x05
+#define PULLDOWN       0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define IRAM_ATTR
+#define NOP() asm volatile ("nop")
+#define _BV(b) (1UL << (b))
+#define _min(a,b) ((a)<(b)?(a):(b))
+#define _max(a,b) ((a)>(b)?(a):(b))
+#define digitalPinToInterrupt(p) (p)
+
+// logging like esp-log, the level comes from CORE_DEBUG_LEVEL
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL 3
+#endif
+#define ARDUHAL_LOG_LEVEL_NONE    0
+#define ARDUHAL_LOG_LEVEL_ERROR   1
+#define ARDUHAL_LOG_LEVEL_WARN    2
+#define ARDUHAL_LOG_LEVEL_INFO    3
+#define ARDUHAL_LOG_LEVEL_DEBUG   4
+#define ARDUHAL_LOG_LEVEL_VERBOSE 5
+
+void nativeLog(char level, const char* tag, const char* format, ...);
+
+#define ESP_LOG_LEVEL_(lvl, ch, tag, ...) do { if (CORE_DEBUG_LEVEL >= lvl) nativeLog(ch, tag, __VA_ARGS__); } while (0)
+#define ESP_LOGE(tag, ...) ESP_LOG_LEVEL_(ARDUHAL_LOG_LEVEL_ERROR, 'E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_LEVEL_(ARDUHAL_LOG_LEVEL_WARN, 'W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_LEVEL_(ARDUHAL_LOG_LEVEL_INFO, 'I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_LEVEL_(ARDUHAL_LOG_LEVEL_DEBUG, 'D', tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_LEVEL_(ARDUHAL_LOG_LEVEL_VERBOSE, 'V', tag, __VA_ARGS__)
+
+// time, wraps after 32 bit like on the esp32
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+// gpio, the levels only live in memory, NativeHal.h changes them from the outside
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+
+// led pwm does nothing
+void ledcSetup(uint8_t channel, double freq, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+/**
+   Arduino String on top of std::string
+*/
+class String {
+  public:
+    String(const char* cstr = "");
+    String(const String &str);
+    String(const std::string &str);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+
+    String &operator=(const String &rhs);
+    String &operator=(const char* cstr);
+
+    inline unsigned int length() const {
+      return _buffer.length();
+    }
+    inline const char* c_str() const {
+      return _buffer.c_str();
+    }
+
+    bool concat(const String &str);
+    bool concat(const char* cstr);
+    bool concat(char c);
+
+    template <typename T> String &operator+=(const T &rhs) {
+      concat(rhs);
+      return *this;
+    }
+
+    bool equals(const String &s) const;
+    bool equals(const char* cstr) const;
+    bool operator==(const String &rhs) const {
+      return equals(rhs);
+    }
+    bool operator==(const char* cstr) const {
+      return equals(cstr);
+    }
+    bool operator!=(const String &rhs) const {
+      return !equals(rhs);
+    }
+    bool operator!=(const char* cstr) const {
+      return !equals(cstr);
+    }
+    bool startsWith(const String &prefix) const;
+    bool startsWith(const String &prefix, unsigned int offset) const;
+    bool endsWith(const String &suffix) const;
+
+    char charAt(unsigned int index) const;
+    char &operator[](unsigned int index);
+
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void remove(unsigned int index, unsigned int count);
+
+  private:
+    std::string _buffer;
+};
+
+String operator+(const String &lhs, const char* rhs);
+String operator+(const char* lhs, const String &rhs);
+
+/**
+   Base of everything that prints
+*/
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) {
+      return str == NULL ? 0 : write((const uint8_t*) str, strlen(str));
+    }
+    size_t write(const char* buffer, size_t size) {
+      return write((const uint8_t*) buffer, size);
+    }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...);
+
+    size_t print(const String &s);
+    size_t print(const char* str);
+    size_t print(int num, int base = DEC);
+    size_t print(unsigned int num, int base = DEC);
+
+    size_t println();
+    template <typename T> size_t println(const T &value) {
+      size_t n = print(value);
+      return n + println();
+    }
+    template <typename T> size_t println(const T &value, int base) {
+      size_t n = print(value, base);
+      return n + println();
+    }
+};
+
+/**
+   Something that can be read from
+*/
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/**
+   Serial prints on stdout, stdin belongs to NativeMain
+*/
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long baud);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+/**
+   Chip information, the host has no limits worth reporting
+*/
+class EspClass {
+  public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getFlashChipSize();
+    uint64_t getEfuseMac();
+    void restart();
+};
+
+extern EspClass ESP;
+
+// the sketch
+void setup();
+void loop();
+
+#endif
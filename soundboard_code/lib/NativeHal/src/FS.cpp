@@ -0,0 +1,224 @@
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "FS.h"
+#include "SPIFFS.h"
+#include "NativeHal.h"
+
+fs::SPIFFSFS SPIFFS;
+
+static std::string dataDir = "data";
+
+void nativeSetDataDir(const char* dir) {
+  dataDir = dir;
+}
+
+const char* nativeDataDir() {
+  return dataDir.c_str();
+}
+
+namespace fs {
+
+/**
+   An open file or directory of the host
+*/
+struct FileImpl {
+  FILE* fp = NULL;
+  std::string path;                              // Name on the esp32, starts with /
+  bool dir = false;
+  std::vector<std::string> entries;              // Files in the directory
+  size_t next = 0;
+
+  ~FileImpl() {
+    if (fp != NULL) {
+      fclose(fp);
+    }
+  }
+};
+
+static std::string hostPath(const char* path) {
+  std::string p = path ? path : "";
+  if (p.empty() || p[0] != '/') {
+    p = "/" + p;
+  }
+  return dataDir + p;
+}
+
+static bool isHostDir(const std::string &hostPath) {
+  struct stat st;
+  return stat(hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// spiffs has no directories, a / in the name is just a character
+static void makeParents(const std::string &hostPath) {
+  for (size_t pos = dataDir.length() + 1; (pos = hostPath.find('/', pos)) != std::string::npos; pos++) {
+    ::mkdir(hostPath.substr(0, pos).c_str(), 0755);
+  }
+}
+
+static void listFiles(const std::string &path, std::vector<std::string> &entries) {
+  DIR* dir = opendir(hostPath(path.c_str()).c_str());
+  if (dir == NULL) {
+    return;
+  }
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    std::string child = (path == "/" ? "" : path) + "/" + name;
+    if (isHostDir(hostPath(child.c_str()))) {
+      listFiles(child, entries);
+    } else {
+      entries.push_back(child);
+    }
+  }
+  closedir(dir);
+}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!_p || _p->fp == NULL) {
+    return 0;
+  }
+  return fwrite(buf, 1, size, _p->fp);
+}
+
+int File::available() {
+  if (!_p || _p->fp == NULL) {
+    return 0;
+  }
+  return size() - position();
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!_p || _p->fp == NULL) {
+    return -1;
+  }
+  int c = fgetc(_p->fp);
+  if (c != EOF) {
+    ungetc(c, _p->fp);
+  }
+  return c == EOF ? -1 : c;
+}
+
+void File::flush() {
+  if (_p && _p->fp != NULL) {
+    fflush(_p->fp);
+  }
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!_p || _p->fp == NULL) {
+    return 0;
+  }
+  return fread(buf, 1, size, _p->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_p || _p->fp == NULL) {
+    return false;
+  }
+  int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+  return fseek(_p->fp, pos, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!_p || _p->fp == NULL) {
+    return 0;
+  }
+  return ftell(_p->fp);
+}
+
+size_t File::size() const {
+  struct stat st;
+  if (!_p || _p->fp == NULL) {
+    return 0;
+  }
+  fflush(_p->fp);
+  return fstat(fileno(_p->fp), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close() {
+  _p.reset();
+}
+
+File::operator bool() const {
+  return _p && (_p->fp != NULL || _p->dir);
+}
+
+const char* File::name() const {
+  return _p ? _p->path.c_str() : NULL;
+}
+
+File File::openNextFile(const char* mode) {
+  if (!_p || !_p->dir || _p->next >= _p->entries.size()) {
+    return File();
+  }
+  return SPIFFS.open(_p->entries[_p->next++].c_str(), mode);
+}
+
+File FS::open(const char* path, const char* mode) {
+  std::string host = hostPath(path);
+  FileImplPtr p = std::make_shared<FileImpl>();
+  p->path = host.substr(dataDir.length());
+
+  if (mode[0] == 'r' && isHostDir(host)) {
+    p->dir = true;
+    listFiles(p->path, p->entries);
+    return File(p);
+  }
+
+  std::string hostMode = mode;
+  hostMode += "b";
+  if (mode[0] != 'r') {
+    makeParents(host);
+  }
+  p->fp = fopen(host.c_str(), hostMode.c_str());
+  if (p->fp == NULL) {
+    return File();
+  }
+  return File(p);
+}
+
+bool FS::exists(const char* path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+  std::string to = hostPath(pathTo);
+  makeParents(to);
+  return ::rename(hostPath(pathFrom).c_str(), to.c_str()) == 0;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char*, uint8_t) {
+  if (isHostDir(dataDir)) {
+    return true;
+  }
+  if (!formatOnFail) {
+    return false;
+  }
+  return ::mkdir(dataDir.c_str(), 0755) == 0;
+}
+
+}
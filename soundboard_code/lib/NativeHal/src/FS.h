@@ -0,0 +1,93 @@
+/**
+   Linux stand-in for the esp32 file system classes, the files live in a directory of the host.
+*/
+#ifndef NATIVE_FS_h
+#define NATIVE_FS_h
+
+#include <memory>
+
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+struct FileImpl;
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+/**
+   Copies share the same open file like on the esp32
+*/
+class File : public Stream {
+  public:
+    File(FileImplPtr p = FileImplPtr()) : _p(p) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t* buf, size_t size);
+    size_t readBytes(char* buffer, size_t length) {
+      return read((uint8_t*) buffer, length);
+    }
+
+    bool seek(uint32_t pos, SeekMode mode);
+    bool seek(uint32_t pos) {
+      return seek(pos, SeekSet);
+    }
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+    const char* name() const;
+
+    File openNextFile(const char* mode = FILE_READ);
+
+  private:
+    FileImplPtr _p;
+};
+
+class FS {
+  public:
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String &path, const char* mode = FILE_READ) {
+      return open(path.c_str(), mode);
+    }
+
+    bool exists(const char* path);
+    bool exists(const String &path) {
+      return exists(path.c_str());
+    }
+
+    bool remove(const char* path);
+    bool remove(const String &path) {
+      return remove(path.c_str());
+    }
+
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool rename(const String &pathFrom, const String &pathTo) {
+      return rename(pathFrom.c_str(), pathTo.c_str());
+    }
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
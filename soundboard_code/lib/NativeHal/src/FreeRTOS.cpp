@@ -0,0 +1,227 @@
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+   A thread with the notification value of a FreeRTOS task
+*/
+struct nativeTask {
+  std::string name;
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint32_t notifyValue = 0;
+  bool notifyPending = false;
+};
+
+/**
+   Items are copied in and out like in FreeRTOS, an item size of 0 makes it a semaphore
+   The storage is taken when the queue is created, sending and receiving do not use the heap
+*/
+struct nativeQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<uint8_t> storage;                 // Ring of length items
+  UBaseType_t first;                            // Index of the oldest item
+  UBaseType_t count;                            // Items waiting
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+static thread_local nativeTask* currentTask = NULL;
+
+/**
+   Waits on the condition until pred() is true, portMAX_DELAY waits forever
+*/
+template <typename Pred>
+static bool waitTicks(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred);
+}
+
+// ### tasks ###
+
+BaseType_t xTaskCreatePinnedToCore(void (*code)(void*), const char* name, uint32_t, void* parameter,
+                                   UBaseType_t, TaskHandle_t* created, BaseType_t) {
+  nativeTask* task = new nativeTask();
+  task->name = name ? name : "";
+  if (created != NULL) {
+    *created = task;
+  }
+
+  std::thread([task, code, parameter]() {
+    currentTask = task;
+    code(parameter);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  // threads which were not created as task, like the one running setup() and loop()
+  if (currentTask == NULL) {
+    currentTask = new nativeTask();
+    currentTask->name = "thread";
+  }
+  return currentTask;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+// ### task notifications ###
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  if (task == NULL) {
+    return pdFAIL;
+  }
+
+  std::lock_guard<std::mutex> lock(task->mutex);
+  switch (action) {
+    case eSetBits:
+      task->notifyValue |= value;
+      break;
+    case eIncrement:
+      task->notifyValue++;
+      break;
+    case eSetValueWithOverwrite:
+      task->notifyValue = value;
+      break;
+    case eSetValueWithoutOverwrite:
+      if (task->notifyPending) {
+        return pdFAIL;
+      }
+      task->notifyValue = value;
+      break;
+    default:
+      break;
+  }
+  task->notifyPending = true;
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* woken) {
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks) {
+  nativeTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+
+  if (!task->notifyPending) {
+    task->notifyValue &= ~clearOnEntry;
+  }
+  if (!waitTicks(task->cv, lock, ticks, [task]() {
+    return task->notifyPending;
+  })) {
+    if (value != NULL) {
+      *value = task->notifyValue;
+    }
+    return pdFALSE;
+  }
+
+  if (value != NULL) {
+    *value = task->notifyValue;
+  }
+  task->notifyValue &= ~clearOnExit;
+  task->notifyPending = false;
+  return pdTRUE;
+}
+
+// ### queues ###
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  nativeQueue* queue = new nativeQueue();
+  queue->storage.resize(length * itemSize);
+  queue->first = 0;
+  queue->count = 0;
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+
+  if (!waitTicks(queue->cv, lock, ticks, [queue]() {
+    return queue->count < queue->length;
+  })) {
+    return errQUEUE_FULL;
+  }
+
+  if (queue->itemSize) {
+    UBaseType_t last = (queue->first + queue->count) % queue->length;
+    memcpy(&queue->storage[last * queue->itemSize], item, queue->itemSize);
+  }
+  queue->count++;
+  queue->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  return queueSend(queue, item, ticks);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return queueSend(queue, item, 0);
+}
+
+static BaseType_t queueReceive(QueueHandle_t queue, void* item, TickType_t ticks, bool remove) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+
+  if (!waitTicks(queue->cv, lock, ticks, [queue]() {
+    return queue->count > 0;
+  })) {
+    return errQUEUE_EMPTY;
+  }
+
+  if (queue->itemSize && item != NULL) {
+    memcpy(item, &queue->storage[queue->first * queue->itemSize], queue->itemSize);
+  }
+  if (remove) {
+    queue->first = (queue->first + 1) % queue->length;
+    queue->count--;
+    queue->cv.notify_all();
+  }
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+  return queueReceive(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+  return queueReceive(queue, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->count;
+}
+
+// ### semaphores ###
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t sem = xQueueCreate(1, 0);
+  xQueueSend(sem, NULL, 0);
+  return sem;
+}
@@ -0,0 +1,32 @@
+/**
+   Hooks of the native environment which the esp32 does not have.
+   The firmware does not use them, NativeMain.cpp does.
+*/
+#ifndef NATIVEHAL_h
+#define NATIVEHAL_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NATIVE_GPIO_COUNT 40                     // Pins like the esp32
+#define NATIVE_HEAP_SIZE (160 * 1024)            // Heap of ESP.getFreeHeap(), less what the firmware allocated
+
+// Sets a pin from the outside, runs its interrupt handler on a matching edge
+void nativeSetPin(uint8_t pin, uint8_t level);
+
+// Gets every byte clocked out on the SPI bus, so tests can check what a driver sends, NULL = none
+typedef void (*nativeSpiTap_t)(const uint8_t* data, size_t len);
+void nativeSetSpiTap(nativeSpiTap_t tap);
+
+// Directory which holds the SPIFFS files, "data" by default
+void nativeSetDataDir(const char* dir);
+const char* nativeDataDir();
+
+// Added to the ports of WiFiServer, ports below 1024 need root on linux
+void nativeSetPortOffset(uint16_t offset);
+uint16_t nativePortOffset();
+
+// Send buffer of the sockets WiFiServer accepts, small like the one of lwip, 0 keeps the size of the host
+void nativeSetSendBuffer(int bytes);
+
+#endif
@@ -0,0 +1,40 @@
+#include <stddef.h>
+
+/**
+   The esp32 build wraps malloc with -Wl,--wrap, which on the host would miss the calls from the
+   shared libraries like libstdc++. So here malloc itself is replaced, the executable comes first
+   for every library, and passed on to the wrappers of the firmware. glibc only.
+*/
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+
+  void* __wrap_malloc(size_t size);
+  void* __wrap_calloc(size_t count, size_t size);
+  void* __wrap_realloc(void* ptr, size_t size);
+
+  void* __real_malloc(size_t size) {
+    return __libc_malloc(size);
+  }
+
+  void* __real_calloc(size_t count, size_t size) {
+    return __libc_calloc(count, size);
+  }
+
+  void* __real_realloc(void* ptr, size_t size) {
+    return __libc_realloc(ptr, size);
+  }
+
+  void* malloc(size_t size) {
+    return __wrap_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) {
+    return __wrap_calloc(count, size);
+  }
+
+  void* realloc(void* ptr, size_t size) {
+    return __wrap_realloc(ptr, size);
+  }
+}
@@ -0,0 +1,64 @@
+/**
+   Runs the firmware on linux: setup() once, then loop() like the arduino loop task.
+   Lines on stdin change the gpio levels, so the buttons can be pushed from the console:
+     "<gpio>"       push and release the button on that pin
+     "<gpio> down"  hold it
+     "<gpio> up"    release it
+   Options:
+     --data <dir>          directory with the SPIFFS files, default "data"
+     --port-offset <n>     added to the server ports, default 8000 so port 80 becomes 8080
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+
+// the test runner brings its own main()
+#ifndef UNIT_TEST
+
+#define NATIVE_BUTTON_PUSH_MS 100               // How long a button is pushed for "<gpio>"
+
+static void consoleTask() {
+  char line[64];
+
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    char* end;
+    long pin = strtol(line, &end, 10);
+    if (end == line || pin < 0 || pin >= NATIVE_GPIO_COUNT) {
+      continue;
+    }
+
+    if (strstr(end, "down") != NULL) {
+      nativeSetPin(pin, LOW);
+    } else if (strstr(end, "up") != NULL) {
+      nativeSetPin(pin, HIGH);
+    } else {
+      nativeSetPin(pin, LOW);
+      delay(NATIVE_BUTTON_PUSH_MS);
+      nativeSetPin(pin, HIGH);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--data") == 0) {
+      nativeSetDataDir(argv[i + 1]);
+    } else if (strcmp(argv[i], "--port-offset") == 0) {
+      nativeSetPortOffset(atoi(argv[i + 1]));
+    }
+  }
+
+  setup();
+  std::thread(consoleTask).detach();
+
+  for (;;) {
+    loop();
+    // the esp32 loop task spins, on the host a short sleep keeps a core free
+    delay(1);
+  }
+  return 0;
+}
+#endif
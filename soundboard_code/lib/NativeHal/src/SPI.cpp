@@ -0,0 +1,51 @@
+#include "SPI.h"
+#include "NativeHal.h"
+
+SPIClass SPI;
+
+static nativeSpiTap_t spiTap = NULL;
+
+void nativeSetSpiTap(nativeSpiTap_t tap) {
+  spiTap = tap;
+}
+
+static void clockOut(const uint8_t* data, size_t len) {
+  if (spiTap != NULL && data != NULL) {
+    spiTap(data, len);
+  }
+}
+
+void SPIClass::begin(int8_t, int8_t, int8_t, int8_t) {
+}
+
+void SPIClass::beginTransaction(SPISettings) {
+}
+
+void SPIClass::endTransaction() {
+}
+
+/**
+   Nothing answers, the lines float high
+*/
+uint8_t SPIClass::transfer(uint8_t data) {
+  bytes++;
+  clockOut(&data, 1);
+  return 0xFF;
+}
+
+void SPIClass::write(uint8_t data) {
+  bytes++;
+  clockOut(&data, 1);
+}
+
+// the most significant byte goes out first, like with MSBFIRST on the esp32
+void SPIClass::write16(uint16_t data) {
+  uint8_t out[2] = {(uint8_t) (data >> 8), (uint8_t) data};
+  bytes += 2;
+  clockOut(out, sizeof(out));
+}
+
+void SPIClass::writeBytes(const uint8_t* data, uint32_t size) {
+  bytes += size;
+  clockOut(data, size);
+}
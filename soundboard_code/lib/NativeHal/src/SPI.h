@@ -0,0 +1,45 @@
+/**
+   Linux stand-in for the esp32 SPI bus, nothing is connected to it.
+   The native environment plays through Vs1053Sim, not over this bus, tests can watch the bytes
+   clocked out with nativeSetSpiTap().
+*/
+#ifndef NATIVE_SPI_h
+#define NATIVE_SPI_h
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define SPI_LSBFIRST 0
+#define SPI_MSBFIRST 1
+#define LSBFIRST SPI_LSBFIRST
+#define MSBFIRST SPI_MSBFIRST
+
+class SPISettings {
+  public:
+    SPISettings() : _clock(1000000), _bitOrder(SPI_MSBFIRST), _dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+    uint32_t _clock;
+    uint8_t _bitOrder;
+    uint8_t _dataMode;
+};
+
+class SPIClass {
+  public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void beginTransaction(SPISettings settings);
+    void endTransaction();
+
+    uint8_t transfer(uint8_t data);
+    void write(uint8_t data);
+    void write16(uint16_t data);
+    void writeBytes(const uint8_t* data, uint32_t size);
+
+    uint32_t bytes = 0;                          // Bytes clocked out
+};
+
+extern SPIClass SPI;
+
+#endif
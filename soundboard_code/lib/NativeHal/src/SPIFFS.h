@@ -0,0 +1,20 @@
+/**
+   Linux stand-in for SPIFFS, the files live in nativeDataDir().
+*/
+#ifndef NATIVE_SPIFFS_h
+#define NATIVE_SPIFFS_h
+
+#include "FS.h"
+
+namespace fs {
+
+class SPIFFSFS : public FS {
+  public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10);
+};
+
+}
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,40 @@
+/**
+   Linux stand-in for the StreamString of the arduino-esp32 core, a String that can be printed to.
+*/
+#ifndef NATIVE_STREAMSTRING_h
+#define NATIVE_STREAMSTRING_h
+
+#include "Arduino.h"
+
+class StreamString : public Stream, public String {
+  public:
+    size_t write(const uint8_t* data, size_t size) override {
+      for (size_t i = 0; i < size; i++) {
+        concat((char) data[i]);
+      }
+      return size;
+    }
+    size_t write(uint8_t data) override {
+      return concat((char) data) ? 1 : 0;
+    }
+    using Print::write;
+
+    int available() override {
+      return length();
+    }
+    int read() override {
+      if (length() == 0) {
+        return -1;
+      }
+      char c = charAt(0);
+      remove(0, 1);
+      return (uint8_t) c;
+    }
+    int peek() override {
+      return length() == 0 ? -1 : (uint8_t) charAt(0);
+    }
+    void flush() override {
+    }
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "WiFi.h"
+#include "NativeHal.h"
+
+WiFiClass WiFi;
+
+#define NATIVE_WRITE_TIMEOUT_MS 1000             // A write gives up when the peer takes nothing for this long
+
+static uint16_t portOffset = 8000;
+static int sendBuffer = 0;
+
+void nativeSetPortOffset(uint16_t offset) {
+  portOffset = offset;
+}
+
+uint16_t nativePortOffset() {
+  return portOffset;
+}
+
+void nativeSetSendBuffer(int bytes) {
+  sendBuffer = bytes;
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+  return String(buf);
+}
+
+// ### WiFi ###
+
+bool WiFiClass::enableSTA(bool enable) {
+  _sta = enable;
+  if (!enable) {
+    _connected = false;
+  }
+  return true;
+}
+
+bool WiFiClass::enableAP(bool) {
+  return true;
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*) {
+  _sta = true;
+  _connected = true;
+  return WL_CONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+  return _connected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::softAP(const char*, const char*) {
+  return true;
+}
+
+IPAddress WiFiClass::localIP() {
+  return IPAddress(127, 0, 0, 1);
+}
+
+String WiFiClass::macAddress() {
+  return String("02:00:00:00:00:01");
+}
+
+// ### WiFiClient ###
+
+struct nativeSocket {
+  int fd;
+  explicit nativeSocket(int f) : fd(f) {}
+  ~nativeSocket() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+WiFiClient::WiFiClient() {
+}
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<nativeSocket>(fd)) {
+}
+
+size_t WiFiClient::write(uint8_t data) {
+  return write(&data, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+  size_t sent = 0;
+
+  if (!_socket) {
+    return 0;
+  }
+  while (sent < size) {
+    ssize_t n = send(_socket->fd, buf + sent, size - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // like the esp32 the write waits for room and returns what was sent when the peer stopped reading
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      struct pollfd room = {_socket->fd, POLLOUT, 0};
+      if (poll(&room, 1, NATIVE_WRITE_TIMEOUT_MS) > 0) {
+        continue;
+      }
+      break;
+    }
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+  return sent;
+}
+
+int WiFiClient::available() {
+  int count = 0;
+  if (!_socket || ioctl(_socket->fd, FIONREAD, &count) != 0) {
+    return 0;
+  }
+  return count;
+}
+
+int WiFiClient::read() {
+  uint8_t data;
+  return read(&data, 1) == 1 ? data : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+  if (!_socket) {
+    return -1;
+  }
+  ssize_t n = recv(_socket->fd, buf, size, MSG_DONTWAIT);
+  return n > 0 ? (int) n : -1;
+}
+
+int WiFiClient::peek() {
+  uint8_t data;
+  if (!_socket || recv(_socket->fd, &data, 1, MSG_DONTWAIT | MSG_PEEK) != 1) {
+    return -1;
+  }
+  return data;
+}
+
+void WiFiClient::flush() {
+}
+
+void WiFiClient::stop() {
+  _socket.reset();
+}
+
+/**
+   Connected as long as the peer did not close or there is still data to read
+*/
+uint8_t WiFiClient::connected() {
+  uint8_t data;
+
+  if (!_socket) {
+    return 0;
+  }
+  ssize_t n = recv(_socket->fd, &data, 1, MSG_DONTWAIT | MSG_PEEK);
+  if (n > 0) {
+    return 1;
+  }
+  if (n == 0) {
+    return 0;
+  }
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+WiFiClient::operator bool() {
+  return connected();
+}
+
+int WiFiClient::setNoDelay(bool nodelay) {
+  int flag = nodelay;
+  return _socket ? setsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) : -1;
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (!_socket || getpeername(_socket->fd, (struct sockaddr*) &addr, &len) != 0) {
+    return IPAddress();
+  }
+  return IPAddress((uint32_t) addr.sin_addr.s_addr);
+}
+
+// ### WiFiServer ###
+
+void WiFiServer::begin(uint16_t port) {
+  struct sockaddr_in addr;
+  int on = 1;
+
+  if (port) {
+    _port = port;
+  }
+  end();
+
+  _fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (_fd < 0) {
+    return;
+  }
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(_port + portOffset);
+  addr.sin_addr.s_addr = INADDR_ANY;
+  if (bind(_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(_fd, _maxClients) != 0) {
+    ESP_LOGE("Native", "Could not listen on port %u: %s", _port + portOffset, strerror(errno));
+    end();
+    return;
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  ESP_LOGI("Native", "Listening on port %u", _port + portOffset);
+}
+
+WiFiClient WiFiServer::available() {
+  if (_fd < 0) {
+    return WiFiClient();
+  }
+  int fd = accept(_fd, NULL, NULL);
+  if (fd < 0) {
+    return WiFiClient();
+  }
+  if (sendBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+  }
+  return WiFiClient(fd);
+}
+
+void WiFiServer::end() {
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
@@ -0,0 +1,40 @@
+/**
+   Linux stand-in for the esp32 WiFi, the host is always connected and its address is 127.0.0.1
+*/
+#ifndef NATIVE_WIFI_h
+#define NATIVE_WIFI_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+  public:
+    bool enableSTA(bool enable);
+    bool enableAP(bool enable);
+    wl_status_t begin(const char* ssid, const char* passphrase = NULL);
+    wl_status_t status();
+    bool softAP(const char* ssid, const char* passphrase = NULL);
+    IPAddress localIP();
+    String macAddress();
+
+  private:
+    bool _sta = false;
+    bool _connected = false;
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,41 @@
+/**
+   Linux stand-in for the esp32 WiFiClient, a tcp socket of the host
+*/
+#ifndef NATIVE_WIFICLIENT_h
+#define NATIVE_WIFICLIENT_h
+
+#include <memory>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+struct nativeSocket;
+
+/**
+   Copies share the socket, it is closed with the last copy or stop()
+*/
+class WiFiClient : public Stream {
+  public:
+    WiFiClient();
+    explicit WiFiClient(int fd);
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size);
+    int peek() override;
+    void flush() override;
+    void stop();
+    uint8_t connected();
+
+    operator bool();
+    int setNoDelay(bool nodelay);
+    IPAddress remoteIP() const;
+
+  private:
+    std::shared_ptr<nativeSocket> _socket;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/**
+   Linux stand-in for the esp32 WiFiServer, listens on the port plus nativePortOffset()
+*/
+#ifndef NATIVE_WIFISERVER_h
+#define NATIVE_WIFISERVER_h
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+class WiFiServer {
+  public:
+    WiFiServer(uint16_t port = 80, uint8_t maxClients = 4) : _port(port), _maxClients(maxClients) {}
+    ~WiFiServer() {
+      end();
+    }
+
+    void begin(uint16_t port = 0);
+    WiFiClient available();
+    void end();
+    operator bool() {
+      return _fd >= 0;
+    }
+
+  private:
+    uint16_t _port;
+    uint8_t _maxClients;
+    int _fd = -1;
+};
+
+#endif
@@ -0,0 +1,14 @@
+/**
+   Linux stand-in for the lwip sockets of the esp32, both have the bsd socket api.
+   The ports are not shifted by nativePortOffset(), they are used as they are.
+*/
+#ifndef NATIVE_LWIP_SOCKETS_h
+#define NATIVE_LWIP_SOCKETS_h
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#endif
@@ -0,0 +1,24 @@
+/**
+   Runtime statistics of the board
+*/
+#ifndef BOARDSTATS_h
+#define BOARDSTATS_h
+
+#include "Arduino.h"
+
+// what the board is doing, pushed to the clients of /events
+struct boardStatus_struct {
+  int sound;                                           // number of the sound played last, -1 when none plays
+  bool streaming;                                      // the body of POST /stream plays
+  uint32_t freeHeap;
+  uint32_t minFreeHeap;
+  uint8_t queuePercent;                                // fill of the mp3 ring buffer
+};
+
+// Prints all runtime statistics as one json object, served at /stats and printed on the serial
+void printStats(Print &out);
+
+// Reads the status of the board, may be called from any task
+void readBoardStatus(boardStatus_struct &status);
+
+#endif
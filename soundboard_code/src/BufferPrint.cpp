@@ -0,0 +1,35 @@
+#include <stdarg.h>
+
+#include "BufferPrint.h"
+
+BufferPrint::BufferPrint(char* buffer, size_t size) {
+  _buffer = buffer;
+  _size = size;
+}
+
+size_t BufferPrint::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t BufferPrint::write(const uint8_t* data, size_t len) {
+  if (len > _size - _len) {
+    len = _size - _len;
+    _overflow = true;
+  }
+  memcpy(_buffer + _len, data, len);
+  _len += len;
+  return len;
+}
+
+size_t printFormatted(Print &out, const char* format, ...) {
+  char buffer[BUFFERPRINT_MAX_FORMAT + 1];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return out.write((const uint8_t*) buffer, (size_t) len < sizeof(buffer) ? len : sizeof(buffer) - 1);
+}
@@ -0,0 +1,49 @@
+/**
+   Prints into a fixed buffer instead of a String, so a response is formatted without the heap.
+   What does not fit is dropped.
+*/
+#ifndef BUFFERPRINT_h
+#define BUFFERPRINT_h
+
+#include "Arduino.h"
+
+#define BUFFERPRINT_MAX_FORMAT 160                         // Longer output of printFormatted() is cut
+
+class BufferPrint : public Print {
+
+  public:
+    /**
+       Constructor, prints into the given buffer of the given size
+    */
+    BufferPrint(char* buffer, size_t size);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+
+    // The printed text, not terminated
+    const char* data() const {
+      return _buffer;
+    }
+
+    // Bytes printed so far
+    size_t length() const {
+      return _len;
+    }
+
+    // Something did not fit
+    bool overflow() const {
+      return _overflow;
+    }
+
+  private:
+    char* _buffer;
+    size_t _size;
+    size_t _len = 0;
+    bool _overflow = false;
+};
+
+// Like Print::printf, which takes the heap for more than 63 characters, but with a buffer on the stack
+size_t printFormatted(Print &out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif
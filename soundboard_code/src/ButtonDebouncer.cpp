@@ -0,0 +1,56 @@
+#include "ButtonDebouncer.h"
+
+/**
+   Constuctor
+*/
+ButtonDebouncer::ButtonDebouncer(uint32_t debounceUs) {
+  _debounceUs = debounceUs;
+  for (uint8_t i = 0; i < BUTTON_MAX; i++) {
+    init(i, true, 0);
+  }
+}
+
+void ButtonDebouncer::init(uint8_t button, bool level, uint32_t nowUs) {
+  _buttons[button].stable = level;
+  _buttons[button].raw = level;
+  // the first edge must not be taken as bouncing
+  _buttons[button].lastChange = nowUs - _debounceUs;
+}
+
+buttonEvent_t ButtonDebouncer::edge(uint8_t button, bool level, uint32_t timeUs) {
+  buttonState &state = _buttons[button];
+  state.raw = level;
+
+  // still bouncing from the last change, poll() takes the final level
+  if ((uint32_t)(timeUs - state.lastChange) < _debounceUs) {
+    return BUTTON_NONE;
+  }
+
+  return accept(button, level, timeUs);
+}
+
+buttonEvent_t ButtonDebouncer::poll(uint8_t button, uint32_t nowUs) {
+  buttonState &state = _buttons[button];
+
+  if (!unsettled(button) || (uint32_t)(nowUs - state.lastChange) < _debounceUs) {
+    return BUTTON_NONE;
+  }
+
+  return accept(button, state.raw, nowUs);
+}
+
+bool ButtonDebouncer::unsettled(uint8_t button) const {
+  return _buttons[button].raw != _buttons[button].stable;
+}
+
+buttonEvent_t ButtonDebouncer::accept(uint8_t button, bool level, uint32_t timeUs) {
+  buttonState &state = _buttons[button];
+
+  if (level == state.stable) {
+    return BUTTON_NONE;
+  }
+
+  state.stable = level;
+  state.lastChange = timeUs;
+  return level ? BUTTON_RELEASED : BUTTON_PRESSED;
+}
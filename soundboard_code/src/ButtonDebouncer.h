@@ -0,0 +1,60 @@
+/**
+   Debounces the sound buttons from timestamped edges instead of polling the pins.
+   The first edge of a button is taken at once and bouncing is ignored for the debounce time,
+   a level which changed during that time is taken by poll() when the time is over.
+   Does not depend on the arduino core so it can be tested by replaying recorded edges.
+*/
+#ifndef BUTTONDEBOUNCER_h
+#define BUTTONDEBOUNCER_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUTTON_MAX 16
+
+// what a button did after debouncing
+enum buttonEvent_t {
+  BUTTON_NONE = 0,
+  BUTTON_PRESSED = 1,
+  BUTTON_RELEASED = 2
+};
+
+class ButtonDebouncer {
+
+  public:
+    /**
+       Constructor, the buttons are active low
+    */
+    ButtonDebouncer(uint32_t debounceUs);
+
+    // Sets the level of a button without creating an event, call this at start up
+    void init(uint8_t button, bool level, uint32_t nowUs);
+
+    // An edge of the button was seen at the given time, returns the debounced event
+    buttonEvent_t edge(uint8_t button, bool level, uint32_t timeUs);
+
+    // Takes the level of the given button when it is different after the debounce time
+    buttonEvent_t poll(uint8_t button, uint32_t nowUs);
+
+    // True when a button has a level change waiting for poll()
+    bool unsettled(uint8_t button) const;
+
+    // True when the button is pressed after debouncing
+    inline bool isPressed(uint8_t button) const {
+      return _buttons[button].stable == false;
+    }
+
+  private:
+    struct buttonState {
+      bool stable;                                    // Debounced level
+      bool raw;                                       // Level of the last edge
+      uint32_t lastChange;                            // Time the debounced level changed
+    };
+
+    buttonEvent_t accept(uint8_t button, bool level, uint32_t timeUs);
+
+    buttonState _buttons[BUTTON_MAX];
+    uint32_t _debounceUs;
+};
+
+#endif
@@ -14,6 +14,12 @@
   #define SPI_SCK_PIN   18
   #define SPI_MISO_PIN  19
   #define SPI_MOSI_PIN  23
+  #define VS1053_DREQ_IRQ 1   // 1 = DREQ going high wakes the sound task, 0 = poll DREQ every tick
+  #define FAST_RETRIGGER 1    // 1 = a new sound cancels the old one without fixed delays, 0 = full stopSong()
+  #ifndef VS1053_SIMULATED  // the native environment sets it
+  #define VS1053_SIMULATED 0  // 1 = no module, a simulated vs1053 takes the data to measure the playback
+  #endif
+  #define VS1053_SIM_BITRATE 128000  // bit/s the simulated decoder takes out of its FIFO
 
   // status led vars
   #define STATUS_LED_PIN 16
@@ -24,7 +30,59 @@
   #define WIFI_AP_SSID "soundboard"
   #define WIFI_AP_PASS "pass"
 
-  #define BUFFER_SIZE 60 // was 6000
-  #define QSIZ 400  // size of the data que
+  #define BUFFER_SIZE 1024 // was 60, data is queued per block now
+  #define RINGBUF_SIZE 8192  // size of the mp3 data ring buffer, must be a power of two
 
-#endif;
\ No newline at end of file
+  // POST /stream plays the body while it comes in, it goes through a jitter buffer in front of the ring buffer
+  #define STREAM_BUFFER_SIZE 16384  // size of the jitter buffer, must be a power of two
+  #define STREAM_PREBUFFER 6144  // bytes buffered before the stream starts playing, about 400ms at 128kbit/s
+  #define CMDQSIZ 4  // size of the sound command queue
+
+  // sound cache, keeps the first bytes of the button sounds in the heap
+  #define SOUND_CACHE_BUDGET (48 * 1024)  // max bytes in the heap for all sounds
+  #define SOUND_CACHE_HEAD_SIZE 4096  // max bytes per sound, about 250ms of a 128kbit mp3
+  #define SOUND_CACHE_ENTRIES 16  // max number of cached sounds
+
+  #define FILE_CATALOGUE_ENTRIES 64  // max number of files listed by /info
+  #define FILE_HASH_LIST "/hashes.lst"  // crc32, stored and uploaded size of the uploaded files, for /manifest
+
+  // uploaded mp3 files are filtered while they are written
+  #define UPLOAD_STRIP_TAGS 1  // 1 = drop id3 and ape tags
+  #define UPLOAD_TRIM_SILENCE 1  // 1 = drop the silent frames at the start
+  #define UPLOAD_SILENCE_GAIN 0  // frames with a lower global gain count as silent, 0 = only empty frames
+  #define UPLOAD_TEMP_PREFIX "/~"  // an upload is written to /~name and renamed to /name when it is complete
+  #define UPLOAD_TEMP_MAX (2 * HTTP_MAX_CONNECTIONS)  // temp files looked at after a restart, a sound and its index per upload
+
+  // http server
+  #define HTTP_MAX_CONNECTIONS 4  // clients served at the same time
+  #define HTTP_CHUNK_SIZE 1460  // max bytes read from one client per loop, one tcp segment
+  #define HTTP_FILE_BLOCK 2048  // bytes read from or written to the spiffs at once, a multiple of its 256 byte pages
+  #define HTTP_TIMEOUT_MS 10000  // a client which sends nothing for this long is closed
+  #define HTTP_KEEPALIVE_TIMEOUT_MS 5000  // an open connection without a request for this long is closed
+  #define HTTP_KEEPALIVE_MAX 100  // requests on one connection before it is closed
+  #define HTTP_MAX_LINE 256  // longest request or header line kept, the rest of a longer line is dropped
+  #define HTTP_MAX_NAME 64  // longest file name in a request
+  #define HTTP_TX_SIZE 3072  // buffer the responses are formatted in, shared by all connections
+  #define HTTP_HEADER_ROOM 256  // space for the header in front of the body in the buffer
+
+  // status events pushed to the clients of /events
+  #define EVENTS_MAX_CLIENTS 2  // clients of /events at the same time, the other connections stay free for requests
+  #define EVENTS_MIN_INTERVAL_MS 250  // changes within this time go out as one push
+  #define EVENTS_LEVELS_INTERVAL_MS 5000  // ms between two pushes of the heap and queue levels, keeps the connection alive
+
+  // remote triggers, a binary udp protocol to play and stop the sounds, see TriggerProtocol.h
+  #define TRIGGER_UDP_PORT 7000  // port of the remote triggers, 0 = off
+  #define TRIGGER_SENDER_TIMEOUT_MS 10000  // a sender silent for this long may start its sequence numbers anew
+
+  #define STATS_REPORT_INTERVAL 60000  // ms between the stats on the serial
+
+  // polyphony, sounds stored as /N.wav are mixed on the esp and streamed to the vs1053 as one wav
+  #define POLYPHONY_VOICES 0  // number of sounds played at the same time (max 8), 0 = off
+  #define MIXER_SAMPLE_RATE 22050  // sample rate of the wav files and the mix
+  #define MIXER_CHANNELS 1  // channels of the wav files and the mix
+
+  #define BUTTON_DEBOUNCE_MS 50  // edges of a button in this time after a change are bouncing
+  #define BUTTONQSIZ 32  // size of the queue of the button edges and the commands of the other tasks
+  #define PLAYER_IDLE_WAIT_MS 100  // max time the player task sleeps when nothing is played
+
+#endif
\ No newline at end of file
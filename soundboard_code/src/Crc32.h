@@ -0,0 +1,17 @@
+/**
+   CRC-32 as used by zip and png, computed over a file while it streams in.
+   A table of 256 words in flash, one lookup per byte.
+   Does not depend on the arduino core so it can be tested and benchmarked on the host.
+*/
+#ifndef CRC32_h
+#define CRC32_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC32_INIT 0                                       // Crc of no data, the start value of crc32Update()
+
+// Continues the crc of the data before with the next bytes
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len);
+
+#endif
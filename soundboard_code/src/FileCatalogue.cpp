@@ -0,0 +1,300 @@
+#include "FileCatalogue.h"
+#include "Mp3IndexFile.h"
+#include "BufferPrint.h"
+
+void FileCatalogue::begin() {
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    _entries[i].path = "";
+  }
+
+  recoverUploads();
+
+  File root = SPIFFS.open("/", FILE_READ);
+  File file = root.openNextFile();
+  while (file) {
+    String name = file.name();
+    uint32_t size = file.size();
+    file.close();
+
+    if (name.startsWith(UPLOAD_TEMP_PREFIX)) {
+      // more temp files than recoverUploads() looks at, there are never that many uploads at once
+      ESP_LOGI("Catalogue", "Removing unfinished upload %s", name.c_str());
+      SPIFFS.remove(name);
+    } else if (!name.endsWith(".idx") && name != FILE_HASH_LIST) {
+      // the frame indexes are shown as duration of their mp3
+      set(name, size);
+    }
+
+    file = root.openNextFile();
+  }
+  root.close();
+
+  loadHashes();
+  generation++;
+}
+
+/**
+   The file an upload was written for, /~N.mp3 belongs to /N.mp3
+*/
+static String uploadTarget(const String &temp) {
+  return "/" + temp.substring(strlen(UPLOAD_TEMP_PREFIX), temp.length());
+}
+
+void FileCatalogue::recoverUploads() {
+  String temps[UPLOAD_TEMP_MAX];
+  int count = 0;
+
+  // the names are collected first, the root is not changed while it is walked
+  File root = SPIFFS.open("/", FILE_READ);
+  File file = root.openNextFile();
+  while (file && count < UPLOAD_TEMP_MAX) {
+    String name = file.name();
+    file.close();
+    if (name.startsWith(UPLOAD_TEMP_PREFIX)) {
+      temps[count++] = name;
+    }
+    file = root.openNextFile();
+  }
+  if (file) {
+    file.close();
+  }
+  root.close();
+
+  for (int i = 0; i < count; i++) {
+    recoverUpload(temps[i]);
+  }
+}
+
+/**
+   httpCommitUpload() removes the old file, renames the upload, removes the old index and renames the new one.
+   An upload whose file is missing was cut off in between and is put in place, so is the index which did not
+   follow its mp3.  An upload next to its file did not get that far and is removed, the old file stays.
+*/
+void FileCatalogue::recoverUpload(const String &temp) {
+  if (SPIFFS.exists(temp) == false) {
+    // an index, already taken care of with its mp3
+    return;
+  }
+  String target = uploadTarget(temp);
+
+  if (temp.endsWith(".idx")) {
+    String mp3 = target.substring(0, target.length() - 4) + ".mp3";
+    String tempMp3 = temp.substring(0, temp.length() - 4) + ".mp3";
+    if (SPIFFS.exists(tempMp3)) {
+      recoverUpload(tempMp3);
+    } else if (SPIFFS.exists(mp3)) {
+      // the mp3 was renamed before the restart, the index has to follow
+      ESP_LOGI("Catalogue", "Putting the index %s of %s in place", temp.c_str(), mp3.c_str());
+      SPIFFS.remove(target);
+      SPIFFS.rename(temp, target);
+    } else {
+      // no sound to go with
+      SPIFFS.remove(temp);
+    }
+    return;
+  }
+
+  String tempIndex = Mp3IndexFile::pathFor(temp);
+  bool withIndex = tempIndex != "" && SPIFFS.exists(tempIndex);
+
+  if (SPIFFS.exists(target) == false) {
+    ESP_LOGI("Catalogue", "Putting the upload %s in place of %s", temp.c_str(), target.c_str());
+    SPIFFS.rename(temp, target);
+    Mp3IndexFile::remove(target);
+    if (withIndex) {
+      SPIFFS.rename(tempIndex, Mp3IndexFile::pathFor(target));
+    } else if (tempIndex != "") {
+      // the index is written after the last byte, without it the upload may be cut off
+      ESP_LOGW("Catalogue", "%s has no index, it may not be complete", target.c_str());
+    }
+    return;
+  }
+
+  // an upload which was cut off by a restart
+  ESP_LOGI("Catalogue", "Removing unfinished upload %s", temp.c_str());
+  SPIFFS.remove(temp);
+  if (withIndex) {
+    SPIFFS.remove(tempIndex);
+  }
+}
+
+void FileCatalogue::update(const String &path) {
+  if (SPIFFS.exists(path) == false) {
+    remove(path);
+    return;
+  }
+
+  File file = SPIFFS.open(path, FILE_READ);
+  uint32_t size = file.size();
+  file.close();
+
+  set(path, size);
+  generation++;
+}
+
+void FileCatalogue::remove(const String &path) {
+  int idx = find(path);
+  if (idx < 0) {
+    return;
+  }
+
+  _entries[idx].path = "";
+  if (_entries[idx].hashed) {
+    saveHashes();
+  }
+  generation++;
+}
+
+void FileCatalogue::setHash(const String &path, uint32_t hash, uint32_t uploadSize) {
+  int idx = find(path);
+  if (idx < 0) {
+    return;
+  }
+
+  _entries[idx].hashed = true;
+  _entries[idx].hash = hash;
+  _entries[idx].uploadSize = uploadSize;
+  saveHashes();
+  generation++;
+}
+
+void FileCatalogue::loadHashes() {
+  File list = SPIFFS.open(FILE_HASH_LIST, FILE_READ);
+  if (!list) {
+    return;
+  }
+
+  // a line is the hash, the size, the size of the upload and the path
+  char line[HTTP_MAX_NAME + 36];
+  size_t len = 0;
+  while (list.available()) {
+    int c = list.read();
+    if (c != '\n') {
+      if (len < sizeof(line) - 1) {
+        line[len++] = c;
+      }
+      continue;
+    }
+    line[len] = 0;
+    len = 0;
+
+    unsigned int hash;
+    unsigned int size;
+    unsigned int uploadSize;
+    int pathStart = 0;
+    if (sscanf(line, "%8x %u %u %n", &hash, &size, &uploadSize, &pathStart) < 3 || pathStart == 0) {
+      continue;
+    }
+
+    // a file written after its hash, for example by a restart during an upload, has another size
+    int idx = find(line + pathStart);
+    if (idx >= 0 && _entries[idx].size == size) {
+      _entries[idx].hashed = true;
+      _entries[idx].hash = hash;
+      _entries[idx].uploadSize = uploadSize;
+    }
+  }
+  list.close();
+}
+
+void FileCatalogue::saveHashes() {
+  File list = SPIFFS.open(FILE_HASH_LIST, FILE_WRITE);
+  if (!list) {
+    ESP_LOGE("Catalogue", "Could not write %s", FILE_HASH_LIST);
+    return;
+  }
+
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    catalogueEntry &entry = _entries[i];
+    if (entry.path != "" && entry.hashed) {
+      printFormatted(list, "%08x %u %u %s\n", entry.hash, entry.size, entry.uploadSize, entry.path.c_str());
+    }
+  }
+  list.close();
+}
+
+bool FileCatalogue::contains(const char* path) const {
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    if (_entries[i].path == path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FileCatalogue::printJson(Print &out) {
+  String sep = "";
+
+  out.println("[");
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    catalogueEntry &entry = _entries[i];
+    if (entry.path == "") {
+      continue;
+    }
+
+    out.print(sep);
+    out.print("{\"name\" : \"");
+    out.print(entry.path);
+    out.print("\",\"size\": ");
+    out.print(entry.size);
+    if (entry.indexed) {
+      out.print(",\"duration\": ");
+      out.print(entry.index.durationMs);
+      out.print(",\"frames\": ");
+      out.print(entry.index.frameCount);
+      out.print(",\"bitrate\": ");
+      out.print(entry.index.avgBitrate);
+    }
+    out.println("}");
+    sep = ",";
+  }
+  out.print("]");
+}
+
+void FileCatalogue::printManifest(Print &out) {
+  bool first = true;
+
+  out.print("[");
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    catalogueEntry &entry = _entries[i];
+    if (entry.path == "") {
+      continue;
+    }
+
+    printFormatted(out, "%s\r\n{\"name\" : \"%s\", \"size\" : %u, ", first ? "" : ",", entry.path.c_str(), entry.size);
+    if (entry.hashed) {
+      printFormatted(out, "\"uploadSize\" : %u, \"hash\" : \"%08x\"}", entry.uploadSize, entry.hash);
+    } else {
+      out.print("\"uploadSize\" : null, \"hash\" : null}");
+    }
+    first = false;
+  }
+  out.print("]");
+}
+
+int FileCatalogue::find(const String &path) const {
+  for (int i = 0; i < FILE_CATALOGUE_ENTRIES; i++) {
+    if (_entries[i].path == path) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void FileCatalogue::set(const String &path, uint32_t size) {
+  int idx = find(path);
+  if (idx < 0) {
+    idx = find("");
+  }
+  if (idx < 0) {
+    ESP_LOGW("Catalogue", "No room for %s in the file list", path.c_str());
+    return;
+  }
+
+  catalogueEntry &entry = _entries[idx];
+  entry.path = path;
+  entry.size = size;
+  entry.indexed = Mp3IndexFile::readHeader(path, &entry.index);
+  // the hash of an older version of the file does not count
+  entry.hashed = false;
+}
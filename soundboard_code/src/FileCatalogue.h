@@ -0,0 +1,69 @@
+/**
+   Keeps the list of the files on the SPIFFS in memory.
+   The root is only walked once at the start, uploads and deletes update the list, so /info
+   does not have to open every file and its frame index on each request.
+*/
+#ifndef FILECATALOGUE_h
+#define FILECATALOGUE_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include "Configuration.h"
+#include "Mp3FrameIndex.h"
+
+class FileCatalogue {
+
+  public:
+    // Reads the file list from the SPIFFS and finishes or removes the uploads of the last run, must be called after it is mounted
+    void begin();
+
+    // Reads the size and index of the given file again, call this when it was written
+    void update(const String &path);
+
+    // Removes the given file from the list, call this when it was deleted
+    void remove(const String &path);
+
+    // The file is in the list, does not ask the SPIFFS
+    bool contains(const char* path) const;
+
+    // Keeps the crc32 and the size of the file as it was uploaded, call this after update()
+    void setHash(const String &path, uint32_t hash, uint32_t uploadSize);
+
+    // Prints the list as a json array
+    void printJson(Print &out);
+
+    // Prints name, size, upload size and crc32 of all files as a json array, the last two are null when not known
+    // The crc32 is the one of the upload, size is what was stored after the filter, compare with uploadSize
+    void printManifest(Print &out);
+
+    uint32_t generation = 0;                          // Changes with every change of the list
+
+  private:
+    struct catalogueEntry {
+      String path;                                    // Path of the file on the SPIFFS, empty when unused
+      uint32_t size;                                  // Size of the file
+      bool indexed;                                   // The file has a frame index
+      mp3IndexHeader index;                           // Header of the frame index
+      bool hashed;                                    // The file was uploaded and its crc32 is known
+      uint32_t hash;                                  // Crc32 of the upload, before the filter
+      uint32_t uploadSize;                            // Size of the upload, before the filter
+    };
+
+    // Puts the uploads cut off by a restart in place or removes them
+    void recoverUploads();
+    void recoverUpload(const String &temp);
+
+    int find(const String &path) const;
+    void set(const String &path, uint32_t size);
+
+    // The hashes are kept in FILE_HASH_LIST, a hash only counts while the file has its size
+    void loadHashes();
+    void saveHashes();
+
+    catalogueEntry _entries[FILE_CATALOGUE_ENTRIES];
+};
+
+extern FileCatalogue fileCatalogue;
+
+#endif
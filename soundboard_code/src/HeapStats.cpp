@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include <atomic>
+
+#include "HeapStats.h"
+
+static std::atomic<uint32_t> allocations(0);
+
+extern "C" {
+  void* __real_malloc(size_t size);
+  void* __real_calloc(size_t count, size_t size);
+  void* __real_realloc(void* ptr, size_t size);
+
+  void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+  }
+
+  void* __wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+  }
+
+  void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+  }
+}
+
+uint32_t heapAllocations() {
+  return allocations;
+}
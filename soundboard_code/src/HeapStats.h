@@ -0,0 +1,14 @@
+/**
+   Counts the allocations of the firmware, to see that a path does not take the heap.
+   malloc, calloc and realloc are wrapped by the linker (-Wl,--wrap in platformio.ini), String
+   and new end up in them as well.
+*/
+#ifndef HEAPSTATS_h
+#define HEAPSTATS_h
+
+#include <stdint.h>
+
+// Calls of malloc, calloc and realloc since the start
+uint32_t heapAllocations();
+
+#endif
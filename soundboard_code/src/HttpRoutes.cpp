@@ -0,0 +1,264 @@
+#include <string.h>
+#include <strings.h>
+
+#include "HttpRoutes.h"
+
+#define HTTP_ROUTE(method, path, param, action) { method, path, param, action, httpHash(method " " path) }
+
+/**
+   All endpoints, a new one needs a line here and its action in HttpServer::httpHandleRequest()
+*/
+static constexpr httpRoute_struct httpRoutes[] = {
+  HTTP_ROUTE("GET", "/play", true, PLAY),
+  HTTP_ROUTE("GET", "/download", true, DOWNLOAD),
+  HTTP_ROUTE("GET", "/delete", true, DELETE),
+  HTTP_ROUTE("GET", "/info", false, INFO),
+  HTTP_ROUTE("GET", "/restart", false, RESTART),
+  HTTP_ROUTE("GET", "/stats", false, STATS),
+  HTTP_ROUTE("GET", "/events", false, EVENTS),
+  HTTP_ROUTE("GET", "/manifest", false, MANIFEST),
+  HTTP_ROUTE("POST", "/upload", false, UPLOAD_INIT),
+  HTTP_ROUTE("POST", "/stream", false, STREAM)
+};
+
+static constexpr size_t HTTP_ROUTE_COUNT = sizeof(httpRoutes) / sizeof(httpRoutes[0]);
+
+// the lookup stops at the first route with the hash of the request, so no two may share one
+constexpr bool httpRoutesUnique(size_t i = 0, size_t j = 1) {
+  return i >= HTTP_ROUTE_COUNT ? true
+         : j >= HTTP_ROUTE_COUNT ? httpRoutesUnique(i + 1, i + 2)
+         : httpRoutes[i].hash != httpRoutes[j].hash && httpRoutesUnique(i, j + 1);
+}
+
+static_assert(httpRoutesUnique(), "two http routes have the same hash");
+
+struct httpHeaderName_struct {
+  const char* name;
+  size_t len;
+  httpHeader_t header;
+};
+
+#define HTTP_HEADER(name, header) { name, sizeof(name) - 1, header }
+
+static constexpr httpHeaderName_struct httpHeaderNames[] = {
+  HTTP_HEADER("connection", HEADER_CONNECTION),
+  HTTP_HEADER("content-type", HEADER_CONTENT_TYPE),
+  HTTP_HEADER("range", HEADER_RANGE),
+  HTTP_HEADER("if-none-match", HEADER_IF_NONE_MATCH),
+  HTTP_HEADER("content-length", HEADER_CONTENT_LENGTH),
+  HTTP_HEADER("transfer-encoding", HEADER_TRANSFER_ENCODING)
+};
+
+static httpView_struct httpView(const char* from, const char* to) {
+  httpView_struct view = { from, (size_t) (to - from) };
+  return view;
+}
+
+static bool httpViewEquals(const httpView_struct &view, const char* text) {
+  return strlen(text) == view.len && memcmp(view.data, text, view.len) == 0;
+}
+
+// Where the text starts in the view, not case sensitive, NULL when it is not there
+static const char* httpViewFind(const httpView_struct &view, const char* text) {
+  size_t len = strlen(text);
+  for (size_t i = 0; i + len <= view.len; i++) {
+    if (strncasecmp(view.data + i, text, len) == 0) {
+      return view.data + i;
+    }
+  }
+  return NULL;
+}
+
+static httpView_struct httpTrim(const char* from, const char* to) {
+  while (from < to && (*from == ' ' || *from == '\t')) {
+    from++;
+  }
+  while (to > from && (to[-1] == ' ' || to[-1] == '\t')) {
+    to--;
+  }
+  return httpView(from, to);
+}
+
+bool httpParseRequestLine(const char* line, size_t len, httpRequestLine_struct &request) {
+  const char* end = line + len;
+
+  // method, target and version are split by a space
+  const char* target = (const char*) memchr(line, ' ', len);
+  if (target == NULL || target == line) {
+    return false;
+  }
+  request.method = httpView(line, target);
+  target++;
+
+  const char* version = (const char*) memchr(target, ' ', end - target);
+  if (version == NULL || *target != '/') {
+    return false;
+  }
+  request.http11 = httpViewEquals(httpView(version + 1, end), "HTTP/1.1");
+
+  // the query is not used
+  const char* pathEnd = (const char*) memchr(target, '?', version - target);
+  if (pathEnd == NULL) {
+    pathEnd = version;
+  }
+
+  const char* slash = (const char*) memchr(target + 1, '/', pathEnd - target - 1);
+  if (slash == NULL) {
+    request.path = httpView(target, pathEnd);
+    request.param = httpView(pathEnd, pathEnd);
+  } else {
+    request.path = httpView(target, slash);
+    request.param = httpView(slash + 1, pathEnd);
+  }
+  return true;
+}
+
+const httpRoute_struct* httpFindRoute(const httpRequestLine_struct &request) {
+  uint32_t hash = httpHash("");
+  for (size_t i = 0; i < request.method.len; i++) {
+    hash = httpHashStep(hash, request.method.data[i]);
+  }
+  hash = httpHashStep(hash, ' ');
+  for (size_t i = 0; i < request.path.len; i++) {
+    hash = httpHashStep(hash, request.path.data[i]);
+  }
+
+  for (size_t i = 0; i < HTTP_ROUTE_COUNT; i++) {
+    const httpRoute_struct &route = httpRoutes[i];
+    if (route.hash != hash) {
+      continue;
+    }
+
+    // another request with the same hash
+    if (!httpViewEquals(request.method, route.method) || !httpViewEquals(request.path, route.path)) {
+      return NULL;
+    }
+    // the parameter is there exactly when the route wants one
+    if (route.param != (request.param.len > 0)) {
+      return NULL;
+    }
+    return &route;
+  }
+  return NULL;
+}
+
+httpHeader_t httpParseHeader(const char* line, size_t len, httpView_struct &value) {
+  const char* colon = (const char*) memchr(line, ':', len);
+  if (colon == NULL) {
+    return HEADER_OTHER;
+  }
+
+  size_t nameLen = colon - line;
+  for (size_t i = 0; i < sizeof(httpHeaderNames) / sizeof(httpHeaderNames[0]); i++) {
+    const httpHeaderName_struct &name = httpHeaderNames[i];
+    if (name.len == nameLen && strncasecmp(line, name.name, nameLen) == 0) {
+      value = httpTrim(colon + 1, line + len);
+      return name.header;
+    }
+  }
+  return HEADER_OTHER;
+}
+
+bool httpFindBoundary(const httpView_struct &contentType, httpView_struct &boundary) {
+  if (contentType.len < 19 || strncasecmp(contentType.data, "multipart/form-data", 19) != 0) {
+    return false;
+  }
+
+  const char* from = httpViewFind(contentType, "boundary=");
+  if (from == NULL) {
+    return false;
+  }
+  from += 9;
+
+  // more parameters may follow
+  const char* end = contentType.data + contentType.len;
+  const char* to = (const char*) memchr(from, ';', end - from);
+  boundary = httpTrim(from, to == NULL ? end : to);
+  return boundary.len > 0;
+}
+
+bool httpViewContains(const httpView_struct &view, const char* text) {
+  return httpViewFind(view, text) != NULL;
+}
+
+void httpChunkedBegin(httpChunked_struct &chunked) {
+  chunked.state = CHUNK_SIZE;
+  chunked.size = 0;
+}
+
+static int httpHexDigit(uint8_t c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+size_t httpChunkedFrame(httpChunked_struct &chunked, const uint8_t* data, size_t len, uint32_t &left) {
+  left = 0;
+
+  // the caller used the data of the last chunk
+  if (chunked.state == CHUNK_DATA) {
+    chunked.state = CHUNK_DATA_END;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = data[i];
+
+    switch (chunked.state) {
+      case CHUNK_SIZE:
+      case CHUNK_EXTENSION:
+        if (c == '\n') {
+          if (chunked.size == 0) {
+            chunked.state = CHUNK_TRAILER;
+            break;
+          }
+          left = chunked.size;
+          chunked.state = CHUNK_DATA;
+          return i + 1;
+        }
+        if (chunked.state == CHUNK_EXTENSION || c == '\r') {
+          break;
+        }
+        if (c == ';' || c == ' ' || c == '\t') {
+          chunked.state = CHUNK_EXTENSION;
+        } else if (httpHexDigit(c) < 0 || chunked.size > 0x0FFFFFFF) {
+          chunked.state = CHUNK_ERROR;
+          return i;
+        } else {
+          chunked.size = (chunked.size << 4) | httpHexDigit(c);
+        }
+        break;
+
+      case CHUNK_DATA_END:
+        if (c == '\n') {
+          chunked.state = CHUNK_SIZE;
+          chunked.size = 0;
+        } else if (c != '\r') {
+          chunked.state = CHUNK_ERROR;
+          return i;
+        }
+        break;
+
+      case CHUNK_TRAILER:
+        // the empty line ends the body
+        if (c == '\n') {
+          if (chunked.size == 0) {
+            chunked.state = CHUNK_DONE;
+            return i + 1;
+          }
+          chunked.size = 0;
+        } else if (c != '\r') {
+          chunked.size++;
+        }
+        break;
+
+      default:
+        return i;
+    }
+  }
+  return len;
+}
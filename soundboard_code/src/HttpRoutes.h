@@ -0,0 +1,118 @@
+/**
+   The endpoints of the http server and the parsing of request and header lines.
+   The routes are declared once in a table the compiler hashes, a request line is split into views
+   of its method, path and parameter and looked up with one hash and a few compares.
+   Does not depend on the arduino core so it can be tested and benchmarked on the host.
+*/
+#ifndef HTTPROUTES_h
+#define HTTPROUTES_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the action a http client wants to perform
+enum httpClientAction_t {
+  NONE = 1,
+  FAILURE = 2,
+  PLAY = 3,
+  INFO = 4,
+  UPLOAD_INIT = 5,
+  UPLOAD_BOUNDARY_INIT = 6,
+  UPLOAD_DATA_START = 9,
+  UPLOAD_DATA_END = 10,
+  DOWNLOAD = 11,
+  DELETE = 12,
+  RESTART = 13,
+  STATS = 14,
+  SENDING = 15,
+  STREAM = 16,
+  STREAMING = 17,
+  EVENTS = 18,
+  MANIFEST = 19
+};
+
+// the headers the server looks at
+enum httpHeader_t {
+  HEADER_OTHER,
+  HEADER_CONNECTION,
+  HEADER_CONTENT_TYPE,
+  HEADER_RANGE,
+  HEADER_IF_NONE_MATCH,
+  HEADER_CONTENT_LENGTH,
+  HEADER_TRANSFER_ENCODING
+};
+
+// where the decoder of a chunked body is
+enum httpChunkedState_t {
+  CHUNK_SIZE,                                          // hex size of the next chunk
+  CHUNK_EXTENSION,                                     // rest of the size line, ignored
+  CHUNK_DATA,                                          // data of the chunk, passed on by the caller
+  CHUNK_DATA_END,                                      // line break after the data
+  CHUNK_TRAILER,                                       // header lines after the last chunk, ignored
+  CHUNK_DONE,
+  CHUNK_ERROR
+};
+
+// a part of a line, not terminated
+struct httpView_struct {
+  const char* data;
+  size_t len;
+};
+
+// an endpoint, the path is its first segment
+struct httpRoute_struct {
+  const char* method;
+  const char* path;
+  bool param;                                          // a second segment is passed to the action
+  httpClientAction_t action;
+  uint32_t hash;                                       // hash of method, space and path
+};
+
+// the parts of a request line
+struct httpRequestLine_struct {
+  httpView_struct method;
+  httpView_struct path;                                // first segment of the path with its slash
+  httpView_struct param;                               // rest of the path without the query
+  bool http11;                                         // HTTP/1.1, else an older version
+};
+
+// decoder of a body sent with Transfer-Encoding: chunked
+struct httpChunked_struct {
+  httpChunkedState_t state;
+  uint32_t size;                                       // size of the chunk read so far, length of a trailer line
+};
+
+/**
+   FNV-1a, the compiler uses it for the routes and the lookup for the request
+*/
+constexpr uint32_t httpHashStep(uint32_t hash, char c) {
+  return (hash ^ (uint8_t) c) * 16777619UL;
+}
+
+constexpr uint32_t httpHash(const char* s, uint32_t hash = 2166136261UL) {
+  return *s == 0 ? hash : httpHash(s + 1, httpHashStep(hash, *s));
+}
+
+// Splits a request line, returns false when it is no request line
+bool httpParseRequestLine(const char* line, size_t len, httpRequestLine_struct &request);
+
+// The route of the request, NULL when there is none
+const httpRoute_struct* httpFindRoute(const httpRequestLine_struct &request);
+
+// Splits a header line, returns which header it is and its value without the spaces around it
+httpHeader_t httpParseHeader(const char* line, size_t len, httpView_struct &value);
+
+// The boundary of a multipart/form-data content type
+bool httpFindBoundary(const httpView_struct &contentType, httpView_struct &boundary);
+
+// The view contains the text, not case sensitive
+bool httpViewContains(const httpView_struct &view, const char* text);
+
+// Gets the decoder ready for a new body
+void httpChunkedBegin(httpChunked_struct &chunked);
+
+// Reads the framing of a chunked body up to the next data, returns the bytes used.
+// left is set to the bytes of data which follow, the caller passes them on and calls this again when they are used.
+size_t httpChunkedFrame(httpChunked_struct &chunked, const uint8_t* data, size_t len, uint32_t &left);
+
+#endif
@@ -1,372 +1,1183 @@
+#include <stdarg.h>
+
 #include "HttpServer.h"
+#include "SoundCache.h"
+#include "BoardStats.h"
+#include "Mp3IndexFile.h"
+#include "FileCatalogue.h"
+#include "BufferPrint.h"
+#include "SoundFiles.h"
+#include "SoundStream.h"
+#include "PlayerControl.h"
+#include "Crc32.h"
+#include <StreamString.h>
 
 HttpServer::HttpServer() {   
+  snprintf(keepAliveHeader, sizeof(keepAliveHeader), "Connection: keep-alive\r\nKeep-Alive: timeout=%u\r\n", HTTP_KEEPALIVE_TIMEOUT_MS / 1000);
 }
 
 void HttpServer::initHttpServer() {
   wifiServer->begin();
 }
 
-void HttpServer::httpNotFound(WiFiClient client, String reason) {
-  client.println(httpHeaderFailure);
-  client.println("Content-type:text/html");
-  client.println();
-  client.println(reason);
-  client.println();    
+void HttpServer::httpNotFound(httpConnection_struct &conn, const char* reason, ...) {
+  const size_t size = HTTP_TX_SIZE - HTTP_HEADER_ROOM;
+  char* body = httpBody();
+  va_list args;
+
+  va_start(args, reason);
+  int len = vsnprintf(body, size - 2, reason, args);
+  va_end(args);
+  if (len < 0) {
+    len = 0;
+  } else if ((size_t) len > size - 3) {
+    len = size - 3;
+  }
+  memcpy(body + len, "\r\n", 2);
+
+  httpRespond(conn, httpHeaderFailure, "text/html", body, len + 2);
 }
 
-File HttpServer::httpStartUpload(String uploadedFile) {
-  // write the file
-  String path = "/" + uploadedFile;
+const char* HttpServer::httpConnectionHeader(httpConnection_struct &conn) {
+  return conn.keepAlive ? keepAliveHeader : "Connection: close\r\n";
+}
 
-  // Remove old file
-  /*if (SPIFFS.exists(path) == true) {
-    dbg.print("File", "Removing old file: %s", path.c_str());
-    SPIFFS.remove(path);
-    }*/
+void HttpServer::httpRespond(httpConnection_struct &conn, const char* status, const char* contentType, const char* body, size_t bodyLen, const char* headers) {
+  // the length tells the client where the response ends, so the connection can stay open
+  char header[HTTP_HEADER_ROOM];
+  int headerLen = snprintf(header, sizeof(header),
+                           "%s\r\nContent-type: %s\r\nAccess-Control-Allow-Origin: *\r\nContent-Length: %u\r\n%s%s\r\n",
+                           status, contentType, (unsigned int) bodyLen, headers, httpConnectionHeader(conn));
+  if (headerLen < 0 || (size_t) headerLen >= sizeof(header)) {
+    ESP_LOGE("Http", "Response header does not fit");
+    conn.keepAlive = false;
+    return;
+  }
 
-  SPIFFS.end();
-  delay(1000);
-  SPIFFS.begin(true);
+  // one write, a small body would else wait for the ack of the header
+  if (headerLen + bodyLen <= HTTP_TX_SIZE) {
+    memmove(tx + headerLen, body, bodyLen);
+    memcpy(tx, header, headerLen);
+    conn.client.write((const uint8_t*) tx, headerLen + bodyLen);
+    return;
+  }
+  conn.client.write((const uint8_t*) header, headerLen);
+  conn.client.write((const uint8_t*) body, bodyLen);
+}
+
+File HttpServer::httpStartUpload(const char* uploadedFile) {
+  // write the temp file, the old file may be played meanwhile
+  char path[HTTP_MAX_NAME + 3];
+  snprintf(path, sizeof(path), UPLOAD_TEMP_PREFIX "%s", uploadedFile);
 
-  ESP_LOGD("File", "Open file to write: %s", path.c_str());
-  static File file = SPIFFS.open(path, FILE_WRITE);
+  // no remount here, other connections and the player may have files open
+  ESP_LOGD("File", "Open file to write: %s", path);
+  File file = SPIFFS.open(path, FILE_WRITE);
 
   return file;
 }
 
-void HttpServer::httpDownloadMp3(WiFiClient client, String fileToDownload) {
+void HttpServer::httpCommitUpload(httpConnection_struct &conn) {
+  char path[HTTP_MAX_NAME + 2];
+  char temp[HTTP_MAX_NAME + 3];
+  snprintf(path, sizeof(path), "/%s", conn.dataToHandle);
+  snprintf(temp, sizeof(temp), UPLOAD_TEMP_PREFIX "%s", conn.dataToHandle);
+
+  // spiffs breaks the reads of a removed file, the downloads of the old one finish first
+  if (httpDownloading(path) || !lockSoundFile(path)) {
+    return;
+  }
+
+  // spiffs does not rename over an existing file, the player can not open it in between
+  if (SPIFFS.exists(path)) {
+    SPIFFS.remove(path);
+  }
+  bool renamed = SPIFFS.rename(temp, path);
+
+  String index = Mp3IndexFile::pathFor(path);
+  if (index != "") {
+    Mp3IndexFile::remove(path);
+    if (renamed) {
+      SPIFFS.rename(Mp3IndexFile::pathFor(temp), index);
+    }
+  }
+
+  // the cached head belongs to the old file
+  soundCache.invalidate(path);
+  unlockSoundFile();
+
+  fileCatalogue.update(path);
+  if (renamed) {
+    fileCatalogue.setHash(path, conn.uploadCrc, conn.uploadBytes);
+  }
+
+  if (!renamed) {
+    ESP_LOGE("Http Upload", "Could not rename %s to %s", temp, path);
+    SPIFFS.remove(temp);
+    Mp3IndexFile::remove(temp);
+    httpNotFound(conn, "Could not write file: %s", conn.dataToHandle);
+  } else {
+    httpUPloadFinished(conn);
+  }
+  conn.action = NONE;
+}
+
+/**
+   Resolves the range header of a download for a file of the given size.
+   Returns 1 and the first and last byte when the range is valid, -1 when it is not satisfiable and
+   0 when it is ignored, for example several ranges, then the whole file is sent.
+*/
+static int httpParseRange(const char* range, uint32_t size, uint32_t &first, uint32_t &last) {
+  if (strncmp(range, "bytes=", 6) != 0 || strchr(range, ',') != NULL) {
+    return 0;
+  }
+
+  const char* spec = range + 6;
+  char* end;
+
+  // -n are the last n bytes
+  if (*spec == '-') {
+    unsigned long count = strtoul(spec + 1, &end, 10);
+    if (end == spec + 1 || *end != 0) {
+      return 0;
+    }
+    if (count == 0) {
+      return -1;
+    }
+    first = count < size ? size - count : 0;
+    last = size - 1;
+    return 1;
+  }
+
+  unsigned long from = strtoul(spec, &end, 10);
+  if (end == spec || *end != '-') {
+    return 0;
+  }
+  spec = end + 1;
 
-  String path = "/" + fileToDownload + ".mp3";
-  ESP_LOGI("Http download", "Streaming file: %s to client", path.c_str());
+  unsigned long to = size - 1;
+  if (*spec != 0) {
+    to = strtoul(spec, &end, 10);
+    if (end == spec || *end != 0 || to < from) {
+      return 0;
+    }
+  }
+
+  if (from >= size) {
+    return -1;
+  }
+  first = from;
+  last = to < size ? to : size - 1;
+  return 1;
+}
+
+void HttpServer::httpDownloadMp3(httpConnection_struct &conn, const char* fileToDownload) {
+  char path[HTTP_MAX_NAME + 6];
+  snprintf(path, sizeof(path), "/%s.mp3", fileToDownload);
+  ESP_LOGI("Http download", "Streaming file: %s to client", path);
 
   File file = SPIFFS.open(path, FILE_READ);
 
   if (file.size() == 0) {
-    httpNotFound(client, "File: " + path + " not found");
+    httpNotFound(conn, "File: %s not found", path);
     return;
   }
 
-  client.println(httpHeaderOk);
-  client.println("Content-type: audio/mp3");
-  client.println("Content-Length:" + file.size());
-  client.println();
+  uint32_t size = file.size();
+  uint32_t first = 0;
+  uint32_t last = size - 1;
+  int range = conn.range[0] == 0 ? 0 : httpParseRange(conn.range, size, first, last);
 
-  while (file.available()) {
-    client.write(file.read());
+  if (range < 0) {
+    ESP_LOGD("Http download", "Range not satisfiable: %s", conn.range);
+    file.close();
+    int len = snprintf(tx, sizeof(tx), "%s\r\nContent-Range: bytes */%u\r\nContent-Length: 0\r\n%s\r\n",
+                       httpHeaderBadRange, size, httpConnectionHeader(conn));
+    conn.client.write((const uint8_t*) tx, len);
+    return;
   }
 
-  client.println();
+  // the header goes out in one write
+  int len = snprintf(tx, sizeof(tx), "%s\r\nContent-type: audio/mp3\r\nAccess-Control-Allow-Origin: *\r\nAccept-Ranges: bytes\r\n",
+                     range > 0 ? httpHeaderPartial : httpHeaderOk);
+  if (range > 0) {
+    len += snprintf(tx + len, sizeof(tx) - len, "Content-Range: bytes %u-%u/%u\r\n", first, last, size);
+  }
+  len += snprintf(tx + len, sizeof(tx) - len, "Content-Length: %u\r\n%s\r\n", last - first + 1, httpConnectionHeader(conn));
+  conn.client.write((const uint8_t*) tx, len);
 
-  file.close();
+  // the data is sent a block per loop
+  if (first > 0) {
+    file.seek(first);
+  }
+  conn.downloadFile = file;
+  conn.sendLeft = last - first + 1;
+  conn.blockLen = 0;
+  conn.blockPos = 0;
+  conn.action = SENDING;
 }
 
-void HttpServer::httpDeleteFile(WiFiClient client, String fileToDelete) {
-  String path = "/" + fileToDelete;
-  ESP_LOGI("Http download", "Delete file: %s", path.c_str());
+void HttpServer::httpSendFile(httpConnection_struct &conn) {
+  if (!conn.client.connected()) {
+    httpCloseConnection(conn);
+    return;
+  }
 
+  // the next block is read from the flash when the last one is sent
+  if (conn.blockPos == conn.blockLen) {
+    if (conn.sendLeft == 0) {
+      conn.downloadFile.close();
+      httpFinishRequest(conn);
+      return;
+    }
 
-  if (SPIFFS.exists(path) == false) {
-    httpNotFound(client, "File: " + path + " not found");
-    return;
+    size_t want = conn.sendLeft < HTTP_FILE_BLOCK ? conn.sendLeft : HTTP_FILE_BLOCK;
+    conn.blockLen = conn.downloadFile.read(conn.block, want);
+    conn.blockPos = 0;
+    if (conn.blockLen == 0) {
+      ESP_LOGE("Http download", "File ended %u bytes early", conn.sendLeft);
+      httpCloseConnection(conn);
+      return;
+    }
+    conn.sendLeft -= conn.blockLen;
   }
 
-  SPIFFS.remove(path);
+  // the socket takes what fits, the rest waits for the next loop
+  size_t sent = conn.client.write(conn.block + conn.blockPos, conn.blockLen - conn.blockPos);
+  if (sent > 0) {
+    conn.blockPos += sent;
+    conn.lastActivity = millis();
+  } else if (millis() - conn.lastActivity > HTTP_TIMEOUT_MS) {
+    ESP_LOGD("Http", "Client stopped reading");
+    httpCloseConnection(conn);
+  }
+}
 
-  client.println(httpHeaderOk);
-  client.println("Content-type: text/html");
-  client.println();
+void HttpServer::httpStreamData(httpConnection_struct &conn) {
+  // nothing more is read while the jitter buffer is full, so tcp slows the client down
+  if (conn.rxPos == conn.rxLen && streamActive()) {
+    int avail = conn.client.available();
+    if (avail <= 0) {
+      if (!conn.client.connected() || millis() - conn.lastActivity > HTTP_TIMEOUT_MS) {
+        ESP_LOGD("Http stream", "Client left before the end of the stream");
+        httpCloseConnection(conn);
+      }
+      return;
+    }
 
-  client.println("File: " + path + " deleted.");
-  client.println();
+    int len = conn.client.read(conn.rx, avail < (int) sizeof(conn.rx) ? avail : sizeof(conn.rx));
+    if (len <= 0) {
+      return;
+    }
+    conn.rxPos = 0;
+    conn.rxLen = len;
+    conn.lastActivity = millis();
+  }
+
+  bool done = false;
+  while (!done && conn.rxPos < conn.rxLen && streamActive()) {
+    if (conn.bodyLeft > 0) {
+      size_t len = conn.rxLen - conn.rxPos;
+      if (len > conn.bodyLeft) {
+        len = conn.bodyLeft;
+      }
+      size_t taken = streamWrite(conn.rx + conn.rxPos, len);
+      conn.rxPos += taken;
+      conn.bodyLeft -= taken;
+      conn.streamBytes += taken;
+      if (taken < len) {
+        return;
+      }
+    } else if (conn.chunkedBody) {
+      conn.rxPos += httpChunkedFrame(conn.chunked, conn.rx + conn.rxPos, conn.rxLen - conn.rxPos, conn.bodyLeft);
+    }
+    done = conn.bodyLeft == 0 && (!conn.chunkedBody || conn.chunked.state == CHUNK_DONE || conn.chunked.state == CHUNK_ERROR);
+  }
+
+  if (!done && streamActive()) {
+    return;
+  }
+  bool stopped = !streamActive();
+  streamEnd();
+
+  // a stopped or broken body is not read to its end, the connection is closed
+  conn.keepAlive = false;
+  if (conn.chunkedBody && conn.chunked.state == CHUNK_ERROR) {
+    ESP_LOGE("Http stream", "Bad chunk after %u bytes", conn.streamBytes);
+    httpNotFound(conn, "Bad chunk");
+  } else {
+    uint32_t ms = millis() - conn.streamStart;
+    ESP_LOGI("Http stream", "Stream %s, %u bytes in %u ms", stopped ? "stopped" : "received", conn.streamBytes, ms);
+    int len = snprintf(httpBody(), HTTP_TX_SIZE - HTTP_HEADER_ROOM, "{\"bytes\" : %u, \"ms\" : %u, \"stopped\" : %s}\r\n",
+                       conn.streamBytes, ms, stopped ? "true" : "false");
+    httpRespond(conn, httpHeaderOk, "application/json", httpBody(), len);
+  }
+  conn.action = NONE;
+  httpFinishRequest(conn);
 }
 
-void HttpServer::httpPlaySound(WiFiClient client, String fileToPlay) {
+void HttpServer::httpDeleteFile(httpConnection_struct &conn, const char* fileToDelete) {
+  char path[HTTP_MAX_NAME + 2];
+  snprintf(path, sizeof(path), "/%s", fileToDelete);
 
-  String path = "/" + fileToPlay + ".mp3";
   if (SPIFFS.exists(path) == false) {
-    httpNotFound(client, "File: " + path + " not found");
+    httpNotFound(conn, "File: %s not found", path);
+    conn.action = NONE;
     return;
   }
 
-  // let the sound board play the requested file
-  // TODO: initStartSound(fileToPlay);
+  // the sound playing now or downloaded now is deleted when it is over, the next loop tries again
+  if (httpDownloading(path) || !lockSoundFile(path)) {
+    return;
+  }
+  ESP_LOGI("Http download", "Delete file: %s", path);
 
-  client.println(httpHeaderOk);
-  client.println("Content-type: text/html");
-  client.println("Access-Control-Allow-Origin: *");
-  client.println();
-  client.println("Playing sound: " + fileToPlay);
-  client.println();
+  SPIFFS.remove(path);
+  Mp3IndexFile::remove(path);
+  soundCache.invalidate(path);
+  unlockSoundFile();
+  fileCatalogue.remove(path);
+
+  int len = snprintf(httpBody(), HTTP_TX_SIZE - HTTP_HEADER_ROOM, "File: %s deleted.\r\n", path);
+  httpRespond(conn, httpHeaderOk, "text/html", httpBody(), len);
+  conn.action = NONE;
+}
+
+void HttpServer::httpPlaySound(httpConnection_struct &conn, const char* fileToPlay) {
+
+  // /play/<sound> or /play/<sound>/<ms> to start that far into the sound
+  char name[HTTP_MAX_NAME + 1];
+  snprintf(name, sizeof(name), "%s", fileToPlay);
+  unsigned long startMs = 0;
+  char* start = strchr(name, '/');
+  if (start != NULL) {
+    *start++ = 0;
+    char* end;
+    startMs = strtoul(start, &end, 10);
+    if (*end != 0 || end == start) {
+      httpNotFound(conn, "Start: %s is no number", start);
+      return;
+    }
+  }
+
+  char path[HTTP_MAX_NAME + 6];
+  snprintf(path, sizeof(path), "/%s.mp3", name);
+  // the file list is in memory, the spiffs is only asked for files which are not in it
+  if (!fileCatalogue.contains(path) && SPIFFS.exists(path) == false) {
+    httpNotFound(conn, "File: %s not found", path);
+    return;
+  }
+
+  // the player task plays it, the sounds are numbered like the buttons
+  char* end;
+  unsigned long sound = strtoul(name, &end, 10);
+  if (*end != 0 || end == name || sound > 0xFFFF) {
+    httpNotFound(conn, "Sound: %s is no number", name);
+    return;
+  }
+  if (!playerPlay(sound, startMs, micros())) {
+    httpNotFound(conn, "Player is busy, sound: %s not played", name);
+    return;
+  }
+
+  int len = snprintf(httpBody(), HTTP_TX_SIZE - HTTP_HEADER_ROOM, "Playing sound: %s from %lu ms\r\n", name, startMs);
+  httpRespond(conn, httpHeaderOk, "text/html", httpBody(), len);
 }
 
-void HttpServer::httpRestart(WiFiClient client) {
+void HttpServer::httpRestart(httpConnection_struct &conn) {
 
   ESP_LOGI("Main", "Client wants to restart the board");
 
-  client.println(httpHeaderOk);
-  client.println("Content-type: text/html");
-  client.println("Access-Control-Allow-Origin: *");
-  client.println();
-  client.println("Restarting.");
-  client.println();
+  conn.keepAlive = false;
+  httpRespond(conn, httpHeaderOk, "text/html", "Restarting.\r\n", 13);
 
-  client.stop();
+  conn.client.stop();
 
   delay(1000);
 
   ESP.restart();
 }
 
-void HttpServer::httpUPloadFinished(WiFiClient client, String uploadedFile) {
-  ESP_LOGD("File", "Done writing: %s", uploadedFile.c_str());
+void HttpServer::httpUPloadFinished(httpConnection_struct &conn) {
+  const char* uploadedFile = conn.dataToHandle;
+
+  // throughput of the file data, from its first byte to the closing delimiter
+  uint32_t ms = conn.uploadEnd - conn.uploadStart;
+  uint32_t bytes = conn.uploadFilter.bytesIn;
+  uint32_t kbPerSec = (uint64_t) bytes * 1000 / 1024 / (ms > 0 ? ms : 1);
+  // the time the old file was still played
+  uint32_t waitMs = millis() - conn.uploadEnd;
+  ESP_LOGI("Http Upload", "Done writing: %s, %u bytes in %u ms, %u KB/s, replaced after %u ms", uploadedFile, bytes, ms, kbPerSec, waitMs);
+  ESP_LOGI("Http Upload", "Crc32 of %s is %08x, %u us for %u bytes", uploadedFile, conn.uploadCrc, conn.hashUs, conn.uploadBytes);
+
+  int len = snprintf(httpBody(), HTTP_TX_SIZE - HTTP_HEADER_ROOM, "{\"name\": \"%s\", \"size\": %u, \"saved\": %u, \"kbPerSec\": %u, \"waitMs\": %u, \"hash\": \"%08x\", \"hashUs\": %u}\r\n",
+                     uploadedFile, conn.uploadFilter.bytesOut, conn.uploadFilter.bytesIn - conn.uploadFilter.bytesOut, kbPerSec, waitMs,
+                     conn.uploadCrc, conn.hashUs);
+  httpRespond(conn, httpHeaderOk, "text/html", httpBody(), len);
+}
 
-  client.println(httpHeaderOk);
-  client.println("Content-type:text/html");
-  client.println();
+bool HttpServer::httpUploadData(httpConnection_struct &conn, const uint8_t* data, size_t len) {
+  conn.uploadParser.feed(data, len);
+  if (!conn.uploadParser.done()) {
+    return false;
+  }
 
-  client.print("{\"name\": \"" + uploadedFile + "\",");
-  client.print("size: ");
-  //client.println(uplPos);
-  client.println();
+  // the closing delimiter was found, whatever follows it is not read
+  if (!conn.uploadFile) {
+    if (conn.failure == NULL) {
+      conn.failure = conn.dataToHandle[0] == 0 ? "No file in upload" : "Could not write file: %s";
+    }
+    conn.action = FAILURE;
+    return true;
+  }
+
+  ESP_LOGD("Http Upload", "Found boundary end in request: %s", conn.uploadBoundary);
+  conn.uploadFilter.finish();
+  uploadFlush(conn);
+  conn.uploadFile.close();
+  conn.uploadEnd = millis();
+  ESP_LOGD("Http Upload", "Filtered %u tag and %u silent bytes", conn.uploadFilter.tagBytes, conn.uploadFilter.silentBytes);
+  // the index is renamed with the file
+  char temp[HTTP_MAX_NAME + 3];
+  snprintf(temp, sizeof(temp), UPLOAD_TEMP_PREFIX "%s", conn.dataToHandle);
+  Mp3IndexFile::write(temp, conn.uploadIndex);
+  conn.action = UPLOAD_DATA_END;
+  return true;
 }
 
-void HttpServer::httpGetInfo(WiFiClient client) {
-  client.println(httpHeaderOk);
-  client.println("Content-type:application/json");
-  client.println("Access-Control-Allow-Origin: *");
-  client.println();
+/**
+   Only sounds can be uploaded, a number and .mp3 or .wav, like the buttons play them.
+   Everything else on the spiffs belongs to the firmware, the hash list, the indexes and the temp files.
+*/
+static bool httpSoundFileName(const char* fileName) {
+  size_t digits = strspn(fileName, "0123456789");
+  if (digits == 0 || digits > 5) {
+    return false;
+  }
+  return strcmp(fileName + digits, ".mp3") == 0 || strcmp(fileName + digits, ".wav") == 0;
+}
 
-  client.println("{"); // main {}
+bool HttpServer::uploadPart(void* ctx, const char* fileName) {
+  httpConnection_struct* conn = (httpConnection_struct*) ctx;
+
+  // only the first file of the form is stored
+  if (conn->dataToHandle[0] != 0) {
+    return false;
+  }
 
-  client.print("\"version\" : \"");
-  client.print(VERSION);
-  client.println("\",");
+  snprintf(conn->dataToHandle, sizeof(conn->dataToHandle), "%s", fileName);
+  if (!httpSoundFileName(fileName)) {
+    ESP_LOGE("Http Upload", "Not a sound file: %s", fileName);
+    conn->failure = "Not a sound file: %s";
+    return false;
+  }
+  ESP_LOGD("Http Upload", "Filename is: %s", fileName);
+  conn->uploadFile = httpStartUpload(conn->dataToHandle);
+  if (!conn->uploadFile) {
+    ESP_LOGE("Http Upload", "Could not open file: %s", fileName);
+    return false;
+  }
+
+  conn->uploadIndex.reset();
+  conn->blockLen = 0;
+  conn->uploadStart = millis();
+  conn->uploadBytes = 0;
+  conn->uploadCrc = CRC32_INIT;
+  conn->hashUs = 0;
+
+  // only mp3 files are filtered, everything else is written as it is
+  size_t nameLen = strlen(conn->dataToHandle);
+  bool isMp3 = nameLen >= 4 && strcmp(conn->dataToHandle + nameLen - 4, ".mp3") == 0;
+  conn->uploadFilter.begin(isMp3 && UPLOAD_STRIP_TAGS, isMp3 && UPLOAD_TRIM_SILENCE, UPLOAD_SILENCE_GAIN, uploadWrite, conn);
+  return true;
+}
 
-  client.print("\"name\" : \"");
-  client.print(NAME);
-  client.println("\",");
+void HttpServer::uploadData(void* ctx, const uint8_t* data, size_t len) {
+  httpConnection_struct* conn = (httpConnection_struct*) ctx;
+  conn->uploadBytes += len;
 
-  client.print("\"freeMem\" : ");
-  client.print(ESP.getFreeHeap());
-  client.println(",");
+  // the hash is taken while the data comes in, the file is not read again
+  uint32_t start = micros();
+  conn->uploadCrc = crc32Update(conn->uploadCrc, data, len);
+  conn->hashUs += micros() - start;
 
-  client.print("\"flashSize\" : ");
-  client.print(ESP.getFlashChipSize());
-  client.println(",");
+  conn->uploadFilter.feed(data, len);
+}
+
+void HttpServer::uploadWrite(void* ctx, const uint8_t* data, size_t len) {
+  httpConnection_struct* conn = (httpConnection_struct*) ctx;
+  conn->uploadIndex.feed(data, len);
+
+  // the file only grows by whole blocks, so every write starts at a block border
+  while (len > 0) {
+    if (conn->blockLen == 0 && len >= HTTP_FILE_BLOCK) {
+      size_t whole = len - len % HTTP_FILE_BLOCK;
+      conn->uploadFile.write(data, whole);
+      data += whole;
+      len -= whole;
+      continue;
+    }
+
+    size_t chunk = HTTP_FILE_BLOCK - conn->blockLen;
+    if (chunk > len) {
+      chunk = len;
+    }
+    memcpy(conn->block + conn->blockLen, data, chunk);
+    conn->blockLen += chunk;
+    data += chunk;
+    len -= chunk;
+
+    if (conn->blockLen == HTTP_FILE_BLOCK) {
+      conn->uploadFile.write(conn->block, HTTP_FILE_BLOCK);
+      conn->blockLen = 0;
+    }
+  }
+}
+
+void HttpServer::uploadFlush(httpConnection_struct &conn) {
+  if (conn.blockLen > 0) {
+    conn.uploadFile.write(conn.block, conn.blockLen);
+    conn.blockLen = 0;
+  }
+}
+
+void HttpServer::httpBuildInfo() {
+  StreamString body;
+
+  body.println("{"); // main {}
+
+  body.print("\"version\" : \"");
+  body.print(VERSION);
+  body.println("\",");
+
+  body.print("\"name\" : \"");
+  body.print(NAME);
+  body.println("\",");
+
+  body.print("\"flashSize\" : ");
+  body.print(ESP.getFlashChipSize());
+  body.println(",");
 
   uint64_t chipid = ESP.getEfuseMac();
-  client.print("\"chipId\" : \"");
-  client.printf("%04X", (uint16_t)(chipid >> 32));
-  client.printf("%08X", (uint32_t)chipid);
-  client.println("\",");
-
-  client.print("\"macAddress\" : \"");
-  client.print(WiFi.macAddress());
-  client.println("\",");
-
-
-  client.println("\"files\" : ["); // files {}
-  File root = SPIFFS.open("/", FILE_READ);
-  File file = root.openNextFile();
-  String sep = "";
-  while (file) {
-    client.print(sep);
-    client.print("{\"name\" : \"");
-    client.print(file.name());
-    client.print("\",\"size\": ");
-    client.print(file.size());
-    client.println("}");
-    file.close();
+  body.print("\"chipId\" : \"");
+  body.printf("%04X", (uint16_t)(chipid >> 32));
+  body.printf("%08X", (uint32_t)chipid);
+  body.println("\",");
+
+  body.print("\"macAddress\" : \"");
+  body.print(WiFi.macAddress());
+  body.println("\",");
+
+  body.print("\"files\" : ");
+  fileCatalogue.printJson(body);
+  body.println();
+
+  body.println("}"); // eo main {}
+
+  infoBody = body;
+  httpEtag(infoBody, infoEtag);
+  infoGeneration = fileCatalogue.generation;
+}
+
+/**
+   fnv-1a of the body as a quoted etag, the same list gives the same tag after a restart
+*/
+void HttpServer::httpEtag(const String &body, char* etag) {
+  const char* data = body.c_str();
+  uint32_t hash = 2166136261UL;
+  for (unsigned int i = 0; i < body.length(); i++) {
+    hash = (hash ^ (uint8_t) data[i]) * 16777619UL;
+  }
+  snprintf(etag, 11, "\"%08x\"", hash);
+}
 
-    file = root.openNextFile();
-    sep = ",";
+/**
+   Answers with a body built from the file list, or with 304 when the client has it already
+*/
+void HttpServer::httpRespondCached(httpConnection_struct &conn, const String &body, const char* etag) {
+  if (strcmp(conn.ifNoneMatch, etag) == 0) {
+    int len = snprintf(tx, sizeof(tx), "%s\r\nETag: %s\r\n%s\r\n", httpHeaderNotModified, etag, httpConnectionHeader(conn));
+    conn.client.write((const uint8_t*) tx, len);
+    return;
   }
-  root.close();
 
-  client.println("]"); // eo file {}
+  char headers[48];
+  snprintf(headers, sizeof(headers), "ETag: %s\r\nCache-Control: no-cache\r\n", etag);
+  httpRespond(conn, httpHeaderOk, "application/json", body.c_str(), body.length(), headers);
+}
 
-  client.println("}"); // eo main {}
-  client.println();
+void HttpServer::httpGetInfo(httpConnection_struct &conn) {
+  if (infoBody == "" || infoGeneration != fileCatalogue.generation) {
+    httpBuildInfo();
+  }
+
+  // the client polls, most of the time nothing changed
+  httpRespondCached(conn, infoBody, infoEtag);
 }
 
-void HttpServer::httpServerLoop() {
-   // do we have a new client ?
-  WiFiClient client = wifiServer->available();
+void HttpServer::httpGetManifest(httpConnection_struct &conn) {
+  // the list may not fit into the buffer of the responses, it is only built again when it changed
+  if (manifestBody == "" || manifestGeneration != fileCatalogue.generation) {
+    StreamString body;
+    fileCatalogue.printManifest(body);
+    body.println();
+
+    manifestBody = body;
+    httpEtag(manifestBody, manifestEtag);
+    manifestGeneration = fileCatalogue.generation;
+  }
+
+  // a sync client asks before every upload
+  httpRespondCached(conn, manifestBody, manifestEtag);
+}
 
-  // no client ?
-  if (!client) {
+void HttpServer::httpGetStats(httpConnection_struct &conn) {
+  BufferPrint body(httpBody(), HTTP_TX_SIZE - HTTP_HEADER_ROOM);
+  printStats(body);
+  body.println();
+  if (body.overflow()) {
+    ESP_LOGW("Http", "Stats are cut at %u bytes", body.length());
+  }
+
+  httpRespond(conn, httpHeaderOk, "application/json", body.data(), body.length());
+}
+
+void HttpServer::httpOpenEvents(httpConnection_struct &conn) {
+  int clients = 0;
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].active && connections[i].action == EVENTS) {
+      clients++;
+    }
+  }
+  if (clients > EVENTS_MAX_CLIENTS) {
+    httpNotFound(conn, "Too many event clients");
+    conn.action = NONE;
     return;
   }
 
-  ESP_LOGD("Http", "new client connected %s", client.remoteIP().toString().c_str());
+  // the event stream has no length, it ends with the connection
+  conn.keepAlive = false;
+  int len = snprintf(tx, sizeof(tx), "%s\r\nContent-type: text/event-stream\r\nCache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n",
+                     httpHeaderOk);
+  conn.client.write((const uint8_t*) tx, len);
 
-  String currentLine = "";                // make a String to hold incoming data from the client
+  conn.eventAll = true;
+  conn.eventUploadBytes = 0;
+  conn.eventPush = millis() - EVENTS_MIN_INTERVAL_MS;
+  ESP_LOGI("Http events", "Client listens to the events");
+}
 
-  // the current action/state of the http client parser
-  httpClientAction = NONE;
+void HttpServer::httpEventsLoop() {
+  uint32_t now = millis();
+  boardStatus_struct status;
+  bool haveStatus = false;
 
-  // stores the upload boundary
-  String uploadBoundary = "";
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    httpConnection_struct &conn = connections[i];
+    if (!conn.active || conn.action != EVENTS || now - conn.eventPush < EVENTS_MIN_INTERVAL_MS) {
+      continue;
+    }
 
-  // some data we can handle after parsinf the request for example what file to play
-  String getDataToHandle = "";
+    // all clients get the same status
+    if (!haveStatus) {
+      readBoardStatus(status);
+      haveStatus = true;
+    }
+    httpPushEvents(conn, status, now);
+  }
+}
 
-  File uplFile;
+void HttpServer::httpPushEvents(httpConnection_struct &conn, const boardStatus_struct &status, uint32_t now) {
+  BufferPrint out(tx, sizeof(tx));
 
-  while (client.connected()) {            // loop while the client's connected
-    if (client.available()) {             // if there's bytes to read from the client,
-      char c = client.read();             // read a byte, then
+  if (conn.eventAll || status.sound != conn.eventSound || status.streaming != conn.eventStreaming) {
+    printFormatted(out, "event: sound\ndata: {\"sound\" : %d, \"streaming\" : %s}\n\n",
+                   status.sound, status.streaming ? "true" : "false");
+    conn.eventSound = status.sound;
+    conn.eventStreaming = status.streaming;
+  }
 
+  // the progress of an upload on another connection, 0 bytes when it ended
+  const httpConnection_struct* upload = NULL;
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS && upload == NULL; i++) {
+    if (connections[i].active && connections[i].action == UPLOAD_DATA_START && connections[i].uploadFile) {
+      upload = &connections[i];
+    }
+  }
+  uint32_t uploadBytes = upload == NULL ? 0 : upload->uploadBytes;
+  if (uploadBytes != conn.eventUploadBytes) {
+    printFormatted(out, "event: upload\ndata: {\"name\" : \"%s\", \"bytes\" : %u}\n\n",
+                   upload == NULL ? "" : upload->dataToHandle, uploadBytes);
+    conn.eventUploadBytes = uploadBytes;
+  }
 
-      // when we want to write the data write it to the file
-      if (httpClientAction == UPLOAD_DATA_START) {
-        uplFile.write(c);
-      }
+  // the list itself is too long for an event, the client gets it from /info when the etag changed
+  if (conn.eventAll || conn.eventGeneration != fileCatalogue.generation) {
+    if (infoBody == "" || infoGeneration != fileCatalogue.generation) {
+      httpBuildInfo();
+    }
+    printFormatted(out, "event: files\ndata: {\"generation\" : %u, \"etag\" : \"%.8s\"}\n\n",
+                   infoGeneration, infoEtag + 1);
+    conn.eventGeneration = infoGeneration;
+  }
 
-      if (c == '\n') {                    // if the byte is a newline character
+  if (conn.eventAll || now - conn.eventLevels >= EVENTS_LEVELS_INTERVAL_MS) {
+    printFormatted(out, "event: levels\ndata: {\"freeHeap\" : %u, \"minFreeHeap\" : %u, \"queue\" : %u}\n\n",
+                   status.freeHeap, status.minFreeHeap, status.queuePercent);
+    conn.eventLevels = now;
+  }
+  conn.eventAll = false;
 
-        // client wants to play a sound on the sound board
-        if (currentLine.startsWith("GET /play/") && httpClientAction == NONE) {
+  if (out.length() == 0) {
+    return;
+  }
+  conn.eventPush = now;
 
-          ESP_LOGD("Http", "Client wants to play a sound from the board");
+  // a client which does not take a few hundred bytes is gone or too slow for the events
+  if (conn.client.write((const uint8_t*) out.data(), out.length()) != out.length()) {
+    ESP_LOGD("Http events", "Client does not take the events");
+    httpCloseConnection(conn);
+  }
+}
 
-          // get rid of the HTTP
-          getDataToHandle = currentLine;
-          getDataToHandle.replace(" HTTP/1.1", "");
-          getDataToHandle.replace("GET /play/", "");
-          httpClientAction = PLAY;
+void HttpServer::httpServerLoop() {
+  // take new clients while a connection is free, the others wait in the backlog
+  while (true) {
+    httpConnection_struct* conn = NULL;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS && conn == NULL; i++) {
+      if (!connections[i].active) {
+        conn = &connections[i];
+      }
+    }
+
+    // an idle persistent connection gives its place to a new client
+    httpConnection_struct* idle = NULL;
+    if (conn == NULL) {
+      for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        if (httpIdle(connections[i]) && (idle == NULL || (int32_t) (connections[i].lastActivity - idle->lastActivity) < 0)) {
+          idle = &connections[i];
         }
+      }
+      if (idle == NULL) {
+        break;
+      }
+    }
 
-        // client wants to download mp3
-        if (currentLine.startsWith("GET /download/") && httpClientAction == NONE) {
-          ESP_LOGD("Http", "Client wants to download a sound from the board");
+    WiFiClient client = wifiServer->available();
+    if (!client) {
+      break;
+    }
 
-          // get rid of the HTTP
-          getDataToHandle = currentLine;
-          getDataToHandle.replace(" HTTP/1.1", "");
-          getDataToHandle.replace("GET /download/", "");
+    if (idle != NULL) {
+      ESP_LOGD("Http", "Closing idle connection for a new client");
+      httpCloseConnection(*idle);
+      conn = idle;
+    }
 
-          httpClientAction = DOWNLOAD;
-        }
+    ESP_LOGD("Http", "new client connected %s", client.remoteIP().toString().c_str());
+    httpOpenConnection(*conn, client);
+  }
 
-        // client wants to delete a file
-        if (currentLine.startsWith("GET /delete/") && httpClientAction == NONE) {
-          ESP_LOGD("Http", "Client wants to delete a file from the board");
+  // every connection gets a bounded piece of work
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].active) {
+      httpConnectionLoop(connections[i]);
+    }
+  }
 
-          // get rid of the HTTP
-          getDataToHandle = currentLine;
-          getDataToHandle.replace(" HTTP/1.1", "");
-          getDataToHandle.replace("GET /delete/", "");
+  httpEventsLoop();
+}
 
-          httpClientAction = DELETE;
-        }
+void HttpServer::httpOpenConnection(httpConnection_struct &conn, WiFiClient &client) {
+  conn.client = client;
+  // small responses go out at once instead of waiting for more data
+  conn.client.setNoDelay(true);
+  conn.active = true;
+  conn.requests = 0;
+  conn.rxPos = 0;
+  conn.rxLen = 0;
+  httpNextRequest(conn);
+}
 
-        // client wants some info about this board
-        if (currentLine.startsWith("GET /info") && httpClientAction == NONE) {
-          httpClientAction = INFO;
-        }
+void HttpServer::httpNextRequest(httpConnection_struct &conn) {
+  conn.action = NONE;
+  conn.keepAlive = false;
+  conn.lineLen = 0;
+  conn.uploadBoundary[0] = 0;
+  conn.dataToHandle[0] = 0;
+  conn.failure = NULL;
+  conn.range[0] = 0;
+  conn.ifNoneMatch[0] = 0;
+  conn.bodyLeft = 0;
+  conn.chunkedBody = false;
+  conn.lastActivity = millis();
+}
 
-        // client wants to restart this board
-        if (currentLine.startsWith("GET /restart") && httpClientAction == NONE) {
-          httpClientAction = RESTART;
-        }
+bool HttpServer::httpDownloading(const char* path) {
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    httpConnection_struct &conn = connections[i];
+    // a download sends /<dataToHandle>.mp3
+    if (conn.active && conn.action == SENDING) {
+      size_t len = strlen(conn.dataToHandle);
+      if (path[0] == '/' && strncmp(path + 1, conn.dataToHandle, len) == 0 && strcmp(path + 1 + len, ".mp3") == 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
 
+bool HttpServer::httpIdle(httpConnection_struct &conn) {
+  return conn.active && conn.requests > 0 && conn.action == NONE && conn.lineLen == 0 && conn.rxPos == conn.rxLen;
+}
 
+void HttpServer::httpFinishRequest(httpConnection_struct &conn) {
+  if (conn.keepAlive) {
+    httpNextRequest(conn);
+  } else {
+    httpCloseConnection(conn);
+  }
+}
 
-        // client wants to upload a file
-        if (currentLine.startsWith("POST /upload") && httpClientAction == NONE) { // upload initialized
-          httpClientAction = UPLOAD_INIT;
-        }
+void HttpServer::httpCloseConnection(httpConnection_struct &conn) {
+  // an upload which did not finish is dropped, the old file stays
+  if (conn.uploadFile) {
+    conn.uploadFile.close();
+    char temp[HTTP_MAX_NAME + 3];
+    snprintf(temp, sizeof(temp), UPLOAD_TEMP_PREFIX "%s", conn.dataToHandle);
+    SPIFFS.remove(temp);
+  }
+  if (conn.downloadFile) {
+    conn.downloadFile.close();
+  }
+  // the player plays what it got of the stream
+  if (conn.action == STREAMING) {
+    streamEnd();
+    conn.action = NONE;
+  }
 
-        // client wants to upload a file and we found a boundary
-        if (currentLine.startsWith("content-type: multipart/form-data; boundary=") && httpClientAction == UPLOAD_INIT) {
-          uploadBoundary = "--" + currentLine.substring(44);
-          ESP_LOGD("Http Upload", "Found boundary: %s", uploadBoundary.c_str());
-          httpClientAction = UPLOAD_BOUNDARY_INIT;
+  conn.client.stop();
+  conn.active = false;
+  conn.lineLen = 0;
+  conn.rxPos = 0;
+  conn.rxLen = 0;
+  ESP_LOGD("Http", "Client Disconnected.");
+}
 
-        }
+void HttpServer::httpConnectionLoop(httpConnection_struct &conn) {
+  if (conn.action == SENDING) {
+    httpSendFile(conn);
+    return;
+  }
+
+  if (conn.action == STREAMING) {
+    httpStreamData(conn);
+    return;
+  }
+
+  // a client of the events sends nothing more, it is only checked that it is still there
+  if (conn.action == EVENTS) {
+    if (conn.client.available() > 0) {
+      conn.client.read(conn.rx, sizeof(conn.rx));
+    } else if (!conn.client.connected()) {
+      ESP_LOGD("Http events", "Client stopped listening");
+      httpCloseConnection(conn);
+    }
+    return;
+  }
+
+  // the upload is complete, the player still reads the old file
+  if (conn.action == UPLOAD_DATA_END) {
+    httpCommitUpload(conn);
+    if (conn.action != UPLOAD_DATA_END) {
+      httpFinishRequest(conn);
+    }
+    return;
+  }
+
+  // the file to delete was played
+  if (conn.action == DELETE) {
+    httpDeleteFile(conn, conn.dataToHandle);
+    if (conn.action != DELETE) {
+      httpFinishRequest(conn);
+    }
+    return;
+  }
+
+  // pipelined requests which came with the last one are parsed first
+  if (conn.rxPos == conn.rxLen) {
+    int avail = conn.client.available();
+    if (avail <= 0) {
+      // a persistent connection between two requests has a shorter timeout
+      uint32_t timeout = httpIdle(conn) ? HTTP_KEEPALIVE_TIMEOUT_MS : HTTP_TIMEOUT_MS;
+      if (!conn.client.connected()) {
+        httpCloseConnection(conn);
+      } else if (millis() - conn.lastActivity > timeout) {
+        ESP_LOGD("Http", "Client timed out");
+        httpCloseConnection(conn);
+      }
+      return;
+    }
+
+    int len = conn.client.read(conn.rx, avail < (int) sizeof(conn.rx) ? avail : sizeof(conn.rx));
+    if (len <= 0) {
+      return;
+    }
+    conn.rxPos = 0;
+    conn.rxLen = len;
+  }
+  conn.lastActivity = millis();
+
+  // the next requests wait in rx until the response of this one is sent
+  size_t used = httpConsume(conn, conn.rx + conn.rxPos, conn.rxLen - conn.rxPos);
+  if (conn.active) {
+    conn.rxPos += used;
+  }
+}
+
+size_t HttpServer::httpConsume(httpConnection_struct &conn, const uint8_t* data, size_t len) {
+  if (conn.action == UPLOAD_DATA_START) {
+    if (httpUploadData(conn, data, len)) {
+      httpHandleRequest(conn);
+    }
+    return len;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
 
-        // the upload boundary actualy exists in the request
-        if (currentLine.startsWith(uploadBoundary) && httpClientAction == UPLOAD_BOUNDARY_INIT) {
-          ESP_LOGD("Http Upload", "Found boundary in request: %s", uploadBoundary.c_str());
-          httpClientAction = UPLOAD_BOUNDARY_FOUND;
+    if (c == '\n') {                    // if the byte is a newline character
+      conn.currentLine[conn.lineLen] = 0;
+      if (httpParseLine(conn)) {
+        // the request is complete, pipelined requests are handled in order
+        httpHandleRequest(conn);
+        if (!conn.active || conn.action == SENDING || conn.action == DELETE || conn.action == EVENTS) {
+          return i + 1;
         }
+        continue;
+      }
+      conn.lineLen = 0; // empty the current line
+
+      // the rest of the block is the start of the stream body, it is played from rx
+      if (conn.action == STREAMING) {
+        return i + 1;
+      }
 
-        // the upload file  name has to be parsed
-        if (currentLine.startsWith("Content-Disposition: form-data; name=\"file\"; filename=") && httpClientAction == UPLOAD_BOUNDARY_FOUND) {
-          getDataToHandle = currentLine.substring(55, currentLine.length() - 1);
-          ESP_LOGD("Http Upload", "Filename is: %s", getDataToHandle.c_str());
-          uplFile = httpStartUpload(getDataToHandle);
-          httpClientAction = UPLOAD_FILE_NAME_FOUND;
+      // the rest of the block is the start of the upload body, uploads close the connection
+      if (conn.action == UPLOAD_DATA_START) {
+        if (httpUploadData(conn, data + i + 1, len - i - 1)) {
+          httpHandleRequest(conn);
         }
+        return len;
+      }
+    } else if (c != '\r' && conn.lineLen < HTTP_MAX_LINE) {  // if you got anything else but a carriage return character,
+      conn.currentLine[conn.lineLen++] = c;      // add it to the end of the currentLine
+    }
+  }
+  return len;
+}
 
-        // after parsing the name and finding the first empty line we can start reading the data
-        if (currentLine == "" && httpClientAction == UPLOAD_FILE_NAME_FOUND) {
-          ESP_LOGD("Http Upload", "Starting reading the data");
-          httpClientAction = UPLOAD_DATA_START;
+/**
+   Copies the view of a line into a buffer of the connection, returns false and leaves it empty when it does not fit
+*/
+static bool httpViewCopy(char* to, size_t size, const httpView_struct &view) {
+  if (view.len >= size) {
+    to[0] = 0;
+    return false;
+  }
+  memcpy(to, view.data, view.len);
+  to[view.len] = 0;
+  return true;
+}
+
+bool HttpServer::httpParseLine(httpConnection_struct &conn) {
+  const char* line = conn.currentLine;
+  size_t len = conn.lineLen;
+
+  // the request line selects the action
+  if (conn.action == NONE) {
+    // empty lines before a request are ignored
+    if (len == 0) {
+      return false;
+    }
+    ESP_LOGD("Http", "Client send line: %s", line);
+
+    httpRequestLine_struct request;
+    if (!httpParseRequestLine(line, len, request)) {
+      conn.failure = "Bad Request";
+      conn.action = FAILURE;
+      return false;
+    }
+
+    // only http/1.1 get requests stay open, the bodies of other requests are not always read to their end
+    conn.keepAlive = request.http11 && request.method.len == 3 && memcmp(request.method.data, "GET", 3) == 0;
+
+    const httpRoute_struct* route = httpFindRoute(request);
+    if (route == NULL) {
+      // none of the action matches
+      conn.failure = "Not Found";
+      conn.action = FAILURE;
+      return false;
+    }
+
+    if (route->param && !httpViewCopy(conn.dataToHandle, sizeof(conn.dataToHandle), request.param)) {
+      conn.failure = "Name too long";
+      conn.action = FAILURE;
+      return false;
+    }
+    conn.action = route->action;
+    return false;
+  }
+
+  if (len > 0) {
+    httpView_struct value;
+    switch (httpParseHeader(line, len, value)) {
+      case HEADER_CONNECTION:
+        // the client may not want the connection to stay open
+        if (httpViewContains(value, "close")) {
+          conn.keepAlive = false;
         }
+        break;
 
+      case HEADER_CONTENT_TYPE: {
+        // client wants to upload a file and we found a boundary
+        httpView_struct boundary;
+        if (conn.action == UPLOAD_INIT && httpFindBoundary(value, boundary)) {
+          // a boundary too long stays empty, the parser does not take it
+          httpViewCopy(conn.uploadBoundary, sizeof(conn.uploadBoundary), boundary);
+          ESP_LOGD("Http Upload", "Found boundary: %s", conn.uploadBoundary);
+          conn.action = UPLOAD_BOUNDARY_INIT;
+        }
+        break;
+      }
 
-        // no more data to read
-        if (currentLine.startsWith(uploadBoundary) && httpClientAction == UPLOAD_DATA_START) {
-          ESP_LOGD("Http Upload", "Found boundary end in request: %s", uploadBoundary.c_str());
-          //uplFile.flush();
-          uplFile.close();
-          httpClientAction = UPLOAD_DATA_END;
+      case HEADER_RANGE:
+        // a download may only want a part of the file
+        if (conn.action == DOWNLOAD) {
+          httpViewCopy(conn.range, sizeof(conn.range), value);
         }
+        break;
+
+      case HEADER_CONTENT_LENGTH:
+        if (conn.action == STREAM) {
+          conn.bodyLeft = 0;
+          for (size_t i = 0; i < value.len && value.data[i] >= '0' && value.data[i] <= '9'; i++) {
+            conn.bodyLeft = conn.bodyLeft * 10 + value.data[i] - '0';
+          }
+        }
+        break;
 
-        // not a valid request with get or post
-        if ((currentLine.startsWith("GET") || currentLine.startsWith("POST")) && httpClientAction == NONE) {
-          // none of the action matches
-          getDataToHandle = "Not Found";
-          httpClientAction = FAILURE;
+      case HEADER_TRANSFER_ENCODING:
+        if (conn.action == STREAM && httpViewContains(value, "chunked")) {
+          conn.chunkedBody = true;
         }
+        break;
 
-        // debug request
-        if (httpClientAction != UPLOAD_DATA_START && httpClientAction != FAILURE) {
-          ESP_LOGD("Http", "Client send line: %s", currentLine.c_str());
+      case HEADER_IF_NONE_MATCH:
+        // the client already has the info or the manifest, they are only sent again when they changed
+        if (conn.action == INFO || conn.action == MANIFEST) {
+          httpViewCopy(conn.ifNoneMatch, sizeof(conn.ifNoneMatch), value);
         }
+        break;
 
-        currentLine = ""; // empty the current line
-      } else if (c != '\r') {  // if you got anything else but a carriage return character,
-        currentLine += c;      // add it to the end of the currentLine
-      }
+      default:
+        break;
+    }
 
-    } else { // no more data from the client
-      if (httpClientAction == PLAY) {
-        httpPlaySound(client, getDataToHandle);
-      }
+    // debug request
+    if (conn.action != FAILURE) {
+      ESP_LOGD("Http", "Client send line: %s", line);
+    }
+    return false;
+  }
 
-      if (httpClientAction == INFO) {
-        httpGetInfo(client);
-      }
+  // the empty line after the headers ends all requests except the uploads
+  if (conn.action == UPLOAD_INIT) {
+    conn.failure = "No upload boundary";
+    conn.action = FAILURE;
+  }
 
-      if (httpClientAction == DOWNLOAD) {
-        httpDownloadMp3(client, getDataToHandle);
+  // the body of the upload is parsed as blocks
+  if (conn.action == UPLOAD_BOUNDARY_INIT) {
+    if (conn.uploadParser.begin(conn.uploadBoundary, uploadPart, uploadData, &conn)) {
+      ESP_LOGD("Http Upload", "Starting reading the data");
+      conn.dataToHandle[0] = 0;
+      conn.action = UPLOAD_DATA_START;
+    } else {
+      conn.failure = "Invalid upload boundary";
+      conn.action = FAILURE;
+    }
+  }
+  // the body of the stream is played while it comes in
+  if (conn.action == STREAM) {
+    if (!conn.chunkedBody && conn.bodyLeft == 0) {
+      conn.failure = "No stream body";
+      conn.action = FAILURE;
+    } else if (!streamBegin()) {
+      conn.failure = "Another stream is playing";
+      conn.action = FAILURE;
+    } else {
+      ESP_LOGI("Http stream", "Playing the stream");
+      if (conn.chunkedBody) {
+        conn.bodyLeft = 0;
+        httpChunkedBegin(conn.chunked);
       }
+      conn.streamStart = millis();
+      conn.streamBytes = 0;
+      conn.action = STREAMING;
+    }
+  }
+  return conn.action != UPLOAD_DATA_START && conn.action != STREAMING;
+}
 
-      if (httpClientAction == UPLOAD_DATA_END) {
-        httpUPloadFinished(client, getDataToHandle);
-      }
+void HttpServer::httpHandleRequest(httpConnection_struct &conn) {
+  // the last request on a connection says so in its response
+  if (++conn.requests >= HTTP_KEEPALIVE_MAX) {
+    conn.keepAlive = false;
+  }
 
-      if (httpClientAction == DELETE) {
-        httpDeleteFile(client, getDataToHandle);
-      }
+  if (conn.action == PLAY) {
+    httpPlaySound(conn, conn.dataToHandle);
+  }
 
-      if (httpClientAction == FAILURE) {
-        httpNotFound(client, getDataToHandle);
-      }
+  if (conn.action == INFO) {
+    httpGetInfo(conn);
+  }
 
-      if (httpClientAction == RESTART) {
-        httpRestart(client);
-      }
+  if (conn.action == DOWNLOAD) {
+    httpDownloadMp3(conn, conn.dataToHandle);
+  }
 
-      break; // exit the main client loop
-    }
+  if (conn.action == UPLOAD_DATA_END) {
+    httpCommitUpload(conn);
+  }
+
+  if (conn.action == DELETE) {
+    httpDeleteFile(conn, conn.dataToHandle);
+  }
+
+  if (conn.action == FAILURE) {
+    httpNotFound(conn, conn.failure, conn.dataToHandle);
+  }
+
+  if (conn.action == RESTART) {
+    httpRestart(conn);
   }
 
-  // close the connection:
-  client.stop();
-  ESP_LOGD("Http", "Client Disconnected.");  
-}
\ No newline at end of file
+  if (conn.action == STATS) {
+    httpGetStats(conn);
+  }
+
+  if (conn.action == MANIFEST) {
+    httpGetManifest(conn);
+  }
+
+  if (conn.action == EVENTS) {
+    httpOpenEvents(conn);
+  }
+
+  // a download goes on in the next loops, an upload or a delete may wait for the player, the events go on until the client leaves
+  if (conn.action != SENDING && conn.action != UPLOAD_DATA_END && conn.action != DELETE && conn.action != EVENTS) {
+    httpFinishRequest(conn);
+  }
+}
@@ -6,29 +6,76 @@
 #include <FS.h>
 #include <SPIFFS.h>
 #include "Configuration.h"
+#include "Mp3FrameIndex.h"
+#include "Mp3UploadFilter.h"
+#include "MultipartParser.h"
+#include "HttpRoutes.h"
+#include "BoardStats.h"
 
 
 
-// the action a http client wants to perform
-enum httpClientAction_t {
-  NONE = 1,
-  FAILURE = 2,
-  PLAY = 3,
-  INFO = 4,
-  UPLOAD_INIT = 5,
-  UPLOAD_BOUNDARY_INIT = 6,
-  UPLOAD_BOUNDARY_FOUND = 7,
-  UPLOAD_FILE_NAME_FOUND = 8,
-  UPLOAD_DATA_START = 9,
-  UPLOAD_DATA_END = 10,
-  DOWNLOAD = 11,
-  DELETE = 12,
-  RESTART = 13
+// one client, its request is parsed a chunk per loop
+struct httpConnection_struct {
+  WiFiClient client;
+  bool active = false;
+  bool keepAlive = false;               // the connection stays open after the response
+  uint16_t requests = 0;                // requests handled on this connection
+  httpClientAction_t action = NONE;     // the current action/state of the http client parser
+  char currentLine[HTTP_MAX_LINE + 1];  // line of the request read so far
+  uint16_t lineLen = 0;                 // bytes in currentLine
+  char uploadBoundary[MULTIPART_MAX_BOUNDARY + 3];  // boundary of the multipart upload, may be quoted
+  char dataToHandle[HTTP_MAX_NAME + 1]; // what the request wants, for example what file to play
+  const char* failure = NULL;           // why the request failed, a format for dataToHandle
+  uint32_t lastActivity = 0;            // millis() when data came in or went out
+
+  uint8_t rx[HTTP_CHUNK_SIZE];          // data read from the client, pipelined requests wait here
+  uint16_t rxPos = 0;                   // bytes of rx already parsed
+  uint16_t rxLen = 0;                   // bytes in rx
+
+  // splits the upload body into its parts, passes on the data of the file
+  MultipartParser uploadParser;
+  // index of the mp3 frames of the upload, built while the data streams in
+  Mp3FrameIndex uploadIndex;
+  // strips tags and leading silence of the upload before it is written
+  Mp3UploadFilter uploadFilter;
+  File uploadFile;                      // the temp file the upload is written to
+  uint32_t uploadStart = 0;             // millis() when the file data began
+  uint32_t uploadEnd = 0;               // millis() when the file data was complete
+  uint32_t uploadBytes = 0;             // bytes of the file part received so far
+  uint32_t uploadCrc = 0;               // crc32 of the file part received so far, as the client sent it
+  uint32_t hashUs = 0;                  // micros() spent on the crc32
+
+  uint32_t bodyLeft = 0;                // bytes of the stream body or of its current chunk still to read
+  bool chunkedBody = false;             // the stream body comes with Transfer-Encoding: chunked
+  httpChunked_struct chunked;           // decoder of a chunked body
+  uint32_t streamStart = 0;             // millis() when the stream body began
+  uint32_t streamBytes = 0;             // bytes of the stream body played
+
+  File downloadFile;                    // file streamed while SENDING
+  char range[32];                       // range header of the download
+  char ifNoneMatch[16];                 // etag the client already has
+  uint32_t sendLeft = 0;                // bytes of the download still to read from the file
+
+  // what a client of /events was sent last
+  bool eventAll = false;                // the next push sends the whole status
+  int eventSound = -1;
+  bool eventStreaming = false;
+  uint32_t eventGeneration = 0;         // generation of the file list
+  uint32_t eventUploadBytes = 0;
+  uint32_t eventPush = 0;               // millis() of the last push
+  uint32_t eventLevels = 0;             // millis() of the last heap and queue levels
+
+  uint8_t block[HTTP_FILE_BLOCK];       // file data on its way between the client and the spiffs
+  uint16_t blockLen = 0;                // bytes in the block
+  uint16_t blockPos = 0;                // bytes of the block already sent
 };
 
 
-const String httpHeaderOk = "HTTP/1.1 200 Ok";
-const String httpHeaderFailure = "HTTP/1.1 404 Not Found";
+const char httpHeaderOk[] = "HTTP/1.1 200 Ok";
+const char httpHeaderPartial[] = "HTTP/1.1 206 Partial Content";
+const char httpHeaderBadRange[] = "HTTP/1.1 416 Range Not Satisfiable";
+const char httpHeaderNotModified[] = "HTTP/1.1 304 Not Modified";
+const char httpHeaderFailure[] = "HTTP/1.1 404 Not Found";
 
 
 
@@ -48,47 +95,206 @@ class HttpServer {
     private:       
 
       /**
-       * Handles a not found request
+       * Handles a not found request, the reason is a printf format
+      */
+      void httpNotFound(httpConnection_struct &conn, const char* reason, ...) __attribute__((format(printf, 3, 4)));
+
+      /**
+       * Sends a complete response with its length, the body may already be in httpBody()
+      */
+      void httpRespond(httpConnection_struct &conn, const char* status, const char* contentType, const char* body, size_t bodyLen, const char* headers = "");
+
+      /**
+       * Where the body of a response is formatted, behind the room for its header
       */
-      void httpNotFound(WiFiClient client, String reason);
+      char* httpBody() {
+        return tx + HTTP_HEADER_ROOM;
+      }
+
+      /**
+       * The connection header of the response
+      */
+      const char* httpConnectionHeader(httpConnection_struct &conn);
+
+      char tx[HTTP_TX_SIZE];              // responses are formatted here, they are sent before the next one
+      char keepAliveHeader[64];           // connection header of a persistent connection
 
       /**
        * Is called when the upload begins.
-       * Removes th old file and opens the new file for writing
+       * Opens the temp file of the upload for writing, the old file stays until the upload is complete
+      */
+      static File httpStartUpload(const char* uploadedFile);
+
+      /**
+       * Replaces the old file with the complete upload and answers the client.
+       * Waits for the next loop while the player still reads the old file.
       */
-      File httpStartUpload(String uploadedFile);
+      void httpCommitUpload(httpConnection_struct &conn);
 
       /**
       * Handles the download of the given mp3
       */
-      void httpDownloadMp3(WiFiClient client, String fileToDownload);
+      void httpDownloadMp3(httpConnection_struct &conn, const char* fileToDownload);
+
+      /**
+      * Sends the next block of the download, as much as the socket takes
+      */
+      void httpSendFile(httpConnection_struct &conn);
+
+      /**
+      * Passes the body of a stream to the player, as much as its buffer takes
+      */
+      void httpStreamData(httpConnection_struct &conn);
 
       /**
        * Handles delete request
       */
-      void httpDeleteFile(WiFiClient client, String fileToDelete);
+      void httpDeleteFile(httpConnection_struct &conn, const char* fileToDelete);
 
       /**
         * Handles the request to play a sound
       */
-      void httpPlaySound(WiFiClient client, String fileToPlay);
+      void httpPlaySound(httpConnection_struct &conn, const char* fileToPlay);
 
       /**
       * Client wants to restart the esp
       */
-      void httpRestart(WiFiClient client);
+      void httpRestart(httpConnection_struct &conn);
 
       /**
       *  When the upload was a success
       */     
-      void httpUPloadFinished(WiFiClient client, String uploadedFile);
+      void httpUPloadFinished(httpConnection_struct &conn);
 
       /**
        * Displays the info to the client
       */
-      void httpGetInfo(WiFiClient client);
+      void httpGetInfo(httpConnection_struct &conn);
+
+      /**
+       * Builds the body of the info again when the file list changed
+      */
+      void httpBuildInfo();
+
+      String infoBody;                    // the info as it is sent
+      char infoEtag[11] = "";             // etag of infoBody
+      uint32_t infoGeneration = 0;        // generation of the file list infoBody was built from
+
+      /**
+       * Writes the quoted etag of the body into etag, which holds 11 chars
+      */
+      static void httpEtag(const String &body, char* etag);
+
+      /**
+       * Sends the body with its etag, or 304 when the client has it
+      */
+      void httpRespondCached(httpConnection_struct &conn, const String &body, const char* etag);
+
+      /**
+       * Sends name, size and crc32 of all files, a sync client uploads only what changed
+      */
+      void httpGetManifest(httpConnection_struct &conn);
+
+      String manifestBody;                // the manifest as it is sent
+      char manifestEtag[11] = "";         // etag of manifestBody
+      uint32_t manifestGeneration = 0;    // generation of the file list manifestBody was built from
+
+      /**
+       * Displays the runtime statistics to the client
+      */
+      void httpGetStats(httpConnection_struct &conn);
+
+      /**
+       * Answers /events with the header of an event stream, the connection stays open for the pushes
+      */
+      void httpOpenEvents(httpConnection_struct &conn);
+
+      /**
+       * Pushes what changed to the clients of /events, at most once per EVENTS_MIN_INTERVAL_MS
+      */
+      void httpEventsLoop();
 
-      httpClientAction_t httpClientAction = NONE;      
+      /**
+       * Sends the events of the changes since the last push in one write
+      */
+      void httpPushEvents(httpConnection_struct &conn, const boardStatus_struct &status, uint32_t now);
+
+      /**
+       * Starts serving a new client
+      */
+      void httpOpenConnection(httpConnection_struct &conn, WiFiClient &client);
+
+      /**
+       * Closes the connection and its files
+      */
+      void httpCloseConnection(httpConnection_struct &conn);
+
+      /**
+       * Gets a persistent connection ready for the next request
+      */
+      void httpNextRequest(httpConnection_struct &conn);
+
+      /**
+       * Keeps the connection open or closes it after a response
+      */
+      void httpFinishRequest(httpConnection_struct &conn);
+
+      /**
+       * A persistent connection waiting for its next request
+      */
+      bool httpIdle(httpConnection_struct &conn);
+
+      /**
+       * A download of another connection still reads the file
+      */
+      bool httpDownloading(const char* path);
+
+      /**
+       * Reads and parses the next chunk of the request, does not wait for data
+      */
+      void httpConnectionLoop(httpConnection_struct &conn);
+
+      /**
+       * Parses data of the client, returns how much was used before a response has to be sent first
+      */
+      size_t httpConsume(httpConnection_struct &conn, const uint8_t* data, size_t len);
+
+      /**
+       * Handles a complete line of the request, returns true when the request is complete
+      */
+      bool httpParseLine(httpConnection_struct &conn);
+
+      /**
+       * Answers a complete request
+      */
+      void httpHandleRequest(httpConnection_struct &conn);
+
+      httpConnection_struct connections[HTTP_MAX_CONNECTIONS];
+
+      /**
+       * Feeds a block of the upload body to the multipart parser, returns true when the upload is complete
+      */
+      bool httpUploadData(httpConnection_struct &conn, const uint8_t* data, size_t len);
+
+      /**
+       * A file part of the upload begins, opens the file
+      */
+      static bool uploadPart(void* ctx, const char* fileName);
+
+      /**
+       * Passes the data of the file part through the filter
+      */
+      static void uploadData(void* ctx, const uint8_t* data, size_t len);
+
+      /**
+       * Writes the filtered upload data to the file and the index
+      */
+      static void uploadWrite(void* ctx, const uint8_t* data, size_t len);
+
+      /**
+       * Writes what is left in the block of the upload
+      */
+      static void uploadFlush(httpConnection_struct &conn);
 
     
 };
@@ -0,0 +1,96 @@
+#include <string.h>
+
+#include "LatencyStats.h"
+
+/**
+   Constuctor
+*/
+LatencyHistogram::LatencyHistogram() {
+  reset();
+}
+
+void LatencyHistogram::reset() {
+  memset(_buckets, 0, sizeof(_buckets));
+  _count = 0;
+  _max = 0;
+}
+
+/**
+   Values below 2^LATENCY_SUB_BITS get a bucket each, above that every power of two
+   gets 2^LATENCY_SUB_BITS buckets, which keeps the relative error below 25%.
+*/
+uint16_t LatencyHistogram::bucketOf(uint32_t us) {
+  if (us < (1UL << LATENCY_SUB_BITS)) {
+    return us;
+  }
+  uint8_t msb = 31 - __builtin_clz(us);
+  uint8_t sub = (us >> (msb - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1);
+  return ((msb - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(uint16_t bucket) {
+  if (bucket < (1 << LATENCY_SUB_BITS)) {
+    return bucket;
+  }
+  uint8_t msb = (bucket >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+  uint32_t sub = bucket & ((1 << LATENCY_SUB_BITS) - 1);
+  uint64_t lower = (1ULL << msb) + (sub << (msb - LATENCY_SUB_BITS));
+  uint64_t upper = lower + (1ULL << (msb - LATENCY_SUB_BITS)) - 1;
+  return upper > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t) upper;
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  _buckets[bucketOf(us)]++;
+  _count++;
+  if (us > _max) {
+    _max = us;
+  }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t p) const {
+  if (_count == 0) {
+    return 0;
+  }
+
+  // rank of the sample we are looking for, rounded up
+  uint32_t rank = ((uint64_t) _count * p + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  uint32_t seen = 0;
+  for (uint16_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += _buckets[i];
+    if (seen >= rank) {
+      uint32_t upper = bucketUpperBound(i);
+      // the max is exact, the bucket bound not
+      return upper > _max ? _max : upper;
+    }
+  }
+  return _max;
+}
+
+
+/**
+   Constuctor
+*/
+LatencyTracker::LatencyTracker() : _startUs(0), _pending(0) {
+}
+
+void LatencyTracker::start(uint32_t nowUs) {
+  _startUs.store(nowUs, std::memory_order_relaxed);
+  _pending.store((1UL << STAGE_COUNT) - 1, std::memory_order_release);
+}
+
+const char* LatencyTracker::stageName(latencyStage_t stage) {
+  switch (stage) {
+    case STAGE_OPENED:
+      return "opened";
+    case STAGE_QUEUED:
+      return "queued";
+    case STAGE_PLAYED:
+      return "played";
+    default:
+      return "unknown";
+  }
+}
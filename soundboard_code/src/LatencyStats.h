@@ -0,0 +1,96 @@
+/**
+   Measures the time from a button press to the sound coming out of the vs1053.
+   Every stage of a trigger has a fixed size histogram with logarithmic buckets, recording a
+   sample is a few instructions so this can stay on in production builds.
+   Does not depend on the arduino core so it can be used in host side tests.
+*/
+#ifndef LATENCYSTATS_h
+#define LATENCYSTATS_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// every power of two is split into this many sub buckets (2^LATENCY_SUB_BITS)
+#define LATENCY_SUB_BITS 2
+#define LATENCY_BUCKETS ((32 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+class LatencyHistogram {
+
+  public:
+    LatencyHistogram();
+
+    // Adds a sample in micro seconds
+    void record(uint32_t us);
+
+    // Returns the upper bound in micro seconds of the bucket holding the given percentile (0..100)
+    uint32_t percentile(uint8_t p) const;
+
+    // Number of recorded samples
+    inline uint32_t count() const {
+      return _count;
+    }
+
+    // Biggest recorded sample
+    inline uint32_t max() const {
+      return _max;
+    }
+
+    void reset();
+
+    // Bucket a sample falls into and the biggest value a bucket holds
+    static uint16_t bucketOf(uint32_t us);
+    static uint32_t bucketUpperBound(uint16_t bucket);
+
+  private:
+    uint32_t _buckets[LATENCY_BUCKETS];
+    uint32_t _count;
+    uint32_t _max;
+};
+
+
+// The stages of a trigger, each is measured from the button press
+enum latencyStage_t {
+  STAGE_OPENED = 0,          // sound opened from the cache or the flash
+  STAGE_QUEUED = 1,          // first data of the sound is in the ring buffer
+  STAGE_PLAYED = 2,          // first data of the sound was sent to the vs1053
+  STAGE_COUNT = 3
+};
+
+class LatencyTracker {
+
+  public:
+    LatencyTracker();
+
+    // A trigger happened at the given time, arms all stages, called by the player task only
+    void start(uint32_t nowUs);
+
+    // The given stage was reached, only the first mark after start() is recorded
+    inline void mark(latencyStage_t stage, uint32_t nowUs) {
+      uint32_t bit = 1UL << stage;
+      if ((_pending.load(std::memory_order_relaxed) & bit) == 0) {
+        return;
+      }
+      if (_pending.fetch_and(~bit) & bit) {
+        _histograms[stage].record(nowUs - _startUs.load(std::memory_order_relaxed));
+      }
+    }
+
+    // True when the stage is waiting for its mark
+    inline bool pending(latencyStage_t stage) const {
+      return (_pending.load(std::memory_order_relaxed) & (1UL << stage)) != 0;
+    }
+
+    const LatencyHistogram &histogram(latencyStage_t stage) const {
+      return _histograms[stage];
+    }
+
+    static const char* stageName(latencyStage_t stage);
+
+  private:
+    LatencyHistogram _histograms[STAGE_COUNT];
+    std::atomic<uint32_t> _startUs;            // time of the trigger
+    std::atomic<uint32_t> _pending;            // bit per stage not reached yet
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "Mp3FrameHeader.h"
+
+// kbit/s by bitrate index, for mpeg 1 layer 1/2/3 and mpeg 2/2.5 layer 1 and 2/3
+static const uint16_t bitrates[5][15] = {
+  {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+  {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+  {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+  {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+  {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+};
+
+// Hz by sample rate index for mpeg 1, the rate halves for mpeg 2 and quarters for 2.5
+static const uint32_t sampleRates[3] = {44100, 48000, 32000};
+
+bool parseMp3FrameHeader(const uint8_t* header, mp3FrameInfo* info) {
+  // 11 bit frame sync
+  if (header[0] != 0xFF || (header[1] & 0xE0) != 0xE0) {
+    return false;
+  }
+
+  uint8_t version = (header[1] >> 3) & 0x03;
+  uint8_t layerBits = (header[1] >> 1) & 0x03;
+  uint8_t bitrateIdx = header[2] >> 4;
+  uint8_t rateIdx = (header[2] >> 2) & 0x03;
+
+  // reserved values, free format is not supported either
+  if (version == 1 || layerBits == 0 || bitrateIdx == 0 || bitrateIdx == 15 || rateIdx == 3) {
+    return false;
+  }
+
+  info->version = version;
+  info->layer = 4 - layerBits;
+  info->crc = (header[1] & 0x01) == 0;
+  info->mono = (header[3] >> 6) == 3;
+
+  uint8_t table;
+  if (version == MPEG_1) {
+    table = info->layer - 1;
+  } else {
+    table = info->layer == 1 ? 3 : 4;
+  }
+  info->bitrate = bitrates[table][bitrateIdx];
+
+  info->sampleRate = sampleRates[rateIdx];
+  if (version == MPEG_2) {
+    info->sampleRate /= 2;
+  } else if (version == MPEG_25) {
+    info->sampleRate /= 4;
+  }
+
+  uint8_t padding = (header[2] >> 1) & 0x01;
+  uint32_t bps = (uint32_t) info->bitrate * 1000;
+  if (info->layer == 1) {
+    info->samplesPerFrame = 384;
+    info->frameLength = (12 * bps / info->sampleRate + padding) * 4;
+  } else if (info->layer == 3 && version != MPEG_1) {
+    info->samplesPerFrame = 576;
+    info->frameLength = 72 * bps / info->sampleRate + padding;
+  } else {
+    info->samplesPerFrame = 1152;
+    info->frameLength = 144 * bps / info->sampleRate + padding;
+  }
+
+  if (info->layer != 3) {
+    info->sideInfoSize = 0;
+  } else if (version == MPEG_1) {
+    info->sideInfoSize = info->mono ? 17 : 32;
+  } else {
+    info->sideInfoSize = info->mono ? 9 : 17;
+  }
+
+  return true;
+}
@@ -0,0 +1,35 @@
+/**
+   Parses the 4 byte header in front of every mpeg audio frame.
+   Does not depend on the arduino core so it can be tested on the host.
+*/
+#ifndef MP3FRAMEHEADER_h
+#define MP3FRAMEHEADER_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MP3_HEADER_SIZE 4
+
+// mpeg versions as coded in the header
+enum mp3Version_t {
+  MPEG_25 = 0,
+  MPEG_2 = 2,
+  MPEG_1 = 3
+};
+
+struct mp3FrameInfo {
+  uint8_t version;                                    // mp3Version_t
+  uint8_t layer;                                      // 1, 2 or 3
+  bool crc;                                           // 16 bit crc follows the header
+  uint16_t bitrate;                                   // kbit/s
+  uint32_t sampleRate;                                // Hz
+  bool mono;                                          // Single channel
+  uint16_t frameLength;                               // Bytes including the header
+  uint16_t samplesPerFrame;                           // Samples per channel in this frame
+  uint8_t sideInfoSize;                               // Bytes of layer 3 side info after header and crc
+};
+
+// Fills info from the header, returns false when it is not a valid frame header
+bool parseMp3FrameHeader(const uint8_t* header, mp3FrameInfo* info);
+
+#endif
@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "Mp3FrameIndex.h"
+
+/**
+   Constuctor
+*/
+Mp3FrameIndex::Mp3FrameIndex() {
+  reset();
+}
+
+void Mp3FrameIndex::reset() {
+  memset(&_header, 0, sizeof(_header));
+  _header.magic = MP3_INDEX_MAGIC;
+  _header.version = MP3_INDEX_VERSION;
+  _header.stride = 1;
+  _state = INDEX_TAG_CHECK;
+  _pos = 0;
+  _skip = 0;
+  _bufLen = 0;
+  _samples = 0;
+  _locked = false;
+}
+
+void Mp3FrameIndex::feed(const uint8_t* data, size_t len) {
+  while (len) {
+    if (_state == INDEX_SKIP) {
+      // tag data and frame bodies are skipped in one go
+      size_t chunk = len < _skip ? len : _skip;
+      _skip -= chunk;
+      _pos += chunk;
+      data += chunk;
+      len -= chunk;
+      if (_skip == 0) {
+        _state = INDEX_HEADER;
+      }
+      continue;
+    }
+
+    if (_state == INDEX_TAG_CHECK) {
+      _buf[_bufLen++] = *data++;
+      _pos++;
+      len--;
+
+      if (_bufLen == 3 && memcmp(_buf, "ID3", 3) != 0) {
+        // no tag, these are the first bytes of a frame header
+        uint8_t head[3];
+        memcpy(head, _buf, 3);
+        _bufLen = 0;
+        _pos -= 3;
+        _state = INDEX_HEADER;
+        for (uint8_t i = 0; i < 3; i++) {
+          _pos++;
+          feedHeaderByte(head[i]);
+        }
+      } else if (_bufLen == 10) {
+        // id3v2 size is 4 * 7 bit, a footer adds another 10 bytes
+        _skip = ((uint32_t)(_buf[6] & 0x7F) << 21) | ((uint32_t)(_buf[7] & 0x7F) << 14) |
+                ((uint32_t)(_buf[8] & 0x7F) << 7) | (_buf[9] & 0x7F);
+        if (_buf[5] & 0x10) {
+          _skip += 10;
+        }
+        _bufLen = 0;
+        _state = _skip ? INDEX_SKIP : INDEX_HEADER;
+      }
+      continue;
+    }
+
+    _pos++;
+    len--;
+    feedHeaderByte(*data++);
+  }
+}
+
+/**
+   Collects 4 bytes and checks them for a frame header, on garbage it slides one byte ahead
+*/
+void Mp3FrameIndex::feedHeaderByte(uint8_t b) {
+  mp3FrameInfo info;
+
+  _buf[_bufLen++] = b;
+  if (_bufLen < MP3_HEADER_SIZE) {
+    return;
+  }
+
+  bool valid = parseMp3FrameHeader(_buf, &info);
+  // once locked only frames of the same kind count, random data may look like a header
+  if (valid && _locked && (info.version != _lockVersion || info.layer != _lockLayer)) {
+    valid = false;
+  }
+
+  if (!valid) {
+    memmove(_buf, _buf + 1, MP3_HEADER_SIZE - 1);
+    _bufLen = MP3_HEADER_SIZE - 1;
+    return;
+  }
+
+  addFrame(_pos - MP3_HEADER_SIZE, info);
+  _bufLen = 0;
+  _skip = info.frameLength - MP3_HEADER_SIZE;
+  _state = _skip ? INDEX_SKIP : INDEX_HEADER;
+}
+
+void Mp3FrameIndex::addFrame(uint32_t offset, const mp3FrameInfo &info) {
+  if (!_locked) {
+    _locked = true;
+    _lockVersion = info.version;
+    _lockLayer = info.layer;
+    _header.sampleRate = info.sampleRate;
+    _header.samplesPerFrame = info.samplesPerFrame;
+  }
+
+  if (_header.frameCount % _header.stride == 0) {
+    // table is full, keep every second entry and double the stride
+    if (_header.entryCount == MP3_INDEX_MAX_ENTRIES) {
+      for (uint16_t i = 0; i < MP3_INDEX_MAX_ENTRIES / 2; i++) {
+        _entries[i] = _entries[i * 2];
+      }
+      _header.entryCount = MP3_INDEX_MAX_ENTRIES / 2;
+      _header.stride *= 2;
+    }
+    if (_header.frameCount % _header.stride == 0) {
+      _entries[_header.entryCount++] = offset;
+    }
+  }
+
+  _header.frameCount++;
+  _header.audioBytes += info.frameLength;
+  _samples += info.samplesPerFrame;
+}
+
+const mp3IndexHeader &Mp3FrameIndex::finish() {
+  if (_header.sampleRate) {
+    _header.durationMs = _samples * 1000 / _header.sampleRate;
+  }
+  if (_header.durationMs) {
+    _header.avgBitrate = (uint64_t) _header.audioBytes * 8 / _header.durationMs;
+  }
+  return _header;
+}
+
+uint32_t Mp3FrameIndex::frameAt(const mp3IndexHeader &header, uint32_t ms) {
+  if (header.samplesPerFrame == 0 || ms >= header.durationMs) {
+    return header.frameCount;
+  }
+  return (uint64_t) ms * header.sampleRate / 1000 / header.samplesPerFrame;
+}
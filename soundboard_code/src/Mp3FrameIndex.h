@@ -0,0 +1,81 @@
+/**
+   Builds an index of the mp3 frames while a file streams in, no second pass over the flash.
+   Every stride-th frame offset is kept, when the table is full the stride doubles, so the index
+   stays small for long files.  Offsets are relative to the start of the file.
+   Does not depend on the arduino core so it can be tested on the host.
+*/
+#ifndef MP3FRAMEINDEX_h
+#define MP3FRAMEINDEX_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Mp3FrameHeader.h"
+
+#define MP3_INDEX_MAGIC 0x5849334D                    // "M3IX" little endian
+#define MP3_INDEX_VERSION 1
+#define MP3_INDEX_MAX_ENTRIES 256
+
+// the header of the sidecar file, followed by entryCount uint32_t frame offsets
+struct mp3IndexHeader {
+  uint32_t magic;                                     // MP3_INDEX_MAGIC
+  uint16_t version;                                   // MP3_INDEX_VERSION
+  uint16_t entryCount;                                // Offsets following the header
+  uint32_t stride;                                    // Frames from one entry to the next
+  uint32_t frameCount;                                // Frames in the file
+  uint32_t durationMs;                                // Play time
+  uint32_t sampleRate;                                // Hz
+  uint16_t avgBitrate;                                // kbit/s over all frames
+  uint16_t samplesPerFrame;                           // Samples per frame
+  uint32_t audioBytes;                                // Bytes in frames, without tags
+};
+
+class Mp3FrameIndex {
+
+  public:
+    Mp3FrameIndex();
+
+    // Starts a new file
+    void reset();
+
+    // Feeds the next bytes of the file
+    void feed(const uint8_t* data, size_t len);
+
+    // Finishes the header after the last byte was fed
+    const mp3IndexHeader &finish();
+
+    // The frame offsets, header().entryCount of them
+    inline const uint32_t* entries() const {
+      return _entries;
+    }
+
+    inline const mp3IndexHeader &header() const {
+      return _header;
+    }
+
+    // The frame playing at the given time of the indexed file, frameCount when it is past the end
+    static uint32_t frameAt(const mp3IndexHeader &header, uint32_t ms);
+
+  private:
+    enum indexState_t {
+      INDEX_TAG_CHECK,                                // Collecting the first bytes, may be an id3v2 tag
+      INDEX_SKIP,                                     // Skipping the tag or the body of a frame
+      INDEX_HEADER                                    // Collecting the next frame header
+    };
+
+    void feedHeaderByte(uint8_t b);
+    void addFrame(uint32_t offset, const mp3FrameInfo &info);
+
+    mp3IndexHeader _header;
+    uint32_t _entries[MP3_INDEX_MAX_ENTRIES];
+    indexState_t _state;
+    uint32_t _pos;                                    // Bytes fed so far
+    uint32_t _skip;                                   // Bytes left to skip
+    uint8_t _buf[10];                                 // Tag or frame header collected so far
+    uint8_t _bufLen;
+    uint64_t _samples;                                // Samples of all frames
+    bool _locked;                                     // A first frame was found
+    uint8_t _lockVersion;                             // Version and layer of the first frame
+    uint8_t _lockLayer;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "Mp3IndexFile.h"
+
+String Mp3IndexFile::pathFor(const String &mp3Path) {
+  if (!mp3Path.endsWith(".mp3")) {
+    return "";
+  }
+  return mp3Path.substring(0, mp3Path.length() - 4) + ".idx";
+}
+
+bool Mp3IndexFile::write(const String &mp3Path, Mp3FrameIndex &index) {
+  String path = pathFor(mp3Path);
+  if (path == "") {
+    return false;
+  }
+
+  const mp3IndexHeader &header = index.finish();
+  if (header.frameCount == 0) {
+    ESP_LOGE("Index", "No mp3 frames found in %s", mp3Path.c_str());
+    remove(mp3Path);
+    return false;
+  }
+
+  File file = SPIFFS.open(path, FILE_WRITE);
+  if (!file) {
+    ESP_LOGE("Index", "Could not write %s", path.c_str());
+    return false;
+  }
+  file.write((const uint8_t*) &header, sizeof(header));
+  file.write((const uint8_t*) index.entries(), header.entryCount * sizeof(uint32_t));
+  file.close();
+
+  ESP_LOGD("Index", "%s has %d frames, %d ms, %d kbit/s", mp3Path.c_str(), header.frameCount,
+           header.durationMs, header.avgBitrate);
+  return true;
+}
+
+bool Mp3IndexFile::readHeader(const String &mp3Path, mp3IndexHeader* header) {
+  String path = pathFor(mp3Path);
+  if (path == "" || SPIFFS.exists(path) == false) {
+    return false;
+  }
+
+  File file = SPIFFS.open(path, FILE_READ);
+  bool ok = file.read((uint8_t*) header, sizeof(*header)) == sizeof(*header) &&
+            header->magic == MP3_INDEX_MAGIC && header->version == MP3_INDEX_VERSION;
+  file.close();
+  return ok;
+}
+
+bool Mp3IndexFile::frameOffset(const String &mp3Path, uint32_t frame, uint32_t* offset) {
+  mp3IndexHeader header;
+  if (!readHeader(mp3Path, &header) || frame >= header.frameCount) {
+    return false;
+  }
+
+  uint32_t entry = frame / header.stride;
+  if (entry >= header.entryCount) {
+    entry = header.entryCount - 1;
+  }
+
+  File file = SPIFFS.open(pathFor(mp3Path), FILE_READ);
+  file.seek(sizeof(header) + entry * sizeof(uint32_t));
+  bool ok = file.read((uint8_t*) offset, sizeof(*offset)) == sizeof(*offset);
+  file.close();
+  return ok;
+}
+
+bool Mp3IndexFile::timeOffset(const String &mp3Path, uint32_t ms, uint32_t* offset) {
+  mp3IndexHeader header;
+  if (!readHeader(mp3Path, &header)) {
+    return false;
+  }
+  return frameOffset(mp3Path, Mp3FrameIndex::frameAt(header, ms), offset);
+}
+
+void Mp3IndexFile::remove(const String &mp3Path) {
+  String path = pathFor(mp3Path);
+  if (path != "" && SPIFFS.exists(path)) {
+    SPIFFS.remove(path);
+  }
+}
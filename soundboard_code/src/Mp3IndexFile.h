@@ -0,0 +1,34 @@
+/**
+   Reads and writes the frame index sidecar files, /N.idx next to /N.mp3
+*/
+#ifndef MP3INDEXFILE_h
+#define MP3INDEXFILE_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include "Mp3FrameIndex.h"
+
+class Mp3IndexFile {
+
+  public:
+    // Path of the sidecar for the given mp3 path, empty when it is no mp3
+    static String pathFor(const String &mp3Path);
+
+    // Writes the finished index for the given mp3
+    static bool write(const String &mp3Path, Mp3FrameIndex &index);
+
+    // Reads the header of the index of the given mp3
+    static bool readHeader(const String &mp3Path, mp3IndexHeader* header);
+
+    // Byte offset of the indexed frame at or before the given frame
+    static bool frameOffset(const String &mp3Path, uint32_t frame, uint32_t* offset);
+
+    // Byte offset of the indexed frame at or before the given time
+    static bool timeOffset(const String &mp3Path, uint32_t ms, uint32_t* offset);
+
+    // Removes the index of the given mp3
+    static void remove(const String &mp3Path);
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include <string.h>
+
+#include "Mp3UploadFilter.h"
+
+/**
+   Constuctor
+*/
+Mp3UploadFilter::Mp3UploadFilter() {
+  begin(true, true, 0, NULL, NULL);
+}
+
+void Mp3UploadFilter::begin(bool stripTags, bool trimSilence, uint8_t silenceGain, outputFn output, void* ctx) {
+  _output = output;
+  _ctx = ctx;
+  _stripTags = stripTags;
+  _trimSilence = trimSilence;
+  _silenceGain = silenceGain;
+
+  _state = FILTER_TAG_CHECK;
+  _left = 0;
+  _skipOut = false;
+  _headLen = 0;
+  _headNeed = MP3_HEADER_SIZE;
+  _locked = false;
+  _leading = true;
+  _heldLen = 0;
+
+  bytesIn = 0;
+  bytesOut = 0;
+  tagBytes = 0;
+  silentBytes = 0;
+}
+
+void Mp3UploadFilter::feed(const uint8_t* data, size_t len) {
+  bytesIn += len;
+
+  while (len) {
+    // the bodies of tags and frames are handled in one go
+    if (_state == FILTER_SKIP || _state == FILTER_PASS || _state == FILTER_HOLD) {
+      size_t chunk = len < _left ? len : _left;
+
+      if (_state == FILTER_PASS || _skipOut) {
+        emit(data, chunk);
+      } else if (_state == FILTER_HOLD) {
+        memcpy(_held + _heldLen, data, chunk);
+        _heldLen += chunk;
+      } else {
+        tagBytes += chunk;
+      }
+
+      _left -= chunk;
+      data += chunk;
+      len -= chunk;
+      if (_left == 0) {
+        _state = FILTER_HEADER;
+        _skipOut = false;
+      }
+      continue;
+    }
+
+    if (_state == FILTER_TRAILER) {
+      tagBytes += len;
+      return;
+    }
+
+    if (_state == FILTER_TAG_CHECK) {
+      _head[_headLen++] = *data++;
+      len--;
+
+      if (_headLen == 3 && memcmp(_head, "ID3", 3) != 0) {
+        // no tag, these are the first bytes of a frame header
+        uint8_t first[3];
+        memcpy(first, _head, 3);
+        _headLen = 0;
+        _state = FILTER_HEADER;
+        for (uint8_t i = 0; i < 3; i++) {
+          feedHeaderByte(first[i]);
+        }
+      } else if (_headLen == 10) {
+        // id3v2 size is 4 * 7 bit, a footer adds another 10 bytes
+        _left = ((uint32_t)(_head[6] & 0x7F) << 21) | ((uint32_t)(_head[7] & 0x7F) << 14) |
+                ((uint32_t)(_head[8] & 0x7F) << 7) | (_head[9] & 0x7F);
+        if (_head[5] & 0x10) {
+          _left += 10;
+        }
+        _skipOut = !_stripTags;
+        if (_skipOut) {
+          emit(_head, _headLen);
+        } else {
+          tagBytes += _headLen;
+        }
+        _headLen = 0;
+        _state = _left ? FILTER_SKIP : FILTER_HEADER;
+      }
+      continue;
+    }
+
+    len--;
+    feedHeaderByte(*data++);
+  }
+}
+
+void Mp3UploadFilter::feedHeaderByte(uint8_t b) {
+  _head[_headLen++] = b;
+
+  if (_headLen == MP3_HEADER_SIZE) {
+    bool valid = parseMp3FrameHeader(_head, &_info);
+
+    if (!valid) {
+      // after the last frame only tags are expected
+      if (_locked && _stripTags && (memcmp(_head, "TAG", 3) == 0 || memcmp(_head, "APE", 3) == 0 ||
+                                    memcmp(_head, "ID3", 3) == 0 || memcmp(_head, "LYR", 3) == 0)) {
+        tagBytes += _headLen;
+        _headLen = 0;
+        _state = FILTER_TRAILER;
+        return;
+      }
+
+      // not a frame, slide one byte ahead, junk in front of the first frame goes with the tags
+      if (!_locked && _stripTags) {
+        tagBytes++;
+      } else {
+        emit(_head, 1);
+      }
+      memmove(_head, _head + 1, MP3_HEADER_SIZE - 1);
+      _headLen = MP3_HEADER_SIZE - 1;
+      return;
+    }
+
+    _locked = true;
+    _headNeed = MP3_HEADER_SIZE;
+    // the side info tells whether the frame is silent
+    if (_leading && _trimSilence && _info.layer == 3) {
+      _headNeed += (_info.crc ? 2 : 0) + _info.sideInfoSize;
+    }
+  }
+
+  if (_headLen >= MP3_HEADER_SIZE && _headLen == _headNeed) {
+    frameFound(_info);
+  }
+}
+
+void Mp3UploadFilter::frameFound(const mp3FrameInfo &info) {
+  uint8_t headLen = _headLen;
+  _headLen = 0;
+
+  // a frame shorter than its header would be broken, take the header as the whole frame
+  _left = info.frameLength > headLen ? info.frameLength - headLen : 0;
+
+  if (_leading && _trimSilence && info.frameLength <= MP3_FILTER_MAX_FRAME && isSilent(info)) {
+    // only the last silent frame is kept
+    silentBytes += _heldLen;
+    memcpy(_held, _head, headLen);
+    _heldLen = headLen;
+    _state = _left ? FILTER_HOLD : FILTER_HEADER;
+    return;
+  }
+
+  if (_leading) {
+    _leading = false;
+    emit(_held, _heldLen);
+    _heldLen = 0;
+  }
+
+  emit(_head, headLen);
+  _state = _left ? FILTER_PASS : FILTER_HEADER;
+}
+
+/**
+   Reads part2_3_length and global_gain of every granule and channel from the side info
+*/
+bool Mp3UploadFilter::isSilent(const mp3FrameInfo &info) const {
+  if (info.layer != 3) {
+    return false;
+  }
+
+  const uint8_t* side = _head + MP3_HEADER_SIZE + (info.crc ? 2 : 0);
+  uint8_t channels = info.mono ? 1 : 2;
+  uint8_t granules;
+  uint32_t bit;
+  uint8_t rest;
+
+  if (info.version == MPEG_1) {
+    // main_data_begin, private bits and scfsi
+    bit = 9 + (info.mono ? 5 : 3) + channels * 4;
+    granules = 2;
+    rest = 59 - 29;
+  } else {
+    bit = 8 + (info.mono ? 1 : 2);
+    granules = 1;
+    rest = 63 - 29;
+  }
+
+  for (uint8_t i = 0; i < granules * channels; i++) {
+    uint32_t part23 = 0;
+    uint32_t gain = 0;
+    for (uint8_t j = 0; j < 12; j++, bit++) {
+      part23 = (part23 << 1) | ((side[bit >> 3] >> (7 - (bit & 7))) & 1);
+    }
+    bit += 9;                                         // big_values
+    for (uint8_t j = 0; j < 8; j++, bit++) {
+      gain = (gain << 1) | ((side[bit >> 3] >> (7 - (bit & 7))) & 1);
+    }
+    bit += rest;
+
+    if (part23 != 0 && gain >= _silenceGain) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Mp3UploadFilter::finish() {
+  // a file with nothing audible keeps its last frame
+  if (_leading && _heldLen) {
+    emit(_held, _heldLen);
+    _heldLen = 0;
+  }
+
+  // a header which was never completed is just data
+  if (_state != FILTER_TRAILER && _headLen) {
+    emit(_head, _headLen);
+    _headLen = 0;
+  }
+}
+
+void Mp3UploadFilter::emit(const uint8_t* data, size_t len) {
+  if (len == 0) {
+    return;
+  }
+  bytesOut += len;
+  if (_output != NULL) {
+    _output(_ctx, data, len);
+  }
+}
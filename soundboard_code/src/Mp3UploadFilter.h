@@ -0,0 +1,75 @@
+/**
+   Filters an mp3 while it is uploaded, without buffering the whole file.
+   Drops id3v1/id3v2/ape tags and junk outside the frames, and the silent frames at the start
+   of the sound, so less has to be stored and sent to the vs1053 before something is audible.
+   A layer 3 frame is silent when none of its granules has coded data or a global gain below
+   the threshold.  The last silent frame is kept, the first audible frame may use its bit reservoir.
+   Does not depend on the arduino core so it can be tested on the host.
+*/
+#ifndef MP3UPLOADFILTER_h
+#define MP3UPLOADFILTER_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Mp3FrameHeader.h"
+
+#define MP3_FILTER_MAX_FRAME 1792                     // Biggest frame that can be held back
+#define MP3_FILTER_HEAD_SIZE (MP3_HEADER_SIZE + 2 + 32)  // Header, crc and side info
+
+class Mp3UploadFilter {
+
+  public:
+    // Receives the bytes which are kept
+    typedef void (*outputFn)(void* ctx, const uint8_t* data, size_t len);
+
+    Mp3UploadFilter();
+
+    // Starts a new file, silenceGain 0 only drops frames without any coded data
+    void begin(bool stripTags, bool trimSilence, uint8_t silenceGain, outputFn output, void* ctx);
+
+    // Filters the next bytes of the file
+    void feed(const uint8_t* data, size_t len);
+
+    // Passes on what is still held back after the last byte was fed
+    void finish();
+
+    uint32_t bytesIn;                                 // Bytes fed
+    uint32_t bytesOut;                                // Bytes passed on
+    uint32_t tagBytes;                                // Bytes dropped as tags or junk
+    uint32_t silentBytes;                             // Bytes dropped as leading silence
+
+  private:
+    enum filterState_t {
+      FILTER_TAG_CHECK,                               // Collecting the first bytes, may be an id3v2 tag
+      FILTER_SKIP,                                    // Skipping a tag
+      FILTER_HEADER,                                  // Collecting the header and side info of a frame
+      FILTER_PASS,                                    // Passing the rest of a frame on
+      FILTER_HOLD,                                    // Holding the rest of a silent frame back
+      FILTER_TRAILER                                  // Dropping the tags after the last frame
+    };
+
+    void feedHeaderByte(uint8_t b);
+    void frameFound(const mp3FrameInfo &info);
+    bool isSilent(const mp3FrameInfo &info) const;
+    void emit(const uint8_t* data, size_t len);
+
+    outputFn _output;
+    void* _ctx;
+    bool _stripTags;
+    bool _trimSilence;
+    uint8_t _silenceGain;
+
+    filterState_t _state;
+    uint32_t _left;                                   // Bytes left in the current tag or frame
+    bool _skipOut;                                    // FILTER_SKIP passes the bytes on
+    uint8_t _head[MP3_FILTER_HEAD_SIZE];              // Collected bytes of the tag or frame header
+    uint8_t _headLen;
+    uint8_t _headNeed;                                // Bytes of the header needed for the decision
+    mp3FrameInfo _info;                               // The frame in _head
+    bool _locked;                                     // A first frame was found
+    bool _leading;                                    // No audible frame was found yet
+    uint8_t _held[MP3_FILTER_MAX_FRAME];              // Last silent frame
+    uint16_t _heldLen;
+};
+
+#endif
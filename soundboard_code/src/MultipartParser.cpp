@@ -0,0 +1,212 @@
+#include <string.h>
+#include <strings.h>
+
+#include "MultipartParser.h"
+
+/**
+   Constuctor
+*/
+MultipartParser::MultipartParser() {
+  begin("-", NULL, NULL, NULL);
+}
+
+bool MultipartParser::begin(const char* boundary, partFn onPart, dataFn onData, void* ctx) {
+  _onPart = onPart;
+  _onData = onData;
+  _ctx = ctx;
+
+  _state = MP_PREAMBLE;
+  _wanted = false;
+  _dashes = 0;
+  _lineLen = 0;
+  _fileName[0] = 0;
+
+  bytesIn = 0;
+  dataBytes = 0;
+  parts = 0;
+
+  // the boundary may be quoted in the header
+  size_t len = strlen(boundary);
+  if (len >= 2 && boundary[0] == '"' && boundary[len - 1] == '"') {
+    boundary++;
+    len -= 2;
+  }
+  if (len == 0 || len > MULTIPART_MAX_BOUNDARY) {
+    _delimiterLen = 0;
+    return false;
+  }
+
+  memcpy(_delimiter, "\r\n--", 4);
+  memcpy(_delimiter + 4, boundary, len);
+  _delimiterLen = len + 4;
+
+  // horspool shift, how far the delimiter can move when the byte under its end does not match
+  memset(_skip, _delimiterLen, sizeof(_skip));
+  for (uint8_t i = 0; i < _delimiterLen - 1; i++) {
+    _skip[_delimiter[i]] = _delimiterLen - 1 - i;
+  }
+
+  // the first delimiter may be at the very start of the body without a CRLF before it
+  _tail[0] = '\r';
+  _tail[1] = '\n';
+  _tailLen = 2;
+
+  return true;
+}
+
+size_t MultipartParser::feed(const uint8_t* data, size_t len) {
+  size_t pos = 0;
+
+  if (_delimiterLen == 0) {
+    return 0;
+  }
+
+  while (pos < len && _state != MP_DONE) {
+    if (_state == MP_PREAMBLE || _state == MP_DATA) {
+      bool found = false;
+      pos += scan(data + pos, len - pos, found);
+      if (found) {
+        _state = MP_DELIMITER_END;
+        _dashes = 0;
+      }
+      continue;
+    }
+
+    uint8_t c = data[pos++];
+
+    if (_state == MP_DELIMITER_END) {
+      if (c == '-') {
+        if (++_dashes == 2) {
+          _state = MP_DONE;
+        }
+      } else if (c == '\n') {
+        _state = MP_HEADERS;
+        _lineLen = 0;
+        _fileName[0] = 0;
+      }
+      // CR and the transport padding are ignored
+      continue;
+    }
+
+    // MP_HEADERS, an empty line ends them
+    if (c == '\n') {
+      if (_lineLen > 0) {
+        headerLine();
+        _lineLen = 0;
+        continue;
+      }
+
+      parts++;
+      _wanted = _fileName[0] != 0 && _onPart != NULL && _onPart(_ctx, _fileName);
+      _state = MP_DATA;
+    } else if (c != '\r' && _lineLen < MULTIPART_MAX_HEADER) {
+      _line[_lineLen++] = c;
+    }
+  }
+
+  bytesIn += pos;
+  return pos;
+}
+
+size_t MultipartParser::scan(const uint8_t* data, size_t len, bool &found) {
+  const size_t m = _delimiterLen;
+
+  // a delimiter may have begun in the bytes held back from the last block
+  if (_tailLen > 0) {
+    for (uint8_t i = 0; i < _tailLen; i++) {
+      size_t have = _tailLen - i;
+      if (memcmp(_tail + i, _delimiter, have) != 0) {
+        continue;
+      }
+
+      size_t need = m - have;
+      size_t cmp = need < len ? need : len;
+      if (memcmp(data, _delimiter + have, cmp) != 0) {
+        continue;
+      }
+
+      emit(_tail, i);
+      if (cmp == need) {
+        _tailLen = 0;
+        found = true;
+        return need;
+      }
+
+      // the block ended before the delimiter, still not decided
+      memmove(_tail, _tail + i, have);
+      memcpy(_tail + have, data, len);
+      _tailLen = have + len;
+      return len;
+    }
+
+    emit(_tail, _tailLen);
+    _tailLen = 0;
+  }
+
+  // horspool, compares from the end of the delimiter and jumps by the byte under it
+  size_t pos = 0;
+  while (pos + m <= len) {
+    uint8_t last = data[pos + m - 1];
+    if (last == _delimiter[m - 1] && memcmp(data + pos, _delimiter, m - 1) == 0) {
+      emit(data, pos);
+      found = true;
+      return pos + m;
+    }
+    pos += _skip[last];
+  }
+
+  // the end of the block may be the start of a delimiter, it is held back
+  for (size_t k = len > m - 1 ? len - (m - 1) : 0; k < len; k++) {
+    if (data[k] == _delimiter[0] && memcmp(data + k, _delimiter, len - k) == 0) {
+      emit(data, k);
+      memcpy(_tail, data + k, len - k);
+      _tailLen = len - k;
+      return len;
+    }
+  }
+
+  emit(data, len);
+  return len;
+}
+
+void MultipartParser::emit(const uint8_t* data, size_t len) {
+  if (len == 0 || _state != MP_DATA || !_wanted) {
+    return;
+  }
+  dataBytes += len;
+  _onData(_ctx, data, len);
+}
+
+/**
+   Only the file name of the content disposition is of interest
+*/
+void MultipartParser::headerLine() {
+  _line[_lineLen] = 0;
+
+  if (strncasecmp(_line, "content-disposition:", 20) != 0) {
+    return;
+  }
+
+  const char* name = strstr(_line, "filename=");
+  if (name == NULL) {
+    return;
+  }
+  name += 9;
+
+  char end = ';';
+  if (*name == '"') {
+    end = '"';
+    name++;
+  }
+
+  uint8_t len = 0;
+  for (; *name != 0 && *name != end && len < MULTIPART_MAX_NAME; name++) {
+    // some browsers send the whole path of the file
+    if (*name == '/' || *name == '\\') {
+      len = 0;
+      continue;
+    }
+    _fileName[len++] = *name;
+  }
+  _fileName[len] = 0;
+}
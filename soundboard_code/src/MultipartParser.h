@@ -0,0 +1,76 @@
+/**
+   Streaming parser for a multipart/form-data request body.
+   The body is fed in blocks as it comes from the socket, the file data is passed on in
+   blocks too.  The delimiter is searched with a Boyer-Moore-Horspool skip table, a delimiter
+   split over two blocks is found because the bytes which may start it are held back.
+   The CRLF before a delimiter belongs to it and never ends up in the file.
+   Does not depend on the arduino core so it can be tested on the host.
+*/
+#ifndef MULTIPARTPARSER_h
+#define MULTIPARTPARSER_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MULTIPART_MAX_BOUNDARY 70                          // Longest boundary allowed by rfc 2046
+#define MULTIPART_MAX_DELIMITER (MULTIPART_MAX_BOUNDARY + 4)  // CRLF, "--" and the boundary
+#define MULTIPART_MAX_HEADER 160                           // Longer header lines of a part are cut
+#define MULTIPART_MAX_NAME 64                              // Longer file names are cut
+
+class MultipartParser {
+
+  public:
+    // A part with a file name begins, returns false when its data is not wanted
+    typedef bool (*partFn)(void* ctx, const char* fileName);
+    // Receives the data of a wanted part
+    typedef void (*dataFn)(void* ctx, const uint8_t* data, size_t len);
+
+    MultipartParser();
+
+    // Starts a new body, the boundary is the one of the content-type header, returns false when it is invalid
+    bool begin(const char* boundary, partFn onPart, dataFn onData, void* ctx);
+
+    // Parses the next bytes of the body, returns how many were used, the rest follows the closing delimiter
+    size_t feed(const uint8_t* data, size_t len);
+
+    // The closing delimiter was found
+    bool done() const {
+      return _state == MP_DONE;
+    }
+
+    uint32_t bytesIn;                                      // Bytes of the body fed
+    uint32_t dataBytes;                                    // Bytes passed on as file data
+    uint8_t parts;                                         // Parts found
+
+  private:
+    enum parserState_t {
+      MP_PREAMBLE,                                         // Skipping to the first delimiter
+      MP_DELIMITER_END,                                    // After a delimiter, "--" ends the body, CRLF starts a part
+      MP_HEADERS,                                          // Reading the header lines of a part
+      MP_DATA,                                             // Passing on the data of a part up to the next delimiter
+      MP_DONE                                              // After the closing delimiter
+    };
+
+    // Searches the delimiter, passes on what is before it, returns the bytes used
+    size_t scan(const uint8_t* data, size_t len, bool &found);
+    void emit(const uint8_t* data, size_t len);
+    void headerLine();
+
+    partFn _onPart;
+    void* _ctx;
+    dataFn _onData;
+
+    parserState_t _state;
+    bool _wanted;                                          // The data of the current part is passed on
+    uint8_t _delimiter[MULTIPART_MAX_DELIMITER];
+    uint8_t _delimiterLen;
+    uint8_t _skip[256];                                    // Horspool shift per byte value
+    uint8_t _tail[MULTIPART_MAX_DELIMITER];                // Held back bytes, may be the start of a delimiter
+    uint8_t _tailLen;
+    uint8_t _dashes;                                       // Dashes seen in MP_DELIMITER_END
+    char _line[MULTIPART_MAX_HEADER + 1];                  // Header line read so far
+    uint8_t _lineLen;
+    char _fileName[MULTIPART_MAX_NAME + 1];                // File name of the current part
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <string.h>
+
+#include "PcmMixer.h"
+
+/**
+   Constuctor
+*/
+PcmMixer::PcmMixer(uint8_t voices) {
+  _voices = voices > MIXER_MAX_VOICES ? MIXER_MAX_VOICES : voices;
+  for (uint8_t i = 0; i < MIXER_MAX_VOICES; i++) {
+    _voice[i].source = NULL;
+    _voice[i].startedAt = 0;
+  }
+}
+
+uint8_t PcmMixer::allocVoice() {
+  uint8_t oldest = 0;
+
+  for (uint8_t i = 0; i < _voices; i++) {
+    if (_voice[i].source == NULL) {
+      return i;
+    }
+    if (_voice[i].startedAt < _voice[oldest].startedAt) {
+      oldest = i;
+    }
+  }
+
+  // all voices are busy, the sound playing the longest has to go once the new one is there
+  return oldest;
+}
+
+void PcmMixer::startVoice(uint8_t voice, PcmSource* source) {
+  if (_voice[voice].source != NULL) {
+    steals++;
+  }
+  stopVoice(voice);
+  _voice[voice].source = source;
+  _voice[voice].startedAt = ++_startCounter;
+}
+
+void PcmMixer::stopAll() {
+  for (uint8_t i = 0; i < _voices; i++) {
+    stopVoice(i);
+  }
+}
+
+bool PcmMixer::uses(const PcmSource* source) const {
+  for (uint8_t i = 0; i < _voices; i++) {
+    if (_voice[i].source == source) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t PcmMixer::activeVoices() const {
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < _voices; i++) {
+    if (_voice[i].source != NULL) {
+      active++;
+    }
+  }
+  return active;
+}
+
+bool PcmMixer::mix(int16_t* out, size_t count) {
+  bool playing = false;
+
+  memset(out, 0, count * sizeof(int16_t));
+
+  while (count) {
+    size_t block = count > MIXER_BLOCK_SAMPLES ? MIXER_BLOCK_SAMPLES : count;
+
+    for (uint8_t i = 0; i < _voices; i++) {
+      if (_voice[i].source == NULL) {
+        continue;
+      }
+      playing = true;
+
+      size_t got = _voice[i].source->read(_scratch, block);
+      mixSaturate(out, _scratch, got);
+
+      // the sound is over
+      if (got < block) {
+        stopVoice(i);
+      }
+    }
+
+    out += block;
+    count -= block;
+  }
+
+  return playing;
+}
+
+/**
+   Written as a plain loop over int32 so the compiler can turn it into saturating
+   SIMD adds where the target has them.
+*/
+void PcmMixer::mixSaturate(int16_t* dst, const int16_t* src, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    int32_t sum = (int32_t) dst[i] + (int32_t) src[i];
+    if (sum > 32767) {
+      sum = 32767;
+    } else if (sum < -32768) {
+      sum = -32768;
+    }
+    dst[i] = (int16_t) sum;
+  }
+}
+
+static void putLe16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void putLe32(uint8_t* p, uint32_t v) {
+  putLe16(p, v & 0xFFFF);
+  putLe16(p + 2, v >> 16);
+}
+
+void PcmMixer::wavHeader(uint8_t* header, uint32_t sampleRate, uint8_t channels) {
+  memcpy(header, "RIFF", 4);
+  putLe32(header + 4, 0xFFFFFFFF);                    // unknown length, we stream
+  memcpy(header + 8, "WAVEfmt ", 8);
+  putLe32(header + 16, 16);                           // size of the fmt chunk
+  putLe16(header + 20, 1);                            // PCM
+  putLe16(header + 22, channels);
+  putLe32(header + 24, sampleRate);
+  putLe32(header + 28, sampleRate * channels * 2);    // bytes per second
+  putLe16(header + 32, channels * 2);                 // bytes per frame
+  putLe16(header + 34, 16);                           // bits per sample
+  memcpy(header + 36, "data", 4);
+  putLe32(header + 40, 0xFFFFFFFF);
+}
+
+void PcmMixer::stopVoice(uint8_t idx) {
+  if (_voice[idx].source != NULL) {
+    _voice[idx].source->close();
+    _voice[idx].source = NULL;
+  }
+}
@@ -0,0 +1,80 @@
+/**
+   Mixes several pre-decoded PCM sounds into one stream for the vs1053.
+   The vs1053 plays the mix as a wav stream, so overlapping button presses do not cut each other off.
+   Does not depend on the arduino core so the mix kernels can be benchmarked on the host.
+*/
+#ifndef PCMMIXER_h
+#define PCMMIXER_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIXER_MAX_VOICES 8
+#define MIXER_BLOCK_SAMPLES 256
+#define WAV_HEADER_SIZE 44
+
+/**
+   Where a voice gets its samples from
+*/
+class PcmSource {
+  public:
+    // Reads up to count samples, less means the sound is over
+    virtual size_t read(int16_t* samples, size_t count) = 0;
+    // Releases the source, it is not read again
+    virtual void close() = 0;
+    virtual ~PcmSource() {}
+};
+
+class PcmMixer {
+
+  public:
+    /**
+       Constructor, voices is the number of sounds played at the same time (max MIXER_MAX_VOICES)
+    */
+    PcmMixer(uint8_t voices);
+
+    // Returns a free voice, when all are busy the oldest one, which plays on until startVoice()
+    uint8_t allocVoice();
+
+    // Starts playing the source on a voice returned by allocVoice(), a playing one is stolen and its source closed
+    void startVoice(uint8_t voice, PcmSource* source);
+
+    // True when a voice plays the source
+    bool uses(const PcmSource* source) const;
+
+    // Stops all voices and closes their sources
+    void stopAll();
+
+    // Mixes the next count samples of all voices into out, returns false when no voice is playing
+    bool mix(int16_t* out, size_t count);
+
+    // Number of voices playing
+    uint8_t activeVoices() const;
+
+    inline uint8_t voices() const {
+      return _voices;
+    }
+
+    uint32_t steals = 0;                              // Voices taken from a playing sound
+
+    // Adds src to dst, clamping to the int16 range
+    static void mixSaturate(int16_t* dst, const int16_t* src, size_t count);
+
+    // Writes a wav header with an endless data chunk, for streaming the mix
+    static void wavHeader(uint8_t* header, uint32_t sampleRate, uint8_t channels);
+
+  private:
+    struct voice {
+      PcmSource* source;                              // NULL when the voice is free
+      uint32_t startedAt;                             // Value of _startCounter when started
+    };
+
+    void stopVoice(uint8_t idx);
+
+    voice _voice[MIXER_MAX_VOICES];
+    uint8_t _voices;
+    uint32_t _startCounter = 0;
+    int16_t _scratch[MIXER_BLOCK_SAMPLES];           // Samples of one voice before mixing
+};
+
+#endif
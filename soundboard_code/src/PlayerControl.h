@@ -0,0 +1,20 @@
+/**
+   Lets the http server and the remote triggers start and stop sounds from their own tasks.
+   The commands go through the queue of the button edges, so the player task wakes at once and
+   handles them in the order they came in.
+*/
+#ifndef PLAYERCONTROL_h
+#define PLAYERCONTROL_h
+
+#include <stdint.h>
+
+// Asks the player to play /<sound>.mp3 from startMs on, false when its queue is full
+bool playerPlay(uint16_t sound, uint32_t startMs, uint32_t timeUs);
+
+// Asks the player to stop what it plays, false when its queue is full
+bool playerStop(uint32_t timeUs);
+
+// Sets the volume of the vs1053 in percent
+void playerVolume(uint8_t percent);
+
+#endif
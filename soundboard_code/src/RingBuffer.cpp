@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include "RingBuffer.h"
+
+/**
+   Constuctor
+*/
+RingBuffer::RingBuffer(uint8_t* storage, size_t size) : _head(0), _tail(0) {
+  _buf = storage;
+  _size = size;
+  _mask = size - 1;
+}
+
+size_t RingBuffer::write(const uint8_t* data, size_t len) {
+  size_t head = _head.load(std::memory_order_relaxed);
+  size_t space = _size - (head - _tail.load(std::memory_order_acquire));
+
+  if (len > space) {
+    len = space;
+  }
+
+  // copy in at most two pieces, up to the end of the storage and from its start
+  size_t offset = head & _mask;
+  size_t first = _size - offset;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(_buf + offset, data, first);
+  memcpy(_buf, data + first, len - first);
+
+  // publish the data to the consumer
+  _head.store(head + len, std::memory_order_release);
+  return len;
+}
+
+size_t RingBuffer::peek(uint8_t** data) const {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t avail = _head.load(std::memory_order_acquire) - tail;
+  size_t offset = tail & _mask;
+
+  // only the part up to the end of the storage is contiguous
+  if (avail > _size - offset) {
+    avail = _size - offset;
+  }
+
+  *data = _buf + offset;
+  return avail;
+}
+
+size_t RingBuffer::read(uint8_t* data, size_t len) {
+  size_t done = 0;
+  uint8_t* src;
+  size_t chunk;
+
+  while (done < len && (chunk = peek(&src)) > 0) {
+    if (chunk > len - done) {
+      chunk = len - done;
+    }
+    memcpy(data + done, src, chunk);
+    consume(chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+void RingBuffer::discardTo(size_t position) {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+
+  // never move the tail backwards or past the written data
+  if (position - tail > _head.load(std::memory_order_acquire) - tail) {
+    return;
+  }
+  _tail.store(position, std::memory_order_release);
+}
@@ -0,0 +1,90 @@
+/**
+   Lock-free single producer / single consumer byte ring buffer.
+   The producer (mp3loop) only moves the head, the consumer (sound task) only moves the tail,
+   so no critical sections are needed.  The size must be a power of two.
+   Does not depend on the arduino core so it can be used in host side tests.
+*/
+#ifndef RINGBUFFER_h
+#define RINGBUFFER_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// keep head and tail in different cache lines so producer and consumer do not share one
+#define RINGBUFFER_CACHE_LINE 32
+
+class RingBuffer {
+
+  public:
+    /**
+       Constructor, storage must hold size bytes and size must be a power of two
+    */
+    RingBuffer(uint8_t* storage, size_t size);
+
+    // ### Producer side ###
+
+    // Copies up to len bytes into the buffer, returns the number of bytes written
+    size_t write(const uint8_t* data, size_t len);
+
+    // Number of bytes which can be written without overwriting unread data
+    inline size_t writeAvailable() const {
+      return _size - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    // Position of the next byte written, used to tag commands with a place in the stream
+    inline size_t writePosition() const {
+      return _head.load(std::memory_order_relaxed);
+    }
+
+    // ### Consumer side ###
+
+    // Number of bytes which can be read
+    inline size_t readAvailable() const {
+      return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    // Position of the next byte read
+    inline size_t readPosition() const {
+      return _tail.load(std::memory_order_relaxed);
+    }
+
+    // Sets data to the next readable byte and returns how many bytes can be read there in one piece
+    size_t peek(uint8_t** data) const;
+
+    // Marks len bytes as read, len must not be bigger than readAvailable()
+    inline void consume(size_t len) {
+      _tail.store(_tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    // Copies up to len bytes out of the buffer, returns the number of bytes read
+    size_t read(uint8_t* data, size_t len);
+
+    // Drops all data written before the given write position in O(1)
+    void discardTo(size_t position);
+
+    // Drops all readable data in O(1)
+    inline void flush() {
+      discardTo(_head.load(std::memory_order_acquire));
+    }
+
+    inline size_t size() const {
+      return _size;
+    }
+
+    // Puts the buffer on other storage of the same size and drops its data, nothing may be written meanwhile
+    inline void setStorage(uint8_t* storage) {
+      _buf = storage;
+      flush();
+    }
+
+  private:
+    uint8_t* _buf;                                                // The storage
+    size_t _size;                                                 // Size of the storage
+    size_t _mask;                                                 // _size - 1 for wrapping the positions
+
+    alignas(RINGBUFFER_CACHE_LINE) std::atomic<size_t> _head;     // Free running write position
+    alignas(RINGBUFFER_CACHE_LINE) std::atomic<size_t> _tail;     // Free running read position
+};
+
+#endif
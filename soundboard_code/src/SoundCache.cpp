@@ -0,0 +1,207 @@
+#include "SoundCache.h"
+#include "BufferPrint.h"
+
+/**
+   Constuctor
+*/
+SoundCache::SoundCache(size_t budget, size_t headSize) {
+  _budget = budget;
+  _headSize = headSize;
+  for (int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+    _entries[i].data = NULL;
+    _entries[i].len = 0;
+    _entries[i].users = 0;
+    _entries[i].stale = false;
+  }
+}
+
+void SoundCache::begin() {
+  _mutex = xSemaphoreCreateMutex();
+}
+
+bool SoundCache::load(const String &path) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  // already resident
+  if (find(path) >= 0) {
+    xSemaphoreGive(_mutex);
+    return true;
+  }
+
+  File file = SPIFFS.open(path, FILE_READ);
+  if (!file || file.size() == 0) {
+    ESP_LOGE("Cache", "Could not open %s for caching", path.c_str());
+    xSemaphoreGive(_mutex);
+    return false;
+  }
+
+  size_t len = file.size();
+  if (len > _headSize) {
+    len = _headSize;
+  }
+
+  // make room for the new head
+  while (bytesResident + len > _budget) {
+    if (!evictOne()) {
+      ESP_LOGD("Cache", "No room for %s", path.c_str());
+      file.close();
+      xSemaphoreGive(_mutex);
+      return false;
+    }
+  }
+
+  int idx = freeSlot();
+  if (idx < 0 && evictOne()) {
+    idx = freeSlot();
+  }
+
+  uint8_t* data = (idx < 0) ? NULL : (uint8_t*) malloc(len);
+  if (data == NULL) {
+    file.close();
+    xSemaphoreGive(_mutex);
+    return false;
+  }
+
+  // a short read would make the player skip the bytes missing in the head
+  size_t got = file.read(data, len);
+  if (got != len) {
+    ESP_LOGE("Cache", "Read only %d of %d bytes of %s", got, len, path.c_str());
+    free(data);
+    file.close();
+    xSemaphoreGive(_mutex);
+    return false;
+  }
+
+  cacheEntry &entry = _entries[idx];
+  entry.len = len;
+  entry.fileSize = file.size();
+  entry.data = data;
+  entry.path = path;
+  entry.lastUsed = ++_useCounter;
+  entry.users = 0;
+  entry.stale = false;
+  bytesResident += entry.len;
+  file.close();
+
+  ESP_LOGD("Cache", "Cached %d bytes of %s, %d bytes resident", entry.len, path.c_str(), bytesResident);
+
+  xSemaphoreGive(_mutex);
+  return true;
+}
+
+int SoundCache::acquire(const String &path) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  int idx = find(path);
+  if (idx < 0) {
+    misses++;
+  } else {
+    hits++;
+    _entries[idx].users++;
+    _entries[idx].lastUsed = ++_useCounter;
+  }
+
+  xSemaphoreGive(_mutex);
+  return idx;
+}
+
+void SoundCache::release(int idx) {
+  if (idx < 0) {
+    return;
+  }
+
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  cacheEntry &entry = _entries[idx];
+  entry.users--;
+  if (entry.users == 0 && entry.stale) {
+    freeEntry(idx);
+  }
+  xSemaphoreGive(_mutex);
+}
+
+const uint8_t* SoundCache::data(int idx) const {
+  return _entries[idx].data;
+}
+
+size_t SoundCache::length(int idx) const {
+  return _entries[idx].len;
+}
+
+size_t SoundCache::fileSize(int idx) const {
+  return _entries[idx].fileSize;
+}
+
+void SoundCache::invalidate(const String &path) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  int idx = find(path);
+  if (idx >= 0) {
+    ESP_LOGD("Cache", "Invalidating %s", path.c_str());
+    // a sound currently played from the cache is freed when it is released
+    if (_entries[idx].users > 0) {
+      _entries[idx].stale = true;
+    } else {
+      freeEntry(idx);
+    }
+  }
+
+  xSemaphoreGive(_mutex);
+}
+
+void SoundCache::printStats(Print &out) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  printFormatted(out, "{\"hits\" : %u, \"misses\" : %u, \"bytesResident\" : %u, \"budget\" : %u}",
+                 hits, misses, (unsigned int) bytesResident, (unsigned int) _budget);
+  xSemaphoreGive(_mutex);
+}
+
+int SoundCache::find(const String &path) const {
+  for (int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+    if (_entries[i].data != NULL && !_entries[i].stale && _entries[i].path == path) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int SoundCache::freeSlot() const {
+  for (int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+    if (_entries[i].data == NULL) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void SoundCache::freeEntry(int idx) {
+  cacheEntry &entry = _entries[idx];
+  bytesResident -= entry.len;
+  free(entry.data);
+  entry.data = NULL;
+  entry.len = 0;
+  entry.path = "";
+  entry.stale = false;
+}
+
+/**
+   Frees the least recently used entry which is not in use
+*/
+bool SoundCache::evictOne() {
+  int victim = -1;
+  for (int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+    if (_entries[i].data == NULL || _entries[i].users > 0) {
+      continue;
+    }
+    if (victim < 0 || _entries[i].lastUsed < _entries[victim].lastUsed) {
+      victim = i;
+    }
+  }
+
+  if (victim < 0) {
+    return false;
+  }
+
+  ESP_LOGD("Cache", "Evicting %s", _entries[victim].path.c_str());
+  freeEntry(victim);
+  return true;
+}
@@ -0,0 +1,77 @@
+/**
+   Keeps the first bytes of the button sounds in the heap.
+   Playback of a cached sound starts from RAM while the rest is still read from the flash,
+   so the SPIFFS lookup and open is no longer in front of the first byte reaching the vs1053.
+*/
+#ifndef SOUNDCACHE_h
+#define SOUNDCACHE_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include "Configuration.h"
+
+class SoundCache {
+
+  public:
+    /**
+       Constructor, budget is the max number of bytes kept in the heap over all sounds
+       and headSize the max number of bytes kept per sound
+    */
+    SoundCache(size_t budget, size_t headSize);
+
+    // Must be called before doing anything with the cache
+    void begin();
+
+    // Loads the head of the given sound, evicts the least recently used sounds when over budget
+    bool load(const String &path);
+
+    // Returns the index of the cached head of the sound and counts a hit or miss, -1 when not cached
+    // The entry stays in memory until release() is called
+    int acquire(const String &path);
+
+    // Gives the entry returned by acquire() back
+    void release(int idx);
+
+    // The cached bytes of an acquired entry
+    const uint8_t* data(int idx) const;
+    size_t length(int idx) const;
+    // Size of the whole file of an acquired entry
+    size_t fileSize(int idx) const;
+
+    // Removes the sound from the cache, call this when the file changed or was deleted
+    void invalidate(const String &path);
+
+    // Prints the statistics as a json object
+    void printStats(Print &out);
+
+    uint32_t hits = 0;                                // Number of sounds started from RAM
+    uint32_t misses = 0;                              // Number of sounds started from the flash
+    size_t bytesResident = 0;                         // Bytes currently held in the heap
+
+  private:
+    struct cacheEntry {
+      String path;                                    // Path of the sound on the SPIFFS
+      uint8_t* data;                                  // Head of the sound, NULL when unused
+      size_t len;                                     // Bytes in data
+      size_t fileSize;                                // Size of the whole file
+      uint32_t lastUsed;                              // Use counter value of the last access
+      uint8_t users;                                  // Number of acquire() without release()
+      bool stale;                                     // Free when the last user releases it
+    };
+
+    int find(const String &path) const;
+    int freeSlot() const;
+    void freeEntry(int idx);
+    bool evictOne();
+
+    cacheEntry _entries[SOUND_CACHE_ENTRIES];
+    size_t _budget;
+    size_t _headSize;
+    uint32_t _useCounter = 0;
+    SemaphoreHandle_t _mutex = NULL;
+};
+
+extern SoundCache soundCache;
+
+#endif
@@ -0,0 +1,14 @@
+/**
+   Lets an upload replace a sound without pulling the file away from the player.
+   The player opens its files with the lock held, an upload only swaps a file the player does not read.
+*/
+#ifndef SOUNDFILES_h
+#define SOUNDFILES_h
+
+// Takes the lock of the sound files, returns false without the lock while the given file is played
+bool lockSoundFile(const char* path);
+
+// Gives the lock taken by lockSoundFile() back
+void unlockSoundFile();
+
+#endif
@@ -0,0 +1,25 @@
+/**
+   Plays a sound while it comes in over http, without writing it to the flash.
+   The http server writes the body into a jitter buffer, the player starts when enough of it is there.
+   The buffer is taken from the heap when the stream starts and given back when it is over.
+   A full buffer takes nothing, so the client is slowed down by tcp when the vs1053 is busy.
+*/
+#ifndef SOUNDSTREAM_h
+#define SOUNDSTREAM_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stops the current sound and plays what streamWrite() gets, false while another stream plays
+bool streamBegin();
+
+// Copies as much of the data as the jitter buffer takes, returns the bytes taken, none before the player set it up
+size_t streamWrite(const uint8_t* data, size_t len);
+
+// All data of the stream is written, it ends when the buffer is played
+void streamEnd();
+
+// False when another sound stopped the stream, streamEnd() must be called anyway
+bool streamActive();
+
+#endif
@@ -0,0 +1,75 @@
+#include "TriggerProtocol.h"
+
+bool triggerParse(const uint8_t* data, size_t len, triggerPacket_struct &packet) {
+  if (len != TRIGGER_PACKET_SIZE || data[0] != 'S' || data[1] != 'B' || data[2] != TRIGGER_VERSION) {
+    return false;
+  }
+
+  packet.command = data[3];
+  packet.flags = data[4];
+  packet.value = data[5];
+  packet.sound = (uint16_t) (data[6] << 8 | data[7]);
+  packet.sequence = (uint32_t) data[8] << 24 | (uint32_t) data[9] << 16 | (uint32_t) data[10] << 8 | data[11];
+  packet.startMs = (uint32_t) data[12] << 24 | (uint32_t) data[13] << 16 | (uint32_t) data[14] << 8 | data[15];
+  return true;
+}
+
+void triggerEncode(const triggerPacket_struct &packet, uint8_t* data) {
+  data[0] = 'S';
+  data[1] = 'B';
+  data[2] = TRIGGER_VERSION;
+  data[3] = packet.command;
+  data[4] = packet.flags;
+  data[5] = packet.value;
+  data[6] = packet.sound >> 8;
+  data[7] = packet.sound;
+  data[8] = packet.sequence >> 24;
+  data[9] = packet.sequence >> 16;
+  data[10] = packet.sequence >> 8;
+  data[11] = packet.sequence;
+  data[12] = packet.startMs >> 24;
+  data[13] = packet.startMs >> 16;
+  data[14] = packet.startMs >> 8;
+  data[15] = packet.startMs;
+}
+
+TriggerDedup::TriggerDedup() {
+  for (int i = 0; i < TRIGGER_MAX_SENDERS; i++) {
+    _senders[i].used = false;
+  }
+}
+
+TriggerDedup::sender_struct* TriggerDedup::find(uint32_t address, uint16_t port) {
+  for (int i = 0; i < TRIGGER_MAX_SENDERS; i++) {
+    if (_senders[i].used && _senders[i].address == address && _senders[i].port == port) {
+      return &_senders[i];
+    }
+  }
+  return NULL;
+}
+
+bool TriggerDedup::isNew(uint32_t address, uint16_t port, uint32_t sequence, uint32_t nowMs, uint32_t timeoutMs) {
+  sender_struct* sender = find(address, port);
+
+  // the numbers wrap, a number up to 2^31 ahead is newer
+  return sender == NULL || nowMs - sender->lastMs > timeoutMs || (int32_t) (sequence - sender->sequence) > 0;
+}
+
+void TriggerDedup::remember(uint32_t address, uint16_t port, uint32_t sequence, uint32_t nowMs) {
+  sender_struct* sender = find(address, port);
+
+  // a new sender takes the place of the one which was silent for the longest time
+  if (sender == NULL) {
+    sender = &_senders[0];
+    for (int i = 0; i < TRIGGER_MAX_SENDERS && sender->used; i++) {
+      if (!_senders[i].used || (int32_t) (_senders[i].lastMs - sender->lastMs) < 0) {
+        sender = &_senders[i];
+      }
+    }
+    sender->used = true;
+    sender->address = address;
+    sender->port = port;
+  }
+  sender->sequence = sequence;
+  sender->lastMs = nowMs;
+}
@@ -0,0 +1,87 @@
+/**
+   The binary protocol of the remote triggers, one datagram per command.
+   A sender numbers its commands and may send each one more than once, the board only runs the first copy.
+   With TRIGGER_FLAG_ACK set the board answers with the header of the command and a status.
+   Does not depend on the arduino core so it can be tested on the host.
+
+   Offset  Size  Field
+   0       2     magic "SB"
+   2       1     version
+   3       1     command, TRIGGER_ACK is set in an answer
+   4       1     flags
+   5       1     volume in percent for TRIGGER_VOLUME, status in an answer
+   6       2     number of the sound for TRIGGER_PLAY, big endian
+   8       4     sequence number, big endian
+   12      4     start of TRIGGER_PLAY in ms from the beginning of the sound, big endian
+*/
+#ifndef TRIGGERPROTOCOL_h
+#define TRIGGERPROTOCOL_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRIGGER_PACKET_SIZE 16                             // Size of a command and of its answer
+#define TRIGGER_VERSION 2
+#define TRIGGER_FLAG_ACK 0x01                              // The sender wants an answer
+#define TRIGGER_ACK 0x80                                   // Marks the command of an answer
+#define TRIGGER_MAX_SENDERS 8                              // Senders whose last sequence number is kept
+
+// what a sender wants the board to do
+enum triggerCommand_t {
+  TRIGGER_PLAY = 1,
+  TRIGGER_STOP = 2,
+  TRIGGER_VOLUME = 3
+};
+
+// the status in an answer
+enum triggerStatus_t {
+  TRIGGER_OK = 0,
+  TRIGGER_DUPLICATE = 1,                                   // Was already run, this copy is ignored
+  TRIGGER_BUSY = 2,                                        // The player takes no more commands now
+  TRIGGER_INVALID = 3                                      // Unknown command or value
+};
+
+struct triggerPacket_struct {
+  uint8_t command;
+  uint8_t flags;
+  uint8_t value;                                           // Volume of the command or status of the answer
+  uint16_t sound;
+  uint32_t sequence;
+  uint32_t startMs;                                        // Where TRIGGER_PLAY starts the sound
+};
+
+// Reads a datagram, returns false when it is no command of this protocol
+bool triggerParse(const uint8_t* data, size_t len, triggerPacket_struct &packet);
+
+// Writes the packet into TRIGGER_PACKET_SIZE bytes
+void triggerEncode(const triggerPacket_struct &packet, uint8_t* data);
+
+// Remembers the last sequence number of each sender to drop the copies of a command
+class TriggerDedup {
+
+  public:
+    TriggerDedup();
+
+    // True when the sequence number is newer than the last one the sender got run.
+    // A sender which was silent for longer than timeoutMs may start again with any number.
+    bool isNew(uint32_t address, uint16_t port, uint32_t sequence, uint32_t nowMs, uint32_t timeoutMs);
+
+    // The command was run, its copies are dropped
+    void remember(uint32_t address, uint16_t port, uint32_t sequence, uint32_t nowMs);
+
+  private:
+    struct sender_struct {
+      uint32_t address;
+      uint16_t port;
+      bool used;
+      uint32_t sequence;                                   // Last sequence number run
+      uint32_t lastMs;                                     // When the last command came
+    };
+
+    sender_struct _senders[TRIGGER_MAX_SENDERS];
+
+    // The entry of the sender, NULL when it has none
+    sender_struct* find(uint32_t address, uint16_t port);
+};
+
+#endif
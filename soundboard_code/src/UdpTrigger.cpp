@@ -0,0 +1,124 @@
+#include <lwip/sockets.h>
+
+#include "UdpTrigger.h"
+#include "PlayerControl.h"
+#include "BufferPrint.h"
+
+void UdpTrigger::begin(uint16_t port) {
+  if (_socket >= 0 || port == 0) {
+    return;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    ESP_LOGE("Trigger", "Could not open a udp socket");
+    return;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    ESP_LOGE("Trigger", "Could not bind udp port %u", port);
+    close(fd);
+    return;
+  }
+  _socket = fd;
+
+  // above the player task, a command only waits for the task running when it came
+  xTaskCreatePinnedToCore(
+    &taskCode,
+    "triggerTask",
+    3072,
+    this,
+    3,
+    NULL,
+    1);
+  ESP_LOGI("Trigger", "Waiting for triggers on udp port %u", port);
+}
+
+void UdpTrigger::taskCode(void* parameter) {
+  UdpTrigger* trigger = (UdpTrigger*) parameter;
+  // one byte more, a longer datagram is cut and found invalid
+  uint8_t data[TRIGGER_PACKET_SIZE + 1];
+
+  for (;;) {
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(trigger->_socket, data, sizeof(data), 0, (struct sockaddr*) &from, &fromLen);
+    if (len < 0) {
+      vTaskDelay(pdMS_TO_TICKS(100));
+      continue;
+    }
+    trigger->handle(data, len, from.sin_addr.s_addr, ntohs(from.sin_port), micros());
+  }
+}
+
+void UdpTrigger::handle(const uint8_t* data, size_t len, uint32_t address, uint16_t port, uint32_t timeUs) {
+  triggerPacket_struct packet;
+
+  // answers are not answered
+  if (!triggerParse(data, len, packet) || (packet.command & TRIGGER_ACK)) {
+    invalid++;
+    return;
+  }
+
+  uint8_t status = TRIGGER_OK;
+  uint32_t now = millis();
+  if (!_dedup.isNew(address, port, packet.sequence, now, TRIGGER_SENDER_TIMEOUT_MS)) {
+    duplicates++;
+    status = TRIGGER_DUPLICATE;
+  } else {
+    switch (packet.command) {
+      case TRIGGER_PLAY:
+        status = playerPlay(packet.sound, packet.startMs, timeUs) ? TRIGGER_OK : TRIGGER_BUSY;
+        break;
+
+      case TRIGGER_STOP:
+        status = playerStop(timeUs) ? TRIGGER_OK : TRIGGER_BUSY;
+        break;
+
+      case TRIGGER_VOLUME:
+        if (packet.value > 100) {
+          status = TRIGGER_INVALID;
+        } else {
+          playerVolume(packet.value);
+        }
+        break;
+
+      default:
+        status = TRIGGER_INVALID;
+        break;
+    }
+
+    // a busy player gets the next copy again
+    if (status == TRIGGER_OK) {
+      commands++;
+      _dedup.remember(address, port, packet.sequence, now);
+    } else if (status == TRIGGER_INVALID) {
+      invalid++;
+    }
+  }
+
+  if (!(packet.flags & TRIGGER_FLAG_ACK)) {
+    return;
+  }
+
+  uint8_t answer[TRIGGER_PACKET_SIZE];
+  packet.command |= TRIGGER_ACK;
+  packet.value = status;
+  triggerEncode(packet, answer);
+
+  struct sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  to.sin_addr.s_addr = address;
+  sendto(_socket, answer, sizeof(answer), 0, (struct sockaddr*) &to, sizeof(to));
+}
+
+void UdpTrigger::printStats(Print &out) {
+  printFormatted(out, "{\"commands\" : %u, \"duplicates\" : %u, \"invalid\" : %u}", commands, duplicates, invalid);
+}
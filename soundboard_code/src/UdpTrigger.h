@@ -0,0 +1,36 @@
+/**
+   Receives the commands of the remote triggers on a udp port, see TriggerProtocol.h.
+   A task of its own waits in recvfrom() and queues each command for the player as soon as it came,
+   without the connection setup and the parsing of the http path.
+*/
+#ifndef UDPTRIGGER_h
+#define UDPTRIGGER_h
+
+#include "Arduino.h"
+#include "Configuration.h"
+#include "TriggerProtocol.h"
+
+class UdpTrigger {
+
+  public:
+    // Opens the port and starts the task, does nothing when it already runs
+    void begin(uint16_t port);
+
+    // Prints the counters as a json object
+    void printStats(Print &out);
+
+    uint32_t commands = 0;                                 // Commands passed to the player
+    uint32_t duplicates = 0;                               // Copies of commands already run
+    uint32_t invalid = 0;                                  // Datagrams which were no valid command
+
+  private:
+    static void taskCode(void* parameter);
+
+    // Runs a command and answers it when the sender wants to know
+    void handle(const uint8_t* data, size_t len, uint32_t address, uint16_t port, uint32_t timeUs);
+
+    int _socket = -1;
+    TriggerDedup _dedup;
+};
+
+#endif
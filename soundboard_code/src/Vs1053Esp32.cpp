@@ -62,6 +62,26 @@ void Vs1053Esp32::begin() {
   delay(100);
 }
 
+/**
+   The vs1053 raises DREQ when there is room for at least 32 bytes in its FIFO.
+   Instead of polling the pin the feeding task can sleep until this isr wakes it.
+*/
+void IRAM_ATTR Vs1053Esp32::dreqIsr(void *arg) {
+  Vs1053Esp32 *self = (Vs1053Esp32 *) arg;
+  BaseType_t   woken = pdFALSE;
+
+  xTaskNotifyFromISR(self->_dreq_task, self->_dreq_bits, eSetBits, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void Vs1053Esp32::enableDreqInterrupt(TaskHandle_t task, uint32_t notifyBits) {
+  _dreq_task = task;
+  _dreq_bits = notifyBits;
+  attachInterruptArg(_dreq_pin, dreqIsr, this, RISING);
+}
+
 /**
    Set volume.  Both left and right.
    Input value is 0..100.  100 is the loudest.
@@ -86,6 +106,23 @@ void Vs1053Esp32::playChunk(uint8_t* data, size_t len) {
   sdi_send_buffer(data, len);
 }
 
+/**
+   Consecutive chunks are sent in one SPI transaction instead of one per chunk.
+   DREQ only promises room for 32 bytes, so the caller checks it before every chunk.
+*/
+void Vs1053Esp32::beginBurst() {
+  data_mode_on();
+}
+
+void Vs1053Esp32::playBurstChunk(uint8_t* data, size_t len) {
+  SPI.writeBytes(data, len);
+  sdiBytes += len;
+}
+
+void Vs1053Esp32::endBurst() {
+  data_mode_off();
+}
+
 void Vs1053Esp32::stopSong() {
   uint16_t modereg;                     // Read from mode register
   int      i;                           // Loop control
@@ -108,6 +145,40 @@ void Vs1053Esp32::stopSong() {
   printDetails("Vs1053: Song stopped incorrectly!");
 }
 
+/**
+   Cancels the current song so the next one can start right away.
+   The data of the old song is already thrown away, so only fill bytes are sent, 32 at a time
+   as soon as DREQ allows it.  SM_CANCEL is checked after every chunk, the datasheet asks for a
+   soft reset when it is not cleared after 2048 bytes.
+   The 2052 endFill bytes the datasheet sends once SM_CANCEL is cleared are left out on purpose:
+   they only flush the end of the old song out of the decoder, which is not wanted here, and take
+   at least 4 ms on the 4 MHz SPI clock before the next song could start.  The decoder waits for
+   a header after the cancel and the next song always starts with one, an ID3 tag, a frame sync
+   or the RIFF header of the mixer.  Vs1053Sim counts songs starting elsewhere in midFrameStarts.
+*/
+void Vs1053Esp32::cancelSong() {
+  int      i;                           // Loop control
+
+  write_register(_SCI_MODE, _BV(_SM_SDINEW) | _BV(_SM_CANCEL));
+  for (i = 0; i < 2048 / _vs1053_chunk_size; i++)
+  {
+    sdi_send_fillers(_vs1053_chunk_size);          // Waits for DREQ, no fixed delay
+    if ((read_register(_SCI_MODE) & _BV(_SM_CANCEL)) == 0)
+    {
+      ESP_LOGD("Vs1053", "Song cancelled after %d fill bytes", (i + 1) * _vs1053_chunk_size);
+      return;
+    }
+  }
+
+  ESP_LOGD("Vs1053", "Song not cancelled, doing a soft reset");
+  softReset();
+
+  // Restore the clock and volume settings after the reset
+  write_register(_SCI_CLOCKF, 6 << 12);
+  uint16_t value = map(_curvol, 0, 100, 0xF8, 0x00);
+  write_register(_SCI_VOL, (value << 8) | value);
+}
+
 /**
    Set bass/treble(4 nibbles)
 */
@@ -130,7 +201,7 @@ uint8_t Vs1053Esp32::getVolume() {
   return _curvol;
 }
 
-void Vs1053Esp32::printDetails(const char *header) {
+void Vs1053Esp32::printDetails(const char * /* header */) {
   uint16_t     regbuf[16];
   uint8_t      i;
 
@@ -228,6 +299,9 @@ uint16_t Vs1053Esp32::read_register(uint8_t _reg) const {
 
 void Vs1053Esp32::sdi_send_fillers(size_t len) {
   size_t chunk_length;                            // Length of chunk 32 byte or shorter
+  uint8_t fillers[32];                            // One chunk of fill bytes
+
+  memset(fillers, _endFillByte, sizeof(fillers));
 
   data_mode_on();
   while (len)                                  // More to do?
@@ -239,10 +313,8 @@ void Vs1053Esp32::sdi_send_fillers(size_t len) {
       chunk_length = _vs1053_chunk_size;
     }
     len -= chunk_length;
-    while (chunk_length--)
-    {
-      SPI.write(_endFillByte);
-    }
+    SPI.writeBytes(fillers, chunk_length);
+    sdiBytes += chunk_length;
   }
   data_mode_off();
 }
@@ -261,6 +333,7 @@ void Vs1053Esp32::sdi_send_buffer(uint8_t* data, size_t len) {
     }
     len -= chunk_length;
     SPI.writeBytes(data, chunk_length);
+    sdiBytes += chunk_length;
     data += chunk_length;
   }
   data_mode_off();
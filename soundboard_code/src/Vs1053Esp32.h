@@ -13,7 +13,11 @@ class Vs1053Esp32 {
     void begin();    
     void startSong();                               // Prepare to start playing. Call this each
     void playChunk(uint8_t* data, size_t len);   // Play a chunk of data.  Copies the data to
+    void beginBurst();                              // Keep data mode on for several chunks
+    void playBurstChunk(uint8_t* data, size_t len);  // Play a chunk inside a burst, DREQ must be high
+    void endBurst();                                // End data mode after a burst
     void stopSong();                                // Finish playing a song. Call this after
+    void cancelSong();                              // Cancel a song quickly to start the next one
     void setVolume(uint8_t vol);                 // Set the player volume.Level from 0-100,
     void setTone(uint8_t* rtone);                // Set the player baas/treble, 4 nibbles for
     uint8_t getVolume();                               // Get the current volume setting.
@@ -23,6 +27,14 @@ class Vs1053Esp32 {
       return (digitalRead(_dreq_pin) == HIGH);
     }
 
+    // Notifies the task with the given bits every time DREQ goes high
+    void enableDreqInterrupt(TaskHandle_t task, uint32_t notifyBits);
+
+    // SPI statistics
+    mutable uint32_t sciTransactions = 0;   // SPI transactions in control mode
+    mutable uint32_t sdiTransactions = 0;   // SPI transactions in data mode
+    uint32_t sdiBytes = 0;                  // Bytes sent in data mode
+
   private:
     uint8_t _dreq_pin;                      // Pin where DREQ line is connected
     uint8_t _cs_pin;                        // Pin where CS line is connected
@@ -31,6 +43,10 @@ class Vs1053Esp32 {
     uint8_t _curvol;                        // Current volume setting 0..100%
     uint8_t _endFillByte;                   // Byte to send when stopping song
     const uint8_t _vs1053_chunk_size = 32;
+
+    TaskHandle_t _dreq_task = NULL;         // Task to notify when DREQ goes high
+    uint32_t _dreq_bits = 0;                // Notification bits for that task
+    static void dreqIsr(void *arg);
     
     SPISettings  _VS1053_SPI;               // SPI settings for this slave
     // SCI Register
@@ -66,6 +82,7 @@ class Vs1053Esp32 {
     }
 
     inline void control_mode_on() const {
+      sciTransactions++;
       SPI.beginTransaction(_VS1053_SPI);       // Prevent other SPI users
       digitalWrite(_dcs_pin, HIGH);            // Bring slave in control mode
       digitalWrite(_cs_pin, LOW);
@@ -77,6 +94,7 @@ class Vs1053Esp32 {
     }
 
     inline void data_mode_on() const {
+      sdiTransactions++;
       SPI.beginTransaction(_VS1053_SPI);       // Prevent other SPI users
       digitalWrite(_cs_pin, HIGH);             // Bring slave in data mode
       digitalWrite(_dcs_pin, LOW);
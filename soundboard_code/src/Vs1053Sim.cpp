@@ -0,0 +1,368 @@
+#include <string.h>
+
+#include "Vs1053Sim.h"
+
+/**
+   Constuctor, the pins are only there to match Vs1053Esp32
+*/
+Vs1053Sim::Vs1053Sim(uint8_t, uint8_t, uint8_t) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[_SCI_MODE] = 1 << _SM_SDINEW;
+}
+
+void Vs1053Sim::setClock(simClock_t clock) {
+  _clock = clock;
+  _lastUs = now();
+}
+
+void Vs1053Sim::setBitrate(uint32_t bitsPerSecond) {
+  update();
+  _bitrate = bitsPerSecond ? bitsPerSecond : 1;
+}
+
+void Vs1053Sim::setCancelBytes(uint16_t bytes) {
+  _cancelBytes = bytes;
+}
+
+void Vs1053Sim::setEndFillByte(uint8_t endFill) {
+  _endFillByte = endFill;
+}
+
+void Vs1053Sim::advance(uint32_t us) {
+  _virtualUs += us;
+}
+
+uint32_t Vs1053Sim::now() {
+  return _clock ? (uint32_t) _clock() : _virtualUs;
+}
+
+size_t Vs1053Sim::fifoLevel() {
+  update();
+  return _fifoLevel;
+}
+
+/**
+   Lets the decoder drain the FIFO for the time since the last update
+*/
+void Vs1053Sim::update() {
+  uint32_t t = now();
+  uint32_t elapsed = t - _lastUs;
+  _lastUs = t;
+
+  if (_resetting) {
+    if ((int32_t)(t - _resetUntil) < 0) {
+      return;
+    }
+    _resetting = false;
+    elapsed = t - _resetUntil;
+  }
+
+  if (_fifoLevel == 0) {
+    _bitCredit = 0;
+    return;
+  }
+
+  _bitCredit += (uint64_t) elapsed * _bitrate;
+  uint64_t bytes = _bitCredit / 8000000;
+  _bitCredit %= 8000000;
+
+  size_t decoded = bytes < _fifoLevel ? (size_t) bytes : _fifoLevel;
+  if (_cancelLeft) {
+    // cancelling is not bound to the bitrate
+    decoded = _fifoLevel;
+  }
+  _fifoLevel -= decoded;
+  decodedBytes += decoded;
+
+  if (_startPending && (int32_t)(_written - _fifoLevel - _startByte) > 0) {
+    _startPending = false;
+    startLatencyUs = t - _startUs;
+  }
+
+  if (_cancelLeft) {
+    if (decoded >= _cancelLeft) {
+      _cancelLeft = 0;
+      _regs[_SCI_MODE] &= ~(1 << _SM_CANCEL);
+      cancels++;
+    } else {
+      _cancelLeft -= decoded;
+    }
+  }
+
+  if (_fifoLevel == 0) {
+    _bitCredit = 0;
+    // waiting for the first byte of a song is its start latency, no underrun
+    if (_inSong && !_starved && !_startPending) {
+      underruns++;
+      _starved = true;
+    }
+  }
+}
+
+bool Vs1053Sim::data_request() {
+  update();
+  return !_resetting && _fifoLevel + _vs1053_chunk_size <= VS1053_SIM_FIFO_SIZE;
+}
+
+/**
+   With virtual time the simulation jumps to the moment DREQ goes high
+*/
+void Vs1053Sim::await_data_request() {
+  while (!data_request()) {
+    if (_clock) {
+      continue;
+    }
+    if (_resetting) {
+      _virtualUs = _resetUntil;
+      continue;
+    }
+    uint64_t missing = (uint64_t)(_fifoLevel + _vs1053_chunk_size - VS1053_SIM_FIFO_SIZE) * 8000000 - _bitCredit;
+    _virtualUs += (uint32_t)((missing + _bitrate - 1) / _bitrate);
+  }
+}
+
+void Vs1053Sim::wait(uint32_t us) {
+  if (_clock) {
+    uint32_t start = now();
+    while (now() - start < us) {
+    }
+  } else {
+    _virtualUs += us;
+  }
+}
+
+/**
+   Virtual time passes while the bytes are clocked out
+*/
+void Vs1053Sim::spiTime(size_t bytes) {
+  if (!_clock) {
+    _virtualUs += (uint32_t)((uint64_t) bytes * 8 * 1000000 / VS1053_SIM_SPI_HZ);
+  }
+}
+
+/**
+   The decoder syncs on the first header it finds, a song which starts inside a frame or data
+   left over from the last song would play a burst of noise or of the old sound
+*/
+void Vs1053Sim::checkData(const uint8_t* data, size_t len) {
+  if (len == 0) {
+    return;
+  }
+  if (!_inSong) {
+    strayBytes += len;
+    return;
+  }
+  if (!_firstData) {
+    return;
+  }
+  _firstData = false;
+
+  bool frameSync = len >= 2 && data[0] == 0xFF && (data[1] & 0xE0) == 0xE0;
+  bool header = len >= 3 && (memcmp(data, "ID3", 3) == 0 || memcmp(data, "RIF", 3) == 0);
+  if (!frameSync && !header) {
+    midFrameStarts++;
+  }
+}
+
+void Vs1053Sim::sdi_write(size_t len) {
+  spiTime(len);
+  update();
+  if (_fifoLevel + len > VS1053_SIM_FIFO_SIZE) {
+    overflows += _fifoLevel + len - VS1053_SIM_FIFO_SIZE;
+    len = VS1053_SIM_FIFO_SIZE - _fifoLevel;
+  }
+  _fifoLevel += len;
+  _written += len;
+  sdiBytes += len;
+  if (len) {
+    _starved = false;
+  }
+}
+
+void Vs1053Sim::begin() {
+  _lastUs = now();
+  wait(100000);
+  testComm("Slow SPI, Testing VS1053 read/write registers...");
+  wram_write(0xC017, 3);
+  wram_write(0xC019, 0);
+  wait(100000);
+  softReset();
+  write_register(_SCI_AUDATA, 44100 + 1);
+  write_register(_SCI_CLOCKF, 6 << 12);
+  write_register(_SCI_MODE, (1 << _SM_SDINEW) | (1 << _SM_LINE1));
+  testComm("Fast SPI, Testing VS1053 read/write registers again...");
+  await_data_request();
+  _endFillByte = wram_read(0x1E06) & 0xFF;
+}
+
+bool Vs1053Sim::testComm(const char *) {
+  write_register(_SCI_VOL, 0x1234);
+  bool ok = read_register(_SCI_VOL) == 0x1234;
+  write_register(_SCI_VOL, 0);
+  return ok;
+}
+
+void Vs1053Sim::setVolume(uint8_t vol) {
+  if (vol != _curvol) {
+    _curvol = vol;
+    uint16_t value = 0xF8 - (uint16_t) vol * 0xF8 / 100;
+    write_register(_SCI_VOL, (value << 8) | value);
+  }
+}
+
+void Vs1053Sim::setTone(uint8_t *rtone) {
+  uint16_t value = 0;
+
+  for (int i = 0; i < 4; i++) {
+    value = (value << 4) | rtone[i];
+  }
+  write_register(_SCI_BASS, value);
+}
+
+uint8_t Vs1053Sim::getVolume() {
+  return _curvol;
+}
+
+void Vs1053Sim::startSong() {
+  sdi_send_fillers(10);
+  update();
+  _inSong = true;
+  _starved = false;
+  _startPending = true;
+  _firstData = true;
+  _startByte = _written;
+  _startUs = now();
+}
+
+void Vs1053Sim::playChunk(uint8_t* data, size_t len) {
+  sdiTransactions++;
+  checkData(data, len);
+  while (len) {
+    size_t chunk_length = len > _vs1053_chunk_size ? _vs1053_chunk_size : len;
+    await_data_request();
+    sdi_write(chunk_length);
+    len -= chunk_length;
+  }
+}
+
+void Vs1053Sim::beginBurst() {
+  sdiTransactions++;
+}
+
+void Vs1053Sim::playBurstChunk(uint8_t* data, size_t len) {
+  checkData(data, len);
+  sdi_write(len);
+}
+
+void Vs1053Sim::endBurst() {
+}
+
+/**
+   The same sequence as Vs1053Esp32::stopSong()
+*/
+void Vs1053Sim::stopSong() {
+  update();
+  _inSong = false;
+  _startPending = false;
+  sdi_send_fillers(2052);
+  wait(10000);
+  write_register(_SCI_MODE, (1 << _SM_SDINEW) | (1 << _SM_CANCEL));
+  for (int i = 0; i < 200; i++) {
+    sdi_send_fillers(32);
+    if ((read_register(_SCI_MODE) & (1 << _SM_CANCEL)) == 0) {
+      sdi_send_fillers(2052);
+      return;
+    }
+    wait(10000);
+  }
+}
+
+/**
+   The same sequence as Vs1053Esp32::cancelSong()
+*/
+void Vs1053Sim::cancelSong() {
+  update();
+  _inSong = false;
+  _startPending = false;
+  write_register(_SCI_MODE, (1 << _SM_SDINEW) | (1 << _SM_CANCEL));
+  for (int i = 0; i < 2048 / _vs1053_chunk_size; i++) {
+    sdi_send_fillers(_vs1053_chunk_size);
+    if ((read_register(_SCI_MODE) & (1 << _SM_CANCEL)) == 0) {
+      return;
+    }
+  }
+
+  softReset();
+  write_register(_SCI_CLOCKF, 6 << 12);
+  uint16_t value = 0xF8 - (uint16_t) _curvol * 0xF8 / 100;
+  write_register(_SCI_VOL, (value << 8) | value);
+}
+
+void Vs1053Sim::softReset() {
+  write_register(_SCI_MODE, (1 << _SM_SDINEW) | (1 << _SM_RESET));
+  wait(10000);
+  await_data_request();
+}
+
+void Vs1053Sim::wram_write(uint16_t address, uint16_t data) {
+  write_register(_SCI_WRAMADDR, address);
+  write_register(_SCI_WRAM, data);
+}
+
+uint16_t Vs1053Sim::wram_read(uint16_t address) {
+  write_register(_SCI_WRAMADDR, address);
+  return read_register(_SCI_WRAM);
+}
+
+/**
+   Setting SM_CANCEL starts counting the decoded bytes, SM_RESET empties the FIFO and holds DREQ low
+*/
+void Vs1053Sim::write_register(uint8_t _reg, uint16_t _value) {
+  sciTransactions++;
+  spiTime(4);
+  update();
+  _reg &= 0xF;
+
+  if (_reg == _SCI_WRAMADDR) {
+    _wramAddr = _value;
+  } else if (_reg == _SCI_WRAM) {
+    _wramAddr++;
+  } else if (_reg == _SCI_MODE && (_value & (1 << _SM_RESET))) {
+    memset(_regs, 0, sizeof(_regs));
+    _regs[_SCI_MODE] = _value & ~(1 << _SM_RESET);
+    _fifoLevel = 0;
+    _bitCredit = 0;
+    _cancelLeft = 0;
+    _resetting = true;
+    _resetUntil = now() + VS1053_SIM_RESET_US;
+    resets++;
+    return;
+  } else if (_reg == _SCI_MODE && (_value & (1 << _SM_CANCEL)) && !(_regs[_SCI_MODE] & (1 << _SM_CANCEL))) {
+    // with 0 cancel bytes the decoder never clears the bit
+    _cancelLeft = _cancelBytes;
+  }
+  _regs[_reg] = _value;
+}
+
+uint16_t Vs1053Sim::read_register(uint8_t _reg) {
+  sciTransactions++;
+  spiTime(4);
+  update();
+  _reg &= 0xF;
+
+  if (_reg == _SCI_WRAM) {
+    uint16_t address = _wramAddr++;
+    return address == 0x1E06 ? _endFillByte : 0;
+  }
+  return _regs[_reg];
+}
+
+void Vs1053Sim::sdi_send_fillers(size_t len) {
+  sdiTransactions++;
+  while (len) {
+    size_t chunk_length = len > _vs1053_chunk_size ? _vs1053_chunk_size : len;
+    await_data_request();
+    sdi_write(chunk_length);
+    len -= chunk_length;
+  }
+}
@@ -0,0 +1,122 @@
+/**
+   Behaves like a vs1053 on the other end of Vs1053Esp32, without the module.
+   Has the same public methods as Vs1053Esp32, so it can take its place to measure the playback
+   pipeline on a board without the module or on the host.
+   Models the SCI registers (SCI_MODE with SM_CANCEL and SM_RESET, SCI_VOL, WRAM with the endFill
+   byte at 0x1E06), the 2048 byte SDI FIFO which the decoder drains at the bitrate and DREQ, which
+   is high when there is room for 32 bytes.  After SM_CANCEL the decoder throws the data away as
+   fast as it comes and clears the bit after the cancel bytes.
+   Time comes from a clock function, without one it is virtual and only passes while waiting for DREQ.
+   Does not depend on the arduino core so it can be tested on the host.
+*/
+#ifndef VS1053SIM_h
+#define VS1053SIM_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VS1053_SIM_FIFO_SIZE 2048                 // Bytes in the SDI FIFO
+#define VS1053_SIM_RESET_US 1800                  // DREQ is low this long after a soft reset
+#define VS1053_SIM_SPI_HZ 4000000                 // SPI clock, virtual time passes while sending
+
+class Vs1053Sim {
+
+  public:
+    typedef unsigned long (*simClock_t)();        // Returns the time in us, like micros()
+
+    Vs1053Sim(uint8_t _cs_pin, uint8_t _dcs_pin, uint8_t _dreq_pin);
+    bool testComm(const char *header);           // Test communication with module
+    void softReset();                               // Do a soft reset
+    void begin();
+    void startSong();                               // Prepare to start playing
+    void playChunk(uint8_t* data, size_t len);   // Play a chunk of data
+    void beginBurst();                              // Keep data mode on for several chunks
+    void playBurstChunk(uint8_t* data, size_t len);  // Play a chunk inside a burst, DREQ must be high
+    void endBurst();                                // End data mode after a burst
+    void stopSong();                                // Finish playing a song
+    void cancelSong();                              // Cancel a song quickly to start the next one
+    void setVolume(uint8_t vol);                 // Set the player volume.Level from 0-100
+    void setTone(uint8_t* rtone);                // Set the player baas/treble
+    uint8_t getVolume();                               // Get the current volume setting.
+
+    bool data_request();
+
+    // Simulation settings
+    void setClock(simClock_t clock);             // NULL = virtual time
+    void setBitrate(uint32_t bitsPerSecond);      // Speed the decoder drains the FIFO with
+    void setCancelBytes(uint16_t bytes);          // Bytes decoded until SM_CANCEL clears, 0 = never
+    void setEndFillByte(uint8_t endFill);         // Value of the endFill byte in WRAM
+    void advance(uint32_t us);                    // Lets virtual time pass
+    uint32_t now();                               // Time of the simulation in us
+    size_t fifoLevel();                           // Bytes waiting in the FIFO
+
+    // SPI statistics, like Vs1053Esp32
+    uint32_t sciTransactions = 0;           // SPI transactions in control mode
+    uint32_t sdiTransactions = 0;           // SPI transactions in data mode
+    uint32_t sdiBytes = 0;                  // Bytes sent in data mode
+
+    // Simulation results
+    uint32_t decodedBytes = 0;              // Bytes the decoder took out of the FIFO
+    uint32_t underruns = 0;                 // The FIFO ran empty while a song was played
+    uint32_t overflows = 0;                 // Bytes sent while the FIFO was full, they are lost
+    uint32_t cancels = 0;                   // SM_CANCEL was cleared by the decoder
+    uint32_t resets = 0;                    // Soft resets
+    uint32_t startLatencyUs = 0;            // startSong() until the first byte of the song was decoded
+    uint32_t midFrameStarts = 0;            // Songs whose first byte was no frame sync or file header
+    uint32_t strayBytes = 0;                // Data sent outside of a song, after a stop or cancel
+
+  private:
+    simClock_t _clock = NULL;
+    uint32_t _virtualUs = 0;                // Time without a clock
+    uint32_t _lastUs = 0;                   // Time of the last update
+    uint32_t _bitrate = 128000;
+    uint64_t _bitCredit = 0;                // Decoded bits * 1000000 not yet a whole byte
+    uint16_t _cancelBytes = 128;
+    uint16_t _cancelLeft = 0;               // Bytes to decode until SM_CANCEL clears
+    uint32_t _resetUntil = 0;               // DREQ is low until then
+    bool _resetting = false;
+
+    size_t _fifoLevel = 0;
+    uint32_t _written = 0;                  // Bytes written into the FIFO since begin
+    bool _inSong = false;                   // Between startSong and stop or cancel
+    bool _starved = false;                  // Underrun already counted
+    bool _startPending = false;             // Waiting for the first byte of the song
+    bool _firstData = false;                // The next data sent is the start of the song
+    uint32_t _startByte = 0;                // Value of _written for that byte
+    uint32_t _startUs = 0;
+
+    uint16_t _regs[16];                     // SCI registers
+    uint16_t _wramAddr = 0;
+    uint8_t _endFillByte = 0;
+    uint8_t _curvol = 0;
+    const uint8_t _vs1053_chunk_size = 32;
+
+    // SCI Register
+    const uint8_t _SCI_MODE = 0x0;
+    const uint8_t _SCI_AUDATA = 0x5;
+    const uint8_t _SCI_BASS = 0x2;
+    const uint8_t _SCI_CLOCKF = 0x3;
+    const uint8_t _SCI_VOL = 0xB;
+    const uint8_t _SCI_WRAM = 0x6;
+    const uint8_t _SCI_WRAMADDR = 0x7;
+    // SCI_MODE bits
+    const uint8_t _SM_SDINEW = 11;        // Bitnumber in SCI_MODE always on
+    const uint8_t _SM_LINE1 = 14;        // Bitnumber in SCI_MODE for Line input
+    const uint8_t _SM_RESET = 2;         // Bitnumber in SCI_MODE soft reset
+    const uint8_t _SM_CANCEL = 3;         // Bitnumber in SCI_MODE cancel song
+
+    void update();
+    void checkData(const uint8_t* data, size_t len);
+    void sdi_write(size_t len);
+    void wait(uint32_t us);
+    void spiTime(size_t bytes);
+    void await_data_request();
+
+    void wram_write(uint16_t address, uint16_t data);
+    uint16_t wram_read(uint16_t address);
+    uint16_t read_register(uint8_t _reg);
+    void write_register(uint8_t _reg, uint16_t _value);
+    void sdi_send_fillers(size_t length);
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "WavFileSource.h"
+
+static uint16_t getLe16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t getLe32(const uint8_t* p) {
+  return getLe16(p) | ((uint32_t) getLe16(p + 2) << 16);
+}
+
+bool WavFileSource::open(const String &path, uint32_t sampleRate, uint8_t channels) {
+  uint8_t header[16];
+  bool    formatOk = false;
+
+  close();
+
+  if (SPIFFS.exists(path) == false) {
+    return false;
+  }
+  _file = SPIFFS.open(path, FILE_READ);
+
+  // RIFF header
+  if (_file.read(header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+    ESP_LOGE("Wav", "%s is not a wav file", path.c_str());
+    close();
+    return false;
+  }
+
+  // walk the chunks until the data starts
+  while (_file.read(header, 8) == 8) {
+    uint32_t chunkSize = getLe32(header + 4);
+
+    if (memcmp(header, "data", 4) == 0) {
+      if (!formatOk) {
+        break;
+      }
+      _remaining = chunkSize;
+      return true;
+    }
+
+    if (memcmp(header, "fmt ", 4) == 0 && chunkSize >= 16) {
+      if (_file.read(header, 16) != 16) {
+        break;
+      }
+      formatOk = getLe16(header) == 1 && getLe16(header + 2) == channels &&
+                 getLe32(header + 4) == sampleRate && getLe16(header + 14) == 16;
+      chunkSize -= 16;
+    }
+
+    // chunks are padded to an even size
+    _file.seek(_file.position() + chunkSize + (chunkSize & 1));
+  }
+
+  ESP_LOGE("Wav", "%s is not %d Hz %d channel 16 bit PCM", path.c_str(), sampleRate, channels);
+  close();
+  return false;
+}
+
+size_t WavFileSource::read(int16_t* samples, size_t count) {
+  size_t len = count * sizeof(int16_t);
+
+  if (len > _remaining) {
+    len = _remaining;
+  }
+  if (len == 0) {
+    return 0;
+  }
+
+  // the samples in the file are little endian like the esp32
+  len = _file.read((uint8_t*) samples, len);
+  _remaining -= len;
+  return len / sizeof(int16_t);
+}
+
+void WavFileSource::close() {
+  if (_file) {
+    _file.close();
+  }
+  _remaining = 0;
+}
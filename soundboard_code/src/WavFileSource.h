@@ -0,0 +1,27 @@
+/**
+   Reads the samples of a wav file on the SPIFFS for a voice of the PcmMixer
+*/
+#ifndef WAVFILESOURCE_h
+#define WAVFILESOURCE_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include "PcmMixer.h"
+
+class WavFileSource : public PcmSource {
+
+  public:
+    // Opens the file, fails when it is missing or not 16 bit PCM with the given rate and channels
+    bool open(const String &path, uint32_t sampleRate, uint8_t channels);
+
+    size_t read(int16_t* samples, size_t count) override;
+
+    void close() override;
+
+  private:
+    File _file;
+    uint32_t _remaining = 0;                          // Bytes of the data chunk not read yet
+};
+
+#endif
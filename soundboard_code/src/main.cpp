@@ -34,8 +34,24 @@
 #include <SPIFFS.h>
 #include "Configuration.h"
 #include "Vs1053Esp32.h"
+#include "Vs1053Sim.h"
+#include "RingBuffer.h"
+#include "SoundCache.h"
+#include "LatencyStats.h"
+#include "BoardStats.h"
+#include "ButtonDebouncer.h"
+#include "PcmMixer.h"
+#include "WavFileSource.h"
+#include "Mp3IndexFile.h"
 #include "StatusLed.h"
 #include "HttpServer.h"
+#include "FileCatalogue.h"
+#include "BufferPrint.h"
+#include "HeapStats.h"
+#include "SoundFiles.h"
+#include "SoundStream.h"
+#include "PlayerControl.h"
+#include "UdpTrigger.h"
 
 
 
@@ -63,34 +79,105 @@ File             mp3file;                               // File containing mp3 o
 enum datamode_t {DATA = 1,        // State for datastream
                  STOPREQD = 2,  // Request for stopping current song
                  SOUNDFINISHED = 4, // The sound finished
-                 STOPPED = 8    // State for stopped
+                 STOPPED = 8,    // State for stopped
+                 MIXING = 16,   // State for streaming the mix of the wav voices
+                 STREAMED = 32  // State for playing the body of POST /stream
                 };
 
-datamode_t       datamode;                                // State of datastream
+datamode_t       datamode = STOPPED;                      // State of datastream
 
 
-// new queue handling of data taken from edzelf esp32 radio
-QueueHandle_t     dataqueue ;                            // Queue for mp3 datastream
+// mp3 data goes through a lock-free ring buffer, mp3loop() writes and the sound task reads
+__attribute__((aligned(4))) uint8_t ringbufdata[RINGBUF_SIZE] ;  // Storage of the ring buffer
+RingBuffer        ringbuf(ringbufdata, RINGBUF_SIZE) ;   // Buffer for mp3 datastream
 
-QueueHandle_t     stopque;
+// a sound streamed over http waits in the jitter buffer, the http server writes and mp3loop() reads
+// its storage is only in the heap while a stream plays, mp3loop() allocates and frees it
+uint8_t*          streambufdata = NULL ;                  // Storage of the jitter buffer
+RingBuffer        streambuf(NULL, STREAM_BUFFER_SIZE) ;
 
-enum qdata_type { QDATA, QSTARTSONG, QSTOPSONG } ;    // datatyp in qdata_struct
-struct qdata_struct
+// how the streams did
+struct streamstats_struct
 {
-  int datatyp ;                                       // Identifier
-  __attribute__((aligned(4))) uint8_t buf[32] ;       // Buffer for chunk
+  uint32_t streams ;                                  // Streams played
+  uint32_t bytes ;                                    // Bytes of all streams
+  uint32_t underruns ;                                // Times both buffers ran dry while the body still came in
+  uint32_t startUs ;                                  // When the current stream was requested
 };
-qdata_struct      outchunk;                             // Data to queue
-qdata_struct      inchunk;                              // Data from queue
+streamstats_struct streamStats ;
+
+// how long a stream takes from its request to the first data at the vs1053
+LatencyHistogram  streamHistogram ;
+
+std::atomic<bool> streamReq(false) ;                    // The http server wants a stream to start
+std::atomic<bool> streamOpen(false) ;                   // The body of the stream still comes in
+std::atomic<bool> streamStopped(false) ;                // Another sound stopped the stream
+std::atomic<bool> streamFirstAudio(false) ;             // The first data of the stream was not played yet
+std::atomic<bool> streamPlaying(false) ;                // The player reads the jitter buffer
+std::atomic<bool> streamReady(false) ;                  // The jitter buffer is there and empty, the http server may write
+bool              streamPrebuffered = false ;             // Enough of the stream is there to start
+bool              streamStarving = false ;                // The stream ran dry and did not get data since
+
+// control commands for the sound task go through their own small queue
+QueueHandle_t     cmdqueue ;                             // Queue for sound commands
+std::atomic<bool> stopPending(false) ;                  // A QSTOPSONG waits for the end of its sound
+
+enum soundcmd_type { QSTARTSONG, QSTOPSONG, QCANCELSONG } ;  // cmdtyp in soundcmd_struct
+struct soundcmd_struct
+{
+  uint8_t cmdtyp ;                                    // Identifier
+  size_t pos ;                                        // Ring buffer write position when queued
+};
+// the sound task sleeps on its task notification, these bits tell why it was woken up
+#define NOTIFY_DATA 0x01                                // Data or a command was queued
+#define NOTIFY_DREQ 0x02                                // DREQ of the vs1053 went high
+void queuefunc (int func) ;                             // Queues a command behind the data written so far
+
+// how busy the sound task is feeding the vs1053
+struct feederstats_struct
+{
+  uint32_t wakeups ;                                  // Times the task woke up to send data
+  uint32_t underruns ;                                // Times the ring buffer ran dry during a sound
+  uint32_t busyUs ;                                   // Time spent sending in the current window
+  uint32_t windowStartUs ;                            // Start of the current window
+  uint16_t loadPermille ;                             // Busy time of the last full window
+  uint16_t peakLoadPermille ;                         // Highest load of all windows
+};
+feederstats_struct feederStats ;
+
+// how long stopping the old sound takes when a new one is triggered
+LatencyHistogram  cancelHistogram ;
+
+#if POLYPHONY_VOICES
+// sounds stored as wav are mixed into one wav stream, so they can overlap
+PcmMixer          mixer(POLYPHONY_VOICES) ;
+WavFileSource     voiceSources[MIXER_MAX_VOICES + 1] ;   // The wav file of every voice, and one for the next sound
+int16_t           mixbuff[MIXER_BLOCK_SAMPLES] ;         // One block of the mix
+bool              mixHeaderPending = false ;             // The wav header still has to be queued
+#endif
+
 uint32_t          mp3filelength ;                        // File length (size)
 uint8_t           tmpbuff[BUFFER_SIZE] ;                        // Input buffer for mp3 or data stream 
-uint8_t*           outqp = outchunk.buf ;                 // Pointer to buffer in outchunk
-
-bool stopTaskMu;
 
 
 bool             filereq = false;                         // Request for new file to play TODO: can filereq and filetoplay be one ?
 String           fileToPlay;                              // the file to play
+String           playingFile;                             // the file currently playing
+std::atomic<int> playingSound(-1) ;                      // number of the playing sound for the status, -1 when none
+uint32_t         fileStartMs = 0;                         // the time in ms to start fileToPlay at
+SemaphoreHandle_t soundFileMutex;                         // the player opens files with it, see lockSoundFile()
+
+// the sound cache keeps the heads of the button sounds in the heap
+SoundCache       soundCache(SOUND_CACHE_BUDGET, SOUND_CACHE_HEAD_SIZE);
+FileCatalogue    fileCatalogue;                           // the files on the SPIFFS for /info
+int              cacheIdx = -1;                           // Cache entry of the playing sound, -1 when not cached
+size_t           cachePos = 0;                            // Bytes of the cache entry already queued
+bool             cacheRefill = false;                     // Reload the button sounds when idle
+
+// time from the button press to the sound
+LatencyTracker   latencyTracker;
+unsigned long    lastStatsReport = 0;                     // When the stats were printed on the serial
+uint32_t         lastStatsTriggers = 0;                   // Triggers seen at the last report
 
 uint8_t          volume = 100;                             // the volume of the vs1053
 
@@ -102,7 +189,6 @@ unsigned long    lastWifiCheck = 0;
 // pins for playing a mp3 via buttons
 struct soundPin_struct {
   int8_t gpio;                                  // Pin number
-  bool curr;                                    // Current state, true = HIGH, false = LOW
   String sound;                                 // which sound nr to play or wifi when to handle wifi stuff
 };
 
@@ -111,31 +197,49 @@ struct soundPin_struct {
 */
 const int buttonNr = 12;
 soundPin_struct soundPins[] = {
-  {4, false, "6"},  // Pig
-  {0, false, "3"}, // Cat
-  {2, false, "4"}, // Horse
+  {4, "6"},  // Pig
+  {0, "3"}, // Cat
+  {2, "4"}, // Horse
 
-  {13, false, "7"}, // Cow
-  {12, false, "5"}, // Chicken
-  {14, false, "8"}, // Duck
+  {13, "7"}, // Cow
+  {12, "5"}, // Chicken
+  {14, "8"}, // Duck
 
 
-  {32, false, "10"}, // Blue Square
-  {33, false, "11"}, // Purple Square
-  {25, false, "9"}, // Bell
-  {26, false, "12"}, // Red Square
-  {3, false, "2"}, // Dog
-  {17, false, "1"} // Sheep
+  {32, "10"}, // Blue Square
+  {33, "11"}, // Purple Square
+  {25, "9"}, // Bell
+  {26, "12"}, // Red Square
+  {3, "2"}, // Dog
+  {17, "1"} // Sheep
 };
 
 
-// what time is the debounce delay ?
-unsigned long lastButtonCheck = 0;
-// what is the debounce delay
-unsigned int debounceDelay = 50;
+// the buttons raise an interrupt on every edge, the isr queues the edge for the player task
+// the http server and the remote triggers queue their commands there too, see PlayerControl.h
+enum buttoninput_t {INPUT_EDGE, INPUT_PLAY, INPUT_STOP};
+struct buttonedge_struct {
+  uint8_t input;                                // buttoninput_t, INPUT_EDGE for an edge of a button
+  uint8_t button;                               // Index in soundPins
+  bool level;                                   // Level after the edge, true = HIGH
+  uint16_t sound;                               // Number of the sound of INPUT_PLAY
+  uint32_t startMs;                             // Where INPUT_PLAY starts the sound, ms from its beginning
+  uint32_t timeUs;                              // micros() when the edge was seen or the command came
+};
+QueueHandle_t     buttonqueue;                  // Queue for button edges and commands
+
+// receives the commands of the remote triggers
+UdpTrigger       udpTrigger;
+
+// debounces the button edges
+ButtonDebouncer  buttonDebouncer(BUTTON_DEBOUNCE_MS * 1000UL);
 
 // the soundboard
+#if VS1053_SIMULATED
+Vs1053Sim vs1053player(VS1053_CS, VS1053_DCS, VS1053_DREQ);
+#else
 Vs1053Esp32 vs1053player(VS1053_CS, VS1053_DCS, VS1053_DREQ);
+#endif
 
 
 // the status led handler
@@ -143,54 +247,35 @@ StatusLed statusLed(STATUS_LED_PIN);
 
 // ### Task stuff ###
 TaskHandle_t Sound_Task;
-TaskHandle_t Stop_Task;
+TaskHandle_t Player_Task;
 
 HttpServer *httpServer;
 
 
 //**************************************************************************************************
-//                                   H A N D L E B Y T E                                           *
+//                                   H A N D L E B Y T E S                                         *
 //**************************************************************************************************
-// Handle the next byte of data from server.                                                       *
-// This byte will be send to the VS1053 most of the time.                                          *
-// Note that the buffer the data chunk must start at an address that is a muttiple of 4.           *
-// Set force to true if chunkbuffer must be flushed.                                               *
+// Handle the next block of data from the file or server.                                          *
+// The block is copied into the ring buffer in one go and the sound task is woken up.              *
+// Returns the number of bytes taken, the rest did not fit into the ring buffer.                   *
 //**************************************************************************************************
-void handlebyte(uint8_t b, bool force) {  
+size_t handlebytes(const uint8_t* data, size_t len) {
 
-  // Handle next byte of MP3/Ogg data
-  if (datamode == DATA)  {
-
-    *outqp++ = b;
-     // Buffer full?
-    if ( outqp == ( outchunk.buf + sizeof(outchunk.buf))) {
-      // Send data to playtask queue.  If the buffer cannot be placed within 200 ticks,
-      // the queue is full, while the sender tries to send more.  The chunk will be dis-
-      // carded it that case.
-      
-      // Send to queue
-      xQueueSend(dataqueue, &outchunk, 200);
-      // Item empty now
-      outqp = outchunk.buf;                           
-    }    
-    }
-    
+  // Handle next block of MP3/Ogg/wav data
+  if (!(datamode & (DATA | MIXING | STREAMED))) {
+    return 0;
   }
 
+  size_t written = ringbuf.write(data, len);
 
-//**************************************************************************************************
-//                                   H A N D L E B Y T E _ C H                                     *
-//**************************************************************************************************
-// Handle the next byte of data from server.                                                       *
-// Chunked transfer encoding aware. Chunk extensions are not supported.                            *
-//**************************************************************************************************
-void handlebyte_ch(uint8_t b, bool force) {  
-  handlebyte(b, force);                         // Normal handling of this byte
-}
-
-
-
+  // Tell the sound task there is something to play
+  if (written) {
+    latencyTracker.mark(STAGE_QUEUED, micros());
+    xTaskNotify(Sound_Task, NOTIFY_DATA, eSetBits);
+  }
 
+  return written;
+}
 
 
 //**************************************************************************************************
@@ -199,45 +284,161 @@ void handlebyte_ch(uint8_t b, bool force) {
 // Setup for the program.                                                                          *
 //**************************************************************************************************
 
-void stopTaskCode(void *parameter) {
+//**************************************************************************************************
+// Sleeps until the sound task is notified or maxWait ticks are over.                              *
+// All bits are cleared, the caller has to check again what it was waiting for.                    *
+//**************************************************************************************************
+void soundTaskWait(TickType_t maxWait) {
+  xTaskNotifyWait ( 0, 0xFFFFFFFF, NULL, maxWait ) ;
+}
 
-  while(true) {
-    if(xQueueReceive(stopque, &stopTaskMu,5)) {
-      if(stopTaskMu == true) {
-        vs1053player.stopSong() ;
-        xQueueReset(dataqueue);
-      }
+//**************************************************************************************************
+// Adds the time since busySince to the feeder load and closes the window after a second.         *
+//**************************************************************************************************
+void feederBusy(uint32_t busySince) {
+  uint32_t now = micros() ;
+  uint32_t window = now - feederStats.windowStartUs ;
+
+  feederStats.busyUs += now - busySince ;
+  if ( window >= 1000000 ) {
+    feederStats.loadPermille = ( (uint64_t) feederStats.busyUs * 1000 ) / window ;
+    if ( feederStats.loadPermille > feederStats.peakLoadPermille ) {
+      feederStats.peakLoadPermille = feederStats.loadPermille ;
     }
+    feederStats.busyUs = 0 ;
+    feederStats.windowStartUs = now ;
   }
 }
 
-void soundTaskCode(void *parameter ) {
- for(;;) {
+void soundTaskCode(void * ) {
+  soundcmd_struct cmd;                                              // Command from the queue
+  soundcmd_struct next;                                             // Command behind cmd
+  bool            cmdPending = false;                               // cmd waits for its turn
+  bool            firstChunk = false;                               // Next chunk starts a sound
+  bool            playing = false;                                  // A sound was started and not stopped
+  bool            starving = false;                                 // Ring buffer ran dry while playing
+  uint8_t*        chunk;                                            // Next data in the ring buffer
+  size_t          avail;                                            // Bytes we may play now
+  size_t          len;                                              // Length of the next chunk
+  uint32_t        busySince;                                        // When the task woke up
+  uint32_t        cancelStart;                                      // When cancelling started
+
+#if VS1053_DREQ_IRQ && !VS1053_SIMULATED
+  // DREQ going high wakes this task, no more polling when the FIFO is full
+  vs1053player.enableDreqInterrupt( xTaskGetCurrentTaskHandle(), NOTIFY_DREQ ) ;
+#endif
+
+  for(;;) {
+    busySince = micros() ;
+
+    // Look at the data before the commands, a command queued later can not be overtaken this way
+    avail = ringbuf.readAvailable() ;
+
+    if ( !cmdPending ) {
+      cmdPending = xQueueReceive ( cmdqueue, &cmd, 0 ) ;
+    }
+
+    if ( cmdPending ) {
+      // Data queued in front of the command has to be played first, except when cancelling
+      size_t beforeCmd = cmd.pos - ringbuf.readPosition() ;
 
-  if ( xQueueReceive ( dataqueue, &inchunk, 5 ) )
-    {
-      while ( !vs1053player.data_request() )                       // If FIFO is full..
-      {
-        vTaskDelay ( 1 ) ;                                          // Yes, take a break
+      // A cancel drops that data anyway, it takes the place of the waiting command
+      if ( beforeCmd && cmd.cmdtyp != QCANCELSONG &&
+           xQueuePeek ( cmdqueue, &next, 0 ) && next.cmdtyp == QCANCELSONG ) {
+        if ( cmd.cmdtyp == QSTOPSONG ) {
+          stopPending = false ;
+        }
+        xQueueReceive ( cmdqueue, &cmd, 0 ) ;
+      }
+
+      if ( cmd.cmdtyp == QCANCELSONG || beforeCmd == 0 ) {
+        switch ( cmd.cmdtyp )                                       // What kind of command?
+        {
+          case QSTARTSONG:
+            vs1053player.startSong() ;                             // START, start player
+            firstChunk = true ;
+            playing = true ;
+            break ;
+          case QSTOPSONG:
+            stopPending = false ;                                  // Too late to cancel now
+            vs1053player.stopSong() ;                              // STOP, stop player
+            playing = false ;
+            break ;
+          case QCANCELSONG:
+            ringbuf.discardTo( cmd.pos ) ;                         // CANCEL, drop the old sound
+            cancelStart = micros() ;
+#if FAST_RETRIGGER
+            vs1053player.cancelSong() ;                            // and cancel the decoding
+#else
+            vs1053player.stopSong() ;                              // and stop the player
+#endif
+            cancelHistogram.record( micros() - cancelStart ) ;
+            ESP_LOGD("Sound", "Cancel took %u us", micros() - cancelStart);
+            playing = false ;
+            break ;
+          default:
+            break ;
+        }
+        cmdPending = false ;
+        starving = false ;
+        feederBusy( busySince ) ;
+        continue ;
       }
-      switch ( inchunk.datatyp )                                    // What kind of chunk?
-      {
-        case QDATA:          
-          vs1053player.playChunk( inchunk.buf,                    // DATA, send to player
-                                    sizeof(inchunk.buf));          
-          break ;
-        case QSTARTSONG:
-          vs1053player.startSong() ;                               // START, start player
-          break ;
-        case QSTOPSONG:
-          //vs1053player.setVolume ( 0 ) ;                           // Mute
-          vs1053player.stopSong() ;                                // STOP, stop player                    
-          break ;
-        default:
-          break ;
+
+      if ( avail > beforeCmd ) {
+        avail = beforeCmd ;
       }
     }
- }
+
+    if ( avail == 0 ) {
+      // The vs1053 wants data which is not there yet
+      if ( playing && !starving && vs1053player.data_request() ) {
+        feederStats.underruns++ ;
+        starving = true ;
+      }
+      feederBusy( busySince ) ;
+      soundTaskWait ( 5 ) ;                                         // Wait for data or a command
+      continue ;
+    }
+    starving = false ;
+
+    if ( !vs1053player.data_request() )                             // If FIFO is full..
+    {
+      feederBusy( busySince ) ;
+#if VS1053_DREQ_IRQ
+      soundTaskWait ( 5 ) ;                                         // Yes, sleep until DREQ goes high
+#else
+      vTaskDelay ( 1 ) ;                                            // Yes, take a break
+#endif
+      continue ;
+    }
+
+    // DREQ is high so the vs1053 takes at least 32 bytes, fill the FIFO as long as it stays high
+    // all chunks go out in one SPI transaction
+    feederStats.wakeups++ ;
+    vs1053player.beginBurst() ;
+    do {
+      len = ringbuf.peek( &chunk ) ;
+      if ( len > avail ) {
+        len = avail ;
+      }
+      if ( len > 32 ) {
+        len = 32 ;
+      }
+      if ( firstChunk ) {
+        latencyTracker.mark( STAGE_PLAYED, micros() ) ;
+        if ( streamFirstAudio.exchange( false ) ) {
+          streamHistogram.record( micros() - streamStats.startUs ) ;
+        }
+        firstChunk = false ;
+      }
+      vs1053player.playBurstChunk( chunk, len ) ;                  // DATA, send to player
+      ringbuf.consume( len ) ;
+      avail -= len ;
+    } while ( avail && vs1053player.data_request() ) ;
+    vs1053player.endBurst() ;
+    feederBusy( busySince ) ;
+  }
 }
 
 
@@ -245,27 +446,66 @@ void soundTaskCode(void *parameter ) {
 //**************************************************************************************************
 //                              INIT THE SOUND BUTTONS                                             *
 //**************************************************************************************************
+void IRAM_ATTR buttonIsr(void *arg) {
+  buttonedge_struct edge;
+  BaseType_t        woken = pdFALSE;
+
+  edge.input = INPUT_EDGE;
+  edge.button = (uintptr_t) arg;
+  edge.level = digitalRead(soundPins[edge.button].gpio) == HIGH;
+  edge.timeUs = micros();
+
+  // When the queue is full the edge is lost, poll() in the debouncer takes the level later
+  xQueueSendFromISR(buttonqueue, &edge, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
 void initSoundButtons() {
   // init sound button pins
   ESP_LOGI("Button", "Initializing: Buttons");
+
+  buttonqueue = xQueueCreate(BUTTONQSIZ, sizeof(buttonedge_struct));
+
   for (int i = 0 ; i < buttonNr; i++ ) {
     int8_t  buttonPin = soundPins[i].gpio;
     ESP_LOGI("Button", "Initializing Button at pin: %d", buttonPin);
     pinMode(buttonPin, INPUT_PULLUP);
-    soundPins[i].curr = digitalRead(buttonPin);
-    ESP_LOGD("Button", "Button at pin: %d is in state %d", buttonPin, soundPins[i].curr);
+    bool level = digitalRead(buttonPin) == HIGH;
+    buttonDebouncer.init(i, level, micros());
+    attachInterruptArg(buttonPin, buttonIsr, (void*)(uintptr_t) i, CHANGE);
+    ESP_LOGD("Button", "Button at pin: %d is in state %d", buttonPin, level);
+  }
+}
+
+//**************************************************************************************************
+//                                   C A N C E L D R A I N I N G                                   *
+//**************************************************************************************************
+// When a sound was read to its end it is STOPPED here, but the rest of it may still be in the     *
+// ring buffer with its QSTOPSONG waiting behind it.  A new sound or a stop cancels that rest      *
+// instead of waiting for it and for the full stopSong().                                          *
+//**************************************************************************************************
+void cancelDraining() {
+  if (datamode == STOPPED && (stopPending || ringbuf.readAvailable())) {
+    queuefunc(QCANCELSONG);
   }
 }
 
 //**************************************************************************************************
 //                                      INIT SOUND TO PLAY                                         *
 //**************************************************************************************************
-void initStartSound(String soundToPlay) {
-  if (datamode & ( DATA)) {
+void initStartSound(const char* soundToPlay, uint32_t startMs = 0) {
+  if (datamode & (DATA | STREAMED | SOUNDFINISHED)) {
     datamode = STOPREQD ;                           // Request STOP
   }
+  cancelDraining();
 
-  fileToPlay = "/" + soundToPlay + ".mp3";
+  // the String keeps its buffer, a trigger does not take the heap
+  char path[HTTP_MAX_NAME + 6];
+  snprintf(path, sizeof(path), "/%s.mp3", soundToPlay);
+  fileToPlay = path;
+  fileStartMs = startMs;
   filereq = true;
 }
 
@@ -307,6 +547,7 @@ void startWifi() {
       ESP_LOGI("Wifi", "Ip address of esp is %s", WiFi.localIP().toString().c_str());
       // start http server
       httpServer->initHttpServer();
+      udpTrigger.begin(TRIGGER_UDP_PORT);
       wifiTurningOn = false;
       lastWifiCheck = 0;
     } else {
@@ -334,6 +575,7 @@ void startWifi() {
       statusLed.setNewCfg(LED_SPEED_WIFI_AP_MODE);
       // start http server
       httpServer->initHttpServer();
+      udpTrigger.begin(TRIGGER_UDP_PORT);
     } else {
       ESP_LOGI("Wifi", "Trying to setup wifi with ssid: %s and password: %s.", WIFI_SSID, WIFI_PASS);
       WiFi.begin(WIFI_SSID, WIFI_PASS);
@@ -372,56 +614,151 @@ bool openLocalFile(const char * path) {
 
 
 //**************************************************************************************************
-//                                     B U T T O N L O O P                                         *
+//                                C A C H E B U T T O N S O U N D S                                *
+//**************************************************************************************************
+// Loads the heads of all sounds mapped to a button into the sound cache.                          *
+//**************************************************************************************************
+void cacheButtonSounds() {
+  for (int i = 0 ; i < buttonNr ; i++ ) {
+    soundCache.load("/" + soundPins[i].sound + ".mp3");
+  }
+
+  ESP_LOGI("Cache", "Button sounds cached, %d of %d bytes resident, %d hits, %d misses", 
+           soundCache.bytesResident, SOUND_CACHE_BUDGET, soundCache.hits, soundCache.misses);
+}
+
+
+
+//**************************************************************************************************
+//                                   B U T T O N E V E N T                                         *
+//**************************************************************************************************
+// Handles a debounced button event.                                                               *
 //**************************************************************************************************
-void buttonLoop() {
+void buttonEvent(uint8_t button, buttonEvent_t event, uint32_t timeUs) {
 
-  // do nothing when any button was pushed in the debouncedelay time
-  if ((millis() - lastButtonCheck) < debounceDelay) {
+  // Button is low well than it is pushed
+  if (event != BUTTON_PRESSED) {
     return;
   }
 
-  // debounce time over
-  lastButtonCheck = millis();
+  int8_t buttonPin = soundPins[button].gpio;
 
-  bool oneButtonPressed = false;
-  String soundToPlay = "";
+  // Pushing a button while another one is still pushed switches the wifi
+  for (int i = 0 ; i < buttonNr ; i++ ) {
+    if (i != button && buttonDebouncer.isPressed(i)) {
+      turnWifiOn = !turnWifiOn;
+      ESP_LOGD("Button", "GPIO_%02d is now LOW switching wifi to: %d", buttonPin, turnWifiOn);
+      return;
+    }
+  }
 
+  ESP_LOGD("Button", "GPIO_%02d is now LOW playing sound: %s", buttonPin, soundPins[button].sound.c_str());
+  latencyTracker.start(timeUs);
+  initStartSound(soundPins[button].sound.c_str());
+}
 
-  int8_t buttonPin;
-  for (int i = 0 ; i < buttonNr ; i++ ) {
+//**************************************************************************************************
+//                                   C O M M A N D E V E N T                                       *
+//**************************************************************************************************
+// Handles a command of the http server or of a remote trigger.                                    *
+//**************************************************************************************************
+void commandEvent(const buttonedge_struct &command) {
+  if (command.input == INPUT_PLAY) {
+    ESP_LOGD("Command", "Playing sound: %u", command.sound);
+    latencyTracker.start(command.timeUs);
+    char sound[6];
+    snprintf(sound, sizeof(sound), "%u", command.sound);
+    initStartSound(sound, command.startMs);
+    return;
+  }
 
-    buttonPin = soundPins[i].gpio;
-    // get the current state of the button
-    bool buttonIsHigh = (digitalRead(buttonPin) == HIGH);
+  // a sound asked for just before is not started
+  ESP_LOGD("Command", "Stopping the sound");
+  filereq = false;
+#if POLYPHONY_VOICES
+  if (datamode == MIXING) {
+    mixer.stopAll();
+    queuefunc(QCANCELSONG);
+    datamode = STOPPED;
+    playingSound = -1;
+  }
+#endif
+  if (datamode & (DATA | STREAMED | SOUNDFINISHED)) {
+    datamode = STOPREQD;
+  }
+  cancelDraining();
+}
 
-    // Change seen?
-    if (buttonIsHigh != soundPins[i].curr) {
+//**************************************************************************************************
+//                                    P L A Y E R C O N T R O L                                    *
+//**************************************************************************************************
+// Queues the commands of the other tasks for the player task, see PlayerControl.h.                *
+//**************************************************************************************************
+bool playerPlay(uint16_t sound, uint32_t startMs, uint32_t timeUs) {
+  buttonedge_struct command = {};
+
+  command.input = INPUT_PLAY;
+  command.sound = sound;
+  command.startMs = startMs;
+  command.timeUs = timeUs;
+  return xQueueSend(buttonqueue, &command, 0) == pdTRUE;
+}
 
-      // And the new level
-      soundPins[i].curr = buttonIsHigh;
+bool playerStop(uint32_t timeUs) {
+  buttonedge_struct command = {};
 
-      // Button is low well than it is pushed
-      if (buttonIsHigh == false) {
+  command.input = INPUT_STOP;
+  command.timeUs = timeUs;
+  return xQueueSend(buttonqueue, &command, 0) == pdTRUE;
+}
 
-        if(oneButtonPressed) {
-          turnWifiOn = !turnWifiOn;
-          ESP_LOGD("Button", "GPIO_%02d is now LOW switching wifi to: %d", buttonPin, turnWifiOn);
-          return;
-        }
+void playerVolume(uint8_t percent) {
+  // loop() passes it on to the vs1053
+  volume = percent > 100 ? 100 : percent;
+}
 
-        ESP_LOGD("Button", "GPIO_%02d is now LOW playing sound: %s", buttonPin, soundPins[i].sound.c_str());
-        soundToPlay = soundPins[i].sound;
-        oneButtonPressed = true;
-      }      
-    } // level of the button changed
+//**************************************************************************************************
+//                                     B U T T O N L O O P                                         *
+//**************************************************************************************************
+// Takes the button edges from the isr queue, waits at most maxWait ticks for the first one.       *
+//**************************************************************************************************
+void buttonLoop(TickType_t maxWait) {
+  buttonedge_struct edge;
+  buttonEvent_t     event;
+  bool              unsettled = false;
+
+  // a level change in the debounce time is taken when the time is over
+  for (int i = 0 ; i < buttonNr ; i++ ) {
+    if (buttonDebouncer.unsettled(i)) {
+      unsettled = true;
+      break;
+    }
+  }
+  if (unsettled && maxWait > pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS)) {
+    maxWait = pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS);
+  }
+
+  while (xQueueReceive(buttonqueue, &edge, maxWait)) {
+    maxWait = 0;
+    if (edge.input != INPUT_EDGE) {
+      commandEvent(edge);
+      continue;
+    }
+    event = buttonDebouncer.edge(edge.button, edge.level, edge.timeUs);
+    buttonEvent(edge.button, event, edge.timeUs);
+  }
 
-    if (soundToPlay != "") {
-      initStartSound(soundToPlay);
+  if (unsettled) {
+    uint32_t now = micros();
+    for (int i = 0 ; i < buttonNr ; i++ ) {
+      event = buttonDebouncer.poll(i, now);
+      buttonEvent(i, event, now);
     }
   }
 }
 
+
+
 //**************************************************************************************************
 //                                      Q U E U E F U N C                                          *
 //**************************************************************************************************
@@ -429,16 +766,300 @@ void buttonLoop() {
 //**************************************************************************************************
 void queuefunc (int func) {
   // Special function to queue
-  qdata_struct     specchunk ;                          
+  soundcmd_struct  speccmd ;
 
-  // Put function in datatyp
-  specchunk.datatyp = func;                            
+  // Put function in cmdtyp
+  speccmd.cmdtyp = func;
+  // Everything written up to now comes before the function
+  speccmd.pos = ringbuf.writePosition();
 
   // Send to queue
-  xQueueSend (dataqueue,&specchunk, 200) ;           
+  xQueueSend (cmdqueue, &speccmd, 200) ;
+  xTaskNotify(Sound_Task, NOTIFY_DATA, eSetBits);
+}
+
+
+
+#if POLYPHONY_VOICES
+//**************************************************************************************************
+//                                        S T A R T V O I C E                                      *
+//**************************************************************************************************
+// Plays the wav version of the sound on a voice of the mixer, returns false when there is none.   *
+// When all voices are busy the oldest sound is stopped, once the new one could be opened.         *
+//**************************************************************************************************
+bool startVoice(const String &mp3Path) {
+  String wavPath = mp3Path.substring(0, mp3Path.length() - 4) + ".wav";
+
+  if (SPIFFS.exists(wavPath) == false) {
+    return false;
+  }
+
+  // a source no voice plays, there is one more than voices
+  WavFileSource* source = voiceSources;
+  while (mixer.uses(source)) {
+    source++;
+  }
+  if (!source->open(wavPath, MIXER_SAMPLE_RATE, MIXER_CHANNELS)) {
+    return false;
+  }
+  uint8_t voice = mixer.allocVoice();
+  latencyTracker.mark(STAGE_OPENED, micros());
+
+  // The first voice starts a new wav stream on the vs1053
+  if (datamode != MIXING) {
+    datamode = MIXING;
+    mixHeaderPending = true;
+    queuefunc(QSTARTSONG);
+  }
+
+  ESP_LOGD("Sound", "Mixing %s on voice %d", wavPath.c_str(), voice);
+  mixer.startVoice(voice, source);
+  return true;
+}
+
+//**************************************************************************************************
+//                                           M I X L O O P                                         *
+//**************************************************************************************************
+// Queues as many blocks of the mix as fit into the ring buffer.                                   *
+//**************************************************************************************************
+void mixLoop() {
+  if (mixHeaderPending) {
+    // The old sound may still fill the ring buffer until the sound task dropped it
+    if (ringbuf.writeAvailable() < WAV_HEADER_SIZE) {
+      return;
+    }
+    uint8_t header[WAV_HEADER_SIZE];
+    PcmMixer::wavHeader(header, MIXER_SAMPLE_RATE, MIXER_CHANNELS);
+    handlebytes(header, sizeof(header));
+    mixHeaderPending = false;
+  }
+
+  while (ringbuf.writeAvailable() >= sizeof(mixbuff)) {
+    // All voices are over
+    if (!mixer.mix(mixbuff, MIXER_BLOCK_SAMPLES)) {
+      datamode = SOUNDFINISHED;
+      return;
+    }
+    handlebytes((uint8_t*) mixbuff, sizeof(mixbuff));
+  }
+}
+#endif
+
+
+
+//**************************************************************************************************
+//                                        S T A R T S O U N D                                      *
+//**************************************************************************************************
+// Opens fileToPlay and starts sending it, called with the lock of the sound files.                *
+//**************************************************************************************************
+void startSound() {
+  playingFile = fileToPlay;
+
+#if POLYPHONY_VOICES
+  // A sound stored as wav is mixed with the sounds already playing
+  if (startVoice(playingFile)) {
+    playingSound = atoi(playingFile.c_str() + 1);
+    return;
+  }
+
+  // An mp3 can not be mixed, it ends the mix
+  if (datamode == MIXING) {
+    mixer.stopAll();
+    queuefunc(QCANCELSONG);
+    datamode = STOPPED;
+  }
+#endif
+
+  // Start in the middle of the sound, the frame index knows where the frame at that time is
+  uint32_t startOffset = 0;
+  if (fileStartMs && !Mp3IndexFile::timeOffset(playingFile, fileStartMs, &startOffset)) {
+    ESP_LOGE("MP3", "No frame at %u ms in %s, starting at the beginning", fileStartMs, playingFile.c_str());
+  }
+
+  // Start from RAM when the head of the sound is in the cache
+  cacheIdx = startOffset ? -1 : soundCache.acquire(playingFile);
+  cachePos = 0;
+
+  if (startOffset) {
+    if (openLocalFile(playingFile.c_str()) == false) {
+      return;
+    }
+    mp3file.seek(startOffset);
+    mp3filelength = mp3file.available();
+  } else if (cacheIdx >= 0) {
+    mp3filelength = soundCache.fileSize(cacheIdx);
+  } else {
+    bool fileExists = openLocalFile(playingFile.c_str());
+    if (fileExists == false) {
+      return;
+    }
+    cacheRefill = true;
+  }
+  latencyTracker.mark(STAGE_OPENED, micros());
+
+  // set the mode to data
+  datamode = DATA;
+  playingSound = atoi(playingFile.c_str() + 1);
+  queuefunc(QSTARTSONG);
+}
+
+//**************************************************************************************************
+//                                      L O C K S O U N D F I L E                                  *
+//**************************************************************************************************
+// The player only opens its files with this lock, an upload takes it to replace a file.           *
+//**************************************************************************************************
+bool lockSoundFile(const char* path) {
+  xSemaphoreTake(soundFileMutex, portMAX_DELAY);
+
+  // the file of the current sound stays until it finished, the rest of it may be read later
+  bool playing = (datamode & (DATA | STOPREQD | SOUNDFINISHED)) && playingFile == path;
+#if POLYPHONY_VOICES
+  // the voices keep their wav files open until the mix is over
+  size_t len = strlen(path);
+  playing = playing || (datamode == MIXING && len > 4 && strcmp(path + len - 4, ".wav") == 0);
+#endif
+
+  if (playing) {
+    xSemaphoreGive(soundFileMutex);
+    return false;
+  }
+  return true;
+}
+
+void unlockSoundFile() {
+  xSemaphoreGive(soundFileMutex);
+}
+
+//**************************************************************************************************
+//                                      S T R E A M B E G I N                                      *
+//**************************************************************************************************
+// Called by the http server, the data of streamWrite() is played as it comes in.                  *
+//**************************************************************************************************
+bool streamBegin() {
+  if (streamOpen || streamReq || streamPlaying) {
+    return false;
+  }
+
+  // the player sets up the buffer, streamWrite() takes nothing until then
+  streamStopped = false;
+  streamStats.startUs = micros();
+  streamFirstAudio = true;
+  streamOpen = true;
+  streamReq = true;
+  return true;
+}
+
+size_t streamWrite(const uint8_t* data, size_t len) {
+  if (streamStopped || !streamReady) {
+    return 0;
+  }
+
+  size_t written = streambuf.write(data, len);
+  streamStats.bytes += written;
+  return written;
+}
+
+void streamEnd() {
+  streamOpen = false;
+}
+
+bool streamActive() {
+  return !streamStopped;
 }
 
+//**************************************************************************************************
+//                                      S T A R T S T R E A M                                      *
+//**************************************************************************************************
+// Starts reading the jitter buffer, the vs1053 is started when the prebuffer is there.            *
+//**************************************************************************************************
+void startStream() {
+  streamReq = false;
+  // only the player task starts a sample, startUs was set before streamReq
+  latencyTracker.start(streamStats.startUs);
+
+  if (streambufdata == NULL) {
+    streambufdata = (uint8_t*) malloc(STREAM_BUFFER_SIZE);
+    if (streambufdata == NULL) {
+      ESP_LOGE("Stream", "No memory for the jitter buffer");
+      streamFirstAudio = false;
+      streamStopped = true;
+      return;
+    }
+  }
+  // a stopped stream may have left data behind, the http server does not write before streamReady
+  streambuf.setStorage(streambufdata);
+
+#if POLYPHONY_VOICES
+  // The stream ends the mix
+  if (datamode == MIXING) {
+    mixer.stopAll();
+    queuefunc(QCANCELSONG);
+    datamode = STOPPED;
+  }
+#endif
+
+  streamPrebuffered = false;
+  streamStarving = false;
+  streamStats.streams++;
+  streamPlaying = true;
+  datamode = STREAMED;
+  playingSound = -1;
+  streamReady = true;
+}
+
+//**************************************************************************************************
+//                                   F R E E S T R E A M B U F F E R                               *
+//**************************************************************************************************
+// Gives the jitter buffer back to the heap once the http server is done with the stream.          *
+//**************************************************************************************************
+void freeStreamBuffer() {
+  if (streambufdata == NULL || streamOpen || streamPlaying || streamReq) {
+    return;
+  }
+  streambuf.setStorage(NULL);
+  free(streambufdata);
+  streambufdata = NULL;
+}
+
+//**************************************************************************************************
+//                                       S T R E A M L O O P                                       *
+//**************************************************************************************************
+// Queues what came in of the stream, the http server waits when both buffers are full.            *
+//**************************************************************************************************
+void streamLoop() {
+  size_t avail = streambuf.readAvailable();
+
+  // Start with enough data to ride out the gaps of the network
+  if (!streamPrebuffered) {
+    if (avail < STREAM_PREBUFFER && streamOpen) {
+      return;
+    }
+    streamPrebuffered = true;
+    latencyTracker.mark(STAGE_OPENED, micros());
+    queuefunc(QSTARTSONG);
+  }
 
+  if (avail == 0) {
+    if (!streamOpen) {
+      datamode = SOUNDFINISHED;                           // The whole body is played
+    } else if (!streamStarving && ringbuf.readAvailable() == 0) {
+      streamStats.underruns++;
+      streamStarving = true;
+    }
+    return;
+  }
+  streamStarving = false;
+
+  uint8_t* data;
+  size_t   len;
+  while ((len = streambuf.peek(&data)) > 0) {
+    size_t taken = handlebytes(data, len);
+    streambuf.consume(taken);
+    if (taken < len) {
+      break;
+    }
+  }
+}
 
 //**************************************************************************************************
 //                                           M P 3 L O O P                                         *
@@ -455,6 +1076,18 @@ void mp3loop() {
   uint32_t        qspace;                               // Free space in data queue
   int             res = 0;                              // Result reading from mp3 stream
 
+#if POLYPHONY_VOICES
+  // Keep the ring buffer filled up with the mix
+  if (datamode & (MIXING)) {
+    mixLoop();
+  }
+#endif
+
+  // Move the stream from the jitter buffer into the ring buffer
+  if (datamode & STREAMED) {
+    streamLoop();
+  }
+
   // Try to keep the ringbuffer filled up by adding as much bytes as possible
   // Test op playing
   if (datamode & (DATA)) {
@@ -462,11 +1095,29 @@ void mp3loop() {
     // Reduce byte count for this mp3loop()
     maxchunk = sizeof(tmpbuff) ;                         
 
-    // Compute free space in data queue
-    qspace = uxQueueSpacesAvailable( dataqueue ) * sizeof(qdata_struct);
+    // Compute free space in ring buffer
+    qspace = ringbuf.writeAvailable();
 
     // Bytes left in file 
     av = mp3filelength ; 
+
+    if (cacheIdx >= 0 && cachePos < soundCache.length(cacheIdx)) {
+      // The head of the sound is in the cache, queue it straight from RAM
+      res = handlebytes(soundCache.data(cacheIdx) + cachePos, soundCache.length(cacheIdx) - cachePos);
+      cachePos += res;
+      mp3filelength -= res;
+      res = 0;
+    } else if (!mp3file && av) {
+      // The head came from the cache, the rest comes from the flash
+      if (openLocalFile(playingFile.c_str())) {
+        mp3file.seek(cachePos);
+        mp3filelength = mp3file.available();
+      } else {
+        mp3filelength = 0;
+      }
+      maxchunk = 0;
+    }
+
     // Reduce byte count for this mp3loop()                              
     if (av < maxchunk) {
       maxchunk = av ;
@@ -478,40 +1129,58 @@ void mp3loop() {
     }
 
     // Anything to read?
-    if ( maxchunk ) {
+    if ( maxchunk && mp3file ) {
       // Read a block of data
       res = mp3file.read ( tmpbuff, maxchunk ) ;       
       // Number of bytes left
       mp3filelength -= res ;                           
     }
      
-    for ( int i = 0 ; i < res ; i++ ) {
-      // Handle one byte 
-      handlebyte(tmpbuff[i], false) ;                     
+    if ( res > 0 ) {
+      // Handle the whole block
+      handlebytes(tmpbuff, res) ;
     }
   }
 
+  // A stream ends the sound playing now
+  if (streamReq && (datamode & (DATA))) {
+    datamode = STOPREQD;
+  }
+
   // STOP requested?
   if (datamode == STOPREQD || datamode == SOUNDFINISHED) {
     ESP_LOGD("Sound", "STOP requested");
 
     mp3file.close();
+    soundCache.release(cacheIdx);
+    cacheIdx = -1;
+
+    // the rest of a stream is dropped, the http server stops taking its body
+    if (streamPlaying) {
+      streamReady = false;
+      streamFirstAudio = false;
+      if (streamOpen) {
+        streamStopped = true;
+      }
+      streambuf.consume(streambuf.readAvailable());
+      streamPlaying = false;
+    }
 
-    // this happens when the user pushed a button and a file was still playing we need to do this over the stop task
-    // when not doing this over the stop task there may be still data in the sound task queue which is in front of the stop request
+    // this happens when the user pushed a button and a file was still playing
+    // the sound task drops all data of this sound still in the ring buffer and stops the player
     if(datamode == STOPREQD) {  
-      bool stop = true;
-      xQueueSend(stopque,&stop, pdMS_TO_TICKS(10));    
+      queuefunc(QCANCELSONG);
     }  
 
     // The file is finished playing and it should stop when all data has ben played
     if(datamode == SOUNDFINISHED) {  
-      outqp = outchunk.buf;       
+      stopPending = true;
       queuefunc(QSTOPSONG);                            
     }
 
     // Yes, state becomes STOPPED
     datamode = STOPPED;                               
+    playingSound = -1;
   }
 
   // Test op playing
@@ -525,14 +1194,28 @@ void mp3loop() {
   // new file to play ?
   if (filereq) {
     filereq = false;
+    // an upload does not replace the file while it is opened
+    xSemaphoreTake(soundFileMutex, portMAX_DELAY);
+    startSound();
+    xSemaphoreGive(soundFileMutex);
+    return;
+  }
 
-    bool fileExists = openLocalFile(fileToPlay.c_str());
-    if (fileExists == false) {
-      return;
-    }
+  // new stream to play ?
+  if (streamReq) {
+    startStream();
+    return;
+  }
 
-    // set the mode to data
-    datamode = DATA;
+  // The stream is over, the next sound may play already
+  freeStreamBuffer();
+
+  // Nothing to play, time to bring the button sounds back into the cache
+  if (datamode == STOPPED && cacheRefill) {
+    cacheRefill = false;
+    xSemaphoreTake(soundFileMutex, portMAX_DELAY);
+    cacheButtonSounds();
+    xSemaphoreGive(soundFileMutex);
   }
 }
 
@@ -543,6 +1226,105 @@ void mp3loop() {
 
 
   //**************************************************************************************************
+//                                          PLAYER TASK                                            *
+//**************************************************************************************************
+// Handles the buttons and reads the sounds into the ring buffer, so a button press does not wait  *
+// for the http server or the wifi in loop().                                                      *
+//**************************************************************************************************
+void playerTaskCode(void *) {
+  for(;;) {
+    // Wait for a button only shortly while a sound is read, the ring buffer must stay filled
+    buttonLoop((datamode & (DATA | MIXING | STREAMED)) ? 1 : pdMS_TO_TICKS(PLAYER_IDLE_WAIT_MS));
+    mp3loop();
+  }
+}
+
+
+
+//**************************************************************************************************
+//                                        P R I N T S T A T S                                      *
+//**************************************************************************************************
+// Prints all runtime statistics as one json object.                                               *
+//**************************************************************************************************
+void printHistogram(Print &out, const LatencyHistogram &hist) {
+  printFormatted(out, "{\"count\" : %u, \"p50\" : %u, \"p95\" : %u, \"p99\" : %u, \"max\" : %u}",
+                 hist.count(), hist.percentile(50), hist.percentile(95), hist.percentile(99), hist.max());
+}
+
+void printStats(Print &out) {
+  out.print("{\"latency\" : {");
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    latencyStage_t stage = (latencyStage_t) i;
+    printFormatted(out, "%s\"%s\" : ", i == 0 ? "" : ", ", LatencyTracker::stageName(stage));
+    printHistogram(out, latencyTracker.histogram(stage));
+  }
+  out.print("}, \"cancel\" : ");
+  printHistogram(out, cancelHistogram);
+  printFormatted(out, ", \"feeder\" : {\"loadPermille\" : %u, \"peakLoadPermille\" : %u, \"wakeups\" : %u, \"underruns\" : %u}",
+                 feederStats.loadPermille, feederStats.peakLoadPermille, feederStats.wakeups, feederStats.underruns);
+  printFormatted(out, ", \"spi\" : {\"sciTransactions\" : %u, \"sdiTransactions\" : %u, \"sdiBytes\" : %u}",
+                 vs1053player.sciTransactions, vs1053player.sdiTransactions, vs1053player.sdiBytes);
+#if VS1053_SIMULATED
+  printFormatted(out, ", \"sim\" : {\"decodedBytes\" : %u, \"underruns\" : %u, \"overflows\" : %u, \"cancels\" : %u, \"resets\" : %u",
+                 vs1053player.decodedBytes, vs1053player.underruns, vs1053player.overflows,
+                 vs1053player.cancels, vs1053player.resets);
+  printFormatted(out, ", \"startLatencyUs\" : %u, \"midFrameStarts\" : %u, \"strayBytes\" : %u}",
+                 vs1053player.startLatencyUs, vs1053player.midFrameStarts, vs1053player.strayBytes);
+#endif
+#if POLYPHONY_VOICES
+  printFormatted(out, ", \"mixer\" : {\"voices\" : %u, \"active\" : %u, \"steals\" : %u}",
+                 mixer.voices(), mixer.activeVoices(), mixer.steals);
+#endif
+  printFormatted(out, ", \"stream\" : {\"streams\" : %u, \"bytes\" : %u, \"underruns\" : %u, \"firstAudio\" : ",
+                 streamStats.streams, streamStats.bytes, streamStats.underruns);
+  printHistogram(out, streamHistogram);
+  out.print("}, \"trigger\" : ");
+  udpTrigger.printStats(out);
+  out.print(", \"soundCache\" : ");
+  soundCache.printStats(out);
+  printFormatted(out, ", \"heap\" : {\"free\" : %u, \"minFree\" : %u, \"largestFree\" : %u, \"allocations\" : %u}",
+                 ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(), heapAllocations());
+  out.print("}");
+}
+
+//**************************************************************************************************
+//                                   R E A D B O A R D S T A T U S                                 *
+//**************************************************************************************************
+// The status pushed to the clients of /events, only reads values the player writes atomically.    *
+//**************************************************************************************************
+void readBoardStatus(boardStatus_struct &status) {
+  status.sound = playingSound;
+  status.streaming = streamPlaying;
+  status.freeHeap = ESP.getFreeHeap();
+  status.minFreeHeap = ESP.getMinFreeHeap();
+  status.queuePercent = (uint32_t) ringbuf.readAvailable() * 100 / RINGBUF_SIZE;
+}
+
+
+//**************************************************************************************************
+//                                        S T A T S L O O P                                        *
+//**************************************************************************************************
+// Prints the stats on the serial from time to time when something was played.                     *
+//**************************************************************************************************
+void statsLoop() {
+  if ((millis() - lastStatsReport) < STATS_REPORT_INTERVAL) {
+    return;
+  }
+  lastStatsReport = millis();
+
+  uint32_t triggers = latencyTracker.histogram(STAGE_OPENED).count();
+  if (triggers == lastStatsTriggers) {
+    return;
+  }
+  lastStatsTriggers = triggers;
+
+  printStats(Serial);
+  Serial.println();
+}
+
+
+
+//**************************************************************************************************
 //                                           S E T U P                                             *
 //**************************************************************************************************
 // Setup for the program.                                                                          *
@@ -563,12 +1345,23 @@ void setup() {
   }
 
   statusLed.setNewCfg(LED_SPEED_NORMAL);
-  initSoundButtons();
+
+  soundFileMutex = xSemaphoreCreateMutex();
+
+  // keep the button sounds in the heap
+  soundCache.begin();
+  cacheButtonSounds();
+
+  fileCatalogue.begin();
 
   httpServer = new HttpServer();
 
 
   // Initialize VS1053 player
+#if VS1053_SIMULATED
+  vs1053player.setClock(micros);
+  vs1053player.setBitrate(VS1053_SIM_BITRATE);
+#endif
   vs1053player.begin();
 
   delay(10);
@@ -576,11 +1369,8 @@ void setup() {
   wifiTurnedOn = false;
   turnWifiOn = false;
 
-  // init the data queue
-  dataqueue = xQueueCreate (QSIZ, sizeof(qdata_struct));
-
-  // init the stop queue
-  stopque = xQueueCreate(1,sizeof(bool));
+  // init the command queue
+  cmdqueue = xQueueCreate (CMDQSIZ, sizeof(soundcmd_struct));
   
   
   // pin sound task to cpu 0
@@ -593,14 +1383,16 @@ void setup() {
     &Sound_Task,
     0);
 
-    // pin sound task to cpu 0
+  initSoundButtons();
+
+  // buttons and reading the sounds run on cpu 1 next to loop() but with a higher priority
   xTaskCreatePinnedToCore(
-    &stopTaskCode,
-    "stopTask",
-    1600,
+    &playerTaskCode,
+    "playerTask",
+    6144,
     NULL,
     2,
-    &Stop_Task,
+    &Player_Task,
     1);
 }
 
@@ -612,9 +1404,8 @@ void setup() {
 void loop() {
   
   vs1053player.setVolume(volume);
-  buttonLoop();
-  mp3loop();
   statusLed.callInloop();
+  statsLoop();
   startWifi();
   httpServer->httpServerLoop();
 }
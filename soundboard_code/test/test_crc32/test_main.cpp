@@ -0,0 +1,95 @@
+/**
+   Tests of the crc32 of the uploads against the values of zlib, the sync client compares them with
+   the crc32 of its local files.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "Crc32.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+static uint32_t crcOf(const char* text) {
+  return crc32Update(CRC32_INIT, (const uint8_t*) text, strlen(text));
+}
+
+static std::string readSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  std::string data;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return data;
+  }
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, len);
+  }
+  fclose(file);
+  return data;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_check_values() {
+  TEST_ASSERT_EQUAL_HEX32(0x00000000, crcOf(""));
+  TEST_ASSERT_EQUAL_HEX32(0xe8b7be43, crcOf("a"));
+  TEST_ASSERT_EQUAL_HEX32(0xcbf43926, crcOf("123456789"));
+  TEST_ASSERT_EQUAL_HEX32(0x414fa339, crcOf("The quick brown fox jumps over the lazy dog"));
+}
+
+void test_sample_files_like_zlib() {
+  std::string sound1 = readSample(1);
+  std::string sound3 = readSample(3);
+  TEST_ASSERT_EQUAL(28612, sound1.size());
+  TEST_ASSERT_EQUAL(243093, sound3.size());
+
+  // zlib.crc32() of the files
+  TEST_ASSERT_EQUAL_HEX32(0x42a79000, crc32Update(CRC32_INIT, (const uint8_t*) sound1.data(), sound1.size()));
+  TEST_ASSERT_EQUAL_HEX32(0x78368a7d, crc32Update(CRC32_INIT, (const uint8_t*) sound3.data(), sound3.size()));
+}
+
+void test_pieces_give_the_crc_of_the_whole() {
+  std::string sound = readSample(1);
+  const uint8_t* data = (const uint8_t*) sound.data();
+
+  // every block size the socket could hand to the upload, and empty blocks
+  size_t pieces[] = {1, 3, 1460, 4096, 5000};
+  for (size_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+    uint32_t crc = CRC32_INIT;
+    for (size_t pos = 0; pos < sound.size(); pos += pieces[i]) {
+      size_t len = pieces[i] < sound.size() - pos ? pieces[i] : sound.size() - pos;
+      crc = crc32Update(crc, data + pos, len);
+      crc = crc32Update(crc, data + pos, 0);
+    }
+    TEST_ASSERT_EQUAL_HEX32(0x42a79000, crc);
+  }
+}
+
+void test_one_changed_bit_changes_the_crc() {
+  std::string sound = readSample(2);
+  uint32_t crc = crc32Update(CRC32_INIT, (const uint8_t*) sound.data(), sound.size());
+
+  sound[sound.size() / 2] ^= 0x10;
+  TEST_ASSERT_TRUE(crc != crc32Update(CRC32_INIT, (const uint8_t*) sound.data(), sound.size()));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_check_values);
+  RUN_TEST(test_sample_files_like_zlib);
+  RUN_TEST(test_pieces_give_the_crc_of_the_whole);
+  RUN_TEST(test_one_changed_bit_changes_the_crc);
+  return UNITY_END();
+}
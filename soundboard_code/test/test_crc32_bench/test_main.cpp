@@ -0,0 +1,112 @@
+/**
+   Benchmark of the crc32 of the uploads on the host: the table of crc32Update() against the same
+   crc computed bit by bit, both over the largest sample in blocks of a tcp segment like uploadData()
+   gets them.  The figure of the esp32 is in the "hashUs" of the upload response.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "Crc32.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_ROUNDS 100
+#define BENCH_BLOCK 1460                         // What one tcp segment brings
+
+static std::string sample;
+
+static std::string readSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  std::string data;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return data;
+  }
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, len);
+  }
+  fclose(file);
+  return data;
+}
+
+// the crc without a table, eight shifts per byte
+static uint32_t crc32Bitwise(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// hashes the sample BENCH_ROUNDS times in blocks, returns MB/s and the crc
+static double measure(uint32_t (*update)(uint32_t, const uint8_t*, size_t), uint32_t* crc) {
+  const uint8_t* data = (const uint8_t*) sample.data();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    *crc = CRC32_INIT;
+    for (size_t pos = 0; pos < sample.size(); pos += BENCH_BLOCK) {
+      *crc = update(*crc, data + pos, BENCH_BLOCK < sample.size() - pos ? BENCH_BLOCK : sample.size() - pos);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return (double) sample.size() * BENCH_ROUNDS / seconds / 1e6;
+}
+
+static void report(const char* name, double mbs) {
+  char message[96];
+  snprintf(message, sizeof(message), "%s: %7.1f MB/s, %6.1f us for %u bytes", name, mbs,
+           sample.size() / mbs, (unsigned int) sample.size());
+  TEST_MESSAGE(message);
+}
+
+static double tableMbs;
+static double bitwiseMbs;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_table() {
+  uint32_t crc;
+  tableMbs = measure(crc32Update, &crc);
+  report("table     ", tableMbs);
+  TEST_ASSERT_EQUAL_HEX32(0x78368a7d, crc);
+}
+
+void test_bit_by_bit() {
+  uint32_t crc;
+  bitwiseMbs = measure(crc32Bitwise, &crc);
+  report("bit by bit", bitwiseMbs);
+  TEST_ASSERT_EQUAL_HEX32(0x78368a7d, crc);
+}
+
+void test_table_is_faster() {
+  char message[64];
+  snprintf(message, sizeof(message), "speedup: %.1fx", tableMbs / bitwiseMbs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(tableMbs > bitwiseMbs);
+}
+
+int main() {
+  sample = readSample(3);
+  UNITY_BEGIN();
+  RUN_TEST(test_table);
+  RUN_TEST(test_bit_by_bit);
+  RUN_TEST(test_table_is_faster);
+  return UNITY_END();
+}
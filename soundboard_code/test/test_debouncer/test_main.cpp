@@ -0,0 +1,231 @@
+/**
+   Replays edge traces through the button debouncer the way buttonLoop() feeds it: every edge from the
+   interrupt goes to edge(), and when a button is unsettled the player task wakes up at the end of the
+   debounce time and calls poll().
+   The traces are written like a logic analyser shows a bouncing switch, time in us and the level after
+   the edge, the buttons are active low.
+*/
+#include <unity.h>
+
+#include "ButtonDebouncer.h"
+
+#define TEST_DEBOUNCE_US 20000
+
+struct traceEdge_struct {
+  uint32_t timeUs;
+  uint8_t button;
+  bool level;
+};
+
+struct traceEvent_struct {
+  uint32_t timeUs;
+  uint8_t button;
+  buttonEvent_t event;
+};
+
+#define MAX_EVENTS 16
+
+static traceEvent_struct events[MAX_EVENTS];
+static size_t eventCount;
+
+void setUp() {
+  eventCount = 0;
+}
+
+void tearDown() {
+}
+
+static void record(uint32_t timeUs, uint8_t button, buttonEvent_t event) {
+  if (event != BUTTON_NONE && eventCount < MAX_EVENTS) {
+    events[eventCount].timeUs = timeUs;
+    events[eventCount].button = button;
+    events[eventCount].event = event;
+    eventCount++;
+  }
+}
+
+// polls the unsettled buttons whose debounce time ended before the given time, like the queue timeout does
+static void pollUntil(ButtonDebouncer &debouncer, uint32_t startUs, uint32_t untilUs, uint32_t* lastEdge) {
+  for (uint8_t button = 0; button < BUTTON_MAX; button++) {
+    if (!debouncer.unsettled(button)) {
+      continue;
+    }
+    // the deadline is at most one debounce time after the last edge of the button
+    uint32_t deadline = lastEdge[button] + TEST_DEBOUNCE_US;
+    if ((int32_t) (untilUs - deadline) >= 0 && (int32_t) (deadline - startUs) >= 0) {
+      record(deadline, button, debouncer.poll(button, deadline));
+    }
+  }
+}
+
+static void replay(ButtonDebouncer &debouncer, const traceEdge_struct* trace, size_t len) {
+  uint32_t lastEdge[BUTTON_MAX] = {0};
+  uint32_t startUs = trace[0].timeUs;
+
+  for (size_t i = 0; i < len; i++) {
+    pollUntil(debouncer, startUs, trace[i].timeUs, lastEdge);
+    record(trace[i].timeUs, trace[i].button, debouncer.edge(trace[i].button, trace[i].level, trace[i].timeUs));
+    lastEdge[trace[i].button] = trace[i].timeUs;
+  }
+  pollUntil(debouncer, startUs, trace[len - 1].timeUs + 2 * TEST_DEBOUNCE_US, lastEdge);
+}
+
+static void assertEvent(size_t index, uint32_t timeUs, uint8_t button, buttonEvent_t event) {
+  TEST_ASSERT_LESS_THAN(eventCount, index);
+  TEST_ASSERT_EQUAL(timeUs, events[index].timeUs);
+  TEST_ASSERT_EQUAL(button, events[index].button);
+  TEST_ASSERT_EQUAL(event, events[index].event);
+}
+
+#define REPLAY(debouncer, trace) replay(debouncer, trace, sizeof(trace) / sizeof(trace[0]))
+
+void test_clean_press_and_release() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  const traceEdge_struct trace[] = {
+    {100000, 0, false},
+    {300000, 0, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  TEST_ASSERT_EQUAL(2, eventCount);
+  assertEvent(0, 100000, 0, BUTTON_PRESSED);
+  assertEvent(1, 300000, 0, BUTTON_RELEASED);
+}
+
+void test_press_is_taken_at_the_first_edge() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  // a typical tact switch, bouncing for 1.5 ms
+  const traceEdge_struct trace[] = {
+    {100000, 0, false},
+    {100180, 0, true},
+    {100410, 0, false},
+    {100900, 0, true},
+    {101500, 0, false},
+    {250000, 0, true},
+    {250300, 0, false},
+    {250800, 0, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  // no waiting for the bouncing to end
+  TEST_ASSERT_EQUAL(2, eventCount);
+  assertEvent(0, 100000, 0, BUTTON_PRESSED);
+  assertEvent(1, 250000, 0, BUTTON_RELEASED);
+}
+
+void test_short_tap_is_released_after_the_debounce_time() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  // released before the debounce time is over, the last edge has no follower
+  const traceEdge_struct trace[] = {
+    {100000, 0, false},
+    {100200, 0, true},
+    {100500, 0, false},
+    {108000, 0, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  TEST_ASSERT_EQUAL(2, eventCount);
+  assertEvent(0, 100000, 0, BUTTON_PRESSED);
+  assertEvent(1, 128000, 0, BUTTON_RELEASED);
+  TEST_ASSERT_FALSE(debouncer.isPressed(0));
+}
+
+void test_bounce_back_to_the_stable_level_is_no_event() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  const traceEdge_struct trace[] = {
+    {100000, 0, false},
+    {100300, 0, true},
+    {100600, 0, false},
+  };
+
+  REPLAY(debouncer, trace);
+
+  TEST_ASSERT_EQUAL(1, eventCount);
+  assertEvent(0, 100000, 0, BUTTON_PRESSED);
+  TEST_ASSERT_TRUE(debouncer.isPressed(0));
+  TEST_ASSERT_FALSE(debouncer.unsettled(0));
+}
+
+void test_buttons_are_debounced_on_their_own() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  // two buttons pressed 1 ms apart, both bouncing
+  const traceEdge_struct trace[] = {
+    {100000, 3, false},
+    {100200, 3, true},
+    {101000, 7, false},
+    {101100, 3, false},
+    {101300, 7, true},
+    {101700, 7, false},
+    {400000, 7, true},
+    {401000, 3, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  TEST_ASSERT_EQUAL(4, eventCount);
+  assertEvent(0, 100000, 3, BUTTON_PRESSED);
+  assertEvent(1, 101000, 7, BUTTON_PRESSED);
+  assertEvent(2, 400000, 7, BUTTON_RELEASED);
+  assertEvent(3, 401000, 3, BUTTON_RELEASED);
+}
+
+void test_spike_while_held_is_filtered() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  // a spike on the line while the button is held a long time
+  const traceEdge_struct trace[] = {
+    {100000, 0, false},
+    {500000, 0, true},
+    {500004, 0, false},
+    {900000, 0, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  // the spike is taken as a release at once, its return to low comes within the debounce time
+  // and is taken by the poll as a new press
+  TEST_ASSERT_EQUAL(4, eventCount);
+  assertEvent(0, 100000, 0, BUTTON_PRESSED);
+  assertEvent(1, 500000, 0, BUTTON_RELEASED);
+  assertEvent(2, 520004, 0, BUTTON_PRESSED);
+  assertEvent(3, 900000, 0, BUTTON_RELEASED);
+}
+
+void test_micros_wrap() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  debouncer.init(0, true, 0xFFFF0000UL);
+  const traceEdge_struct trace[] = {
+    {0xFFFFF000UL, 0, false},
+    {0xFFFFF400UL, 0, true},
+    {0x00000200UL, 0, false},
+    {0x00100000UL, 0, true},
+  };
+
+  REPLAY(debouncer, trace);
+
+  TEST_ASSERT_EQUAL(2, eventCount);
+  assertEvent(0, 0xFFFFF000UL, 0, BUTTON_PRESSED);
+  assertEvent(1, 0x00100000UL, 0, BUTTON_RELEASED);
+}
+
+void test_first_edge_after_init_is_taken() {
+  ButtonDebouncer debouncer(TEST_DEBOUNCE_US);
+  debouncer.init(5, true, 1000);
+
+  TEST_ASSERT_EQUAL(BUTTON_PRESSED, debouncer.edge(5, false, 1000));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_press_and_release);
+  RUN_TEST(test_press_is_taken_at_the_first_edge);
+  RUN_TEST(test_short_tap_is_released_after_the_debounce_time);
+  RUN_TEST(test_bounce_back_to_the_stable_level_is_no_event);
+  RUN_TEST(test_buttons_are_debounced_on_their_own);
+  RUN_TEST(test_spike_while_held_is_filtered);
+  RUN_TEST(test_micros_wrap);
+  RUN_TEST(test_first_edge_after_init_is_taken);
+  return UNITY_END();
+}
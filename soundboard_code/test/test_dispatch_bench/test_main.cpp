@@ -0,0 +1,244 @@
+/**
+   Benchmark of the dispatch of a request: the old httpServerLoop() added every byte to a String and
+   compared each line with a dozen startsWith() prefixes, whatever state the parser was in, and cut the
+   parameter out with two String::replace() copies.  Now the request line is split into views and looked
+   up by its hash in the route table, header lines are split once at the colon.
+   Both read the same requests a byte at a time into a line, like the server does.  The String of the
+   native core is a std::string, so the old chain is written with std::string here.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "HttpRoutes.h"
+
+#define BENCH_ROUNDS 200000
+
+// what a browser sends for a trigger and for the info of the board
+static const char* requests[] = {
+  "GET /play/3 HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "Connection: keep-alive\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+  "Accept: */*\r\n"
+  "Referer: http://192.168.4.1/\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "Accept-Language: de-DE,de;q=0.9,en;q=0.8\r\n"
+  "\r\n",
+  "GET /info HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "Connection: keep-alive\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+  "Accept: application/json\r\n"
+  "If-None-Match: \"3a9f00c1\"\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "\r\n"
+};
+
+static bool startsWith(const std::string &line, const char* prefix) {
+  return line.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static void replace(std::string &line, const char* find, const char* with) {
+  size_t at;
+  while ((at = line.find(find)) != std::string::npos) {
+    line.replace(at, strlen(find), with);
+  }
+}
+
+// the line handling of the old httpServerLoop(), returns the action
+static httpClientAction_t oldDispatch(const char* request, std::string &dataToHandle) {
+  httpClientAction_t action = NONE;
+  std::string currentLine = "";
+  std::string uploadBoundary = "";
+
+  for (const char* c = request; *c != 0; c++) {
+    if (*c != '\n') {
+      if (*c != '\r') {
+        currentLine += *c;
+      }
+      continue;
+    }
+
+    if (startsWith(currentLine, "GET /play/") && action == NONE) {
+      dataToHandle = currentLine;
+      replace(dataToHandle, " HTTP/1.1", "");
+      replace(dataToHandle, "GET /play/", "");
+      action = PLAY;
+    }
+    if (startsWith(currentLine, "GET /download/") && action == NONE) {
+      dataToHandle = currentLine;
+      replace(dataToHandle, " HTTP/1.1", "");
+      replace(dataToHandle, "GET /download/", "");
+      action = DOWNLOAD;
+    }
+    if (startsWith(currentLine, "GET /delete/") && action == NONE) {
+      dataToHandle = currentLine;
+      replace(dataToHandle, " HTTP/1.1", "");
+      replace(dataToHandle, "GET /delete/", "");
+      action = DELETE;
+    }
+    if (startsWith(currentLine, "GET /info") && action == NONE) {
+      action = INFO;
+    }
+    if (startsWith(currentLine, "GET /restart") && action == NONE) {
+      action = RESTART;
+    }
+    if (startsWith(currentLine, "POST /upload") && action == NONE) {
+      action = UPLOAD_INIT;
+    }
+    if (startsWith(currentLine, "content-type: multipart/form-data; boundary=") && action == UPLOAD_INIT) {
+      uploadBoundary = "--" + currentLine.substr(44);
+      action = UPLOAD_BOUNDARY_INIT;
+    }
+    if (startsWith(currentLine, uploadBoundary.c_str()) && action == UPLOAD_BOUNDARY_INIT) {
+      action = UPLOAD_DATA_START;
+    }
+    if (startsWith(currentLine, "Content-Disposition: form-data; name=\"file\"; filename=") && action == UPLOAD_DATA_START) {
+      dataToHandle = currentLine.substr(55, currentLine.length() - 56);
+    }
+    if ((startsWith(currentLine, "GET") || startsWith(currentLine, "POST")) && action == NONE) {
+      dataToHandle = "Not Found";
+      action = FAILURE;
+    }
+    currentLine = "";
+  }
+  return action;
+}
+
+// the line handling of httpParseLine() with the route table, returns the action
+static httpClientAction_t newDispatch(const char* request, char* dataToHandle, size_t size, bool &keepAlive) {
+  httpClientAction_t action = NONE;
+  char line[256];
+  size_t lineLen = 0;
+  keepAlive = false;
+
+  for (const char* c = request; *c != 0; c++) {
+    if (*c != '\n') {
+      if (*c != '\r' && lineLen < sizeof(line)) {
+        line[lineLen++] = *c;
+      }
+      continue;
+    }
+
+    if (action == NONE && lineLen > 0) {
+      httpRequestLine_struct requestLine;
+      const httpRoute_struct* route;
+      if (!httpParseRequestLine(line, lineLen, requestLine) || (route = httpFindRoute(requestLine)) == NULL) {
+        action = FAILURE;
+      } else {
+        action = route->action;
+        keepAlive = requestLine.http11;
+        if (route->param && requestLine.param.len < size) {
+          memcpy(dataToHandle, requestLine.param.data, requestLine.param.len);
+          dataToHandle[requestLine.param.len] = 0;
+        }
+      }
+    } else if (lineLen > 0) {
+      httpView_struct value;
+      if (httpParseHeader(line, lineLen, value) == HEADER_CONNECTION && httpViewContains(value, "close")) {
+        keepAlive = false;
+      }
+    }
+    lineLen = 0;
+  }
+  return action;
+}
+
+static double oldNs;
+static double newNs;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_both_find_the_same_action() {
+  std::string oldData;
+  char newData[65] = {0};
+
+  TEST_ASSERT_EQUAL(PLAY, oldDispatch(requests[0], oldData));
+  bool keepAlive;
+  TEST_ASSERT_EQUAL(PLAY, newDispatch(requests[0], newData, sizeof(newData), keepAlive));
+  TEST_ASSERT_TRUE(keepAlive);
+  TEST_ASSERT_EQUAL_STRING("3", oldData.c_str());
+  TEST_ASSERT_EQUAL_STRING("3", newData);
+  TEST_ASSERT_EQUAL(INFO, oldDispatch(requests[1], oldData));
+  TEST_ASSERT_EQUAL(INFO, newDispatch(requests[1], newData, sizeof(newData), keepAlive));
+}
+
+void test_old_startswith_chain() {
+  std::string data;
+  uint32_t check = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    check += oldDispatch(requests[i & 1], data);
+  }
+  oldNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_ROUNDS;
+
+  char message[64];
+  snprintf(message, sizeof(message), "startsWith chain: %6.0f ns per request", oldNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL((PLAY + INFO) * (BENCH_ROUNDS / 2), check);
+}
+
+void test_route_table() {
+  char data[65];
+  bool keepAlive;
+  uint32_t check = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    check += newDispatch(requests[i & 1], data, sizeof(data), keepAlive);
+  }
+  newNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_ROUNDS;
+
+  char message[64];
+  snprintf(message, sizeof(message), "route table:      %6.0f ns per request", newNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL((PLAY + INFO) * (BENCH_ROUNDS / 2), check);
+}
+
+void test_lookup_only() {
+  const char* lines[] = {"GET /play/3 HTTP/1.1", "GET /info HTTP/1.1", "POST /upload HTTP/1.1", "GET /favicon.ico HTTP/1.1"};
+  size_t lens[4];
+  for (int i = 0; i < 4; i++) {
+    lens[i] = strlen(lines[i]);
+  }
+  uint32_t found = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ROUNDS * 4; i++) {
+    httpRequestLine_struct request;
+    if (httpParseRequestLine(lines[i & 3], lens[i & 3], request) && httpFindRoute(request) != NULL) {
+      found++;
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (BENCH_ROUNDS * 4);
+
+  char message[80];
+  snprintf(message, sizeof(message), "request line split and lookup: %4.0f ns", ns);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL(BENCH_ROUNDS * 3, found);
+}
+
+void test_route_table_is_faster() {
+  char message[64];
+  snprintf(message, sizeof(message), "speedup: %.1fx", oldNs / newNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(newNs < oldNs);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_both_find_the_same_action);
+  RUN_TEST(test_old_startswith_chain);
+  RUN_TEST(test_route_table);
+  RUN_TEST(test_lookup_only);
+  RUN_TEST(test_route_table_is_faster);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+/**
+   Benchmark of the downloads: the old httpDownloadMp3() wrote the file to the client a byte at a time
+   with file.read() and client.write(uint8_t), the server now reads HTTP_FILE_BLOCK bytes from the flash
+   and writes what the socket takes, a block per loop.
+   The old loop runs here on the same File and WiFiClient stand-ins as the firmware, only its
+   Content-Length line is fixed.  The new one is the firmware itself with wifi on, asked for /download/3.
+   Both are timed by a client on the loopback from connecting to the end of the data, the median of
+   BENCH_RUNS downloads is reported.  Every byte is a syscall on the host and a pbuf on the esp, the
+   numbers are only good for comparing the two paths.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "SPIFFS.h"
+#include "WiFiClient.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_PORT_OFFSET 22000                  // The firmware listens on 22080
+#define BENCH_RUNS 15
+#define BENCH_SOUND 3                            // The largest sample, 243 kB
+
+// the wifi switch of the firmware in main.cpp
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/downloadXXXXXX";
+static std::string sample;
+
+static std::string readSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  std::string data;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return data;
+  }
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, len);
+  }
+  fclose(file);
+  return data;
+}
+
+static int connectTo(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// sends the request and reads to the end of the connection, returns the us it took and the body
+static uint32_t download(uint16_t port, const char* request, std::string* body) {
+  std::string response;
+  uint32_t start = micros();
+
+  int fd = connectTo(port);
+  if (fd < 0) {
+    return 0;
+  }
+  send(fd, request, strlen(request), MSG_NOSIGNAL);
+  char buffer[16384];
+  ssize_t len;
+  while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, len);
+  }
+  close(fd);
+  uint32_t us = micros() - start;
+
+  size_t headerEnd = response.find("\r\n\r\n");
+  *body = headerEnd == std::string::npos ? std::string() : response.substr(headerEnd + 4);
+  return us;
+}
+
+// the download of the firmware before the block sending, with a working Content-Length
+static void oldDownloadMp3(WiFiClient client, String fileToDownload) {
+  String path = "/" + fileToDownload + ".mp3";
+  File file = SPIFFS.open(path, FILE_READ);
+
+  client.println("HTTP/1.1 200 OK");
+  client.println("Content-type: audio/mp3");
+  client.println("Content-Length: " + String((unsigned int) file.size()));
+  client.println();
+
+  while (file.available()) {
+    client.write(file.read());
+  }
+
+  client.println();
+
+  file.close();
+}
+
+// a listening socket on a free port of the loopback, serves one download per connection the old way
+static int oldServer(uint16_t* port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || bind(fd, (struct sockaddr*) &addr, len) != 0 || listen(fd, 1) != 0 ||
+      getsockname(fd, (struct sockaddr*) &addr, &len) != 0) {
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+static uint32_t median(uint32_t* values, size_t count) {
+  std::sort(values, values + count);
+  return values[count / 2];
+}
+
+static void report(const char* name, uint32_t us) {
+  char message[128];
+  snprintf(message, sizeof(message), "%s: %6u us for %u bytes, %5u KB/s", name, us, (unsigned int) sample.size(),
+           (unsigned int) ((uint64_t) sample.size() * 1000000 / 1024 / (us > 0 ? us : 1)));
+  TEST_MESSAGE(message);
+}
+
+static uint32_t oldUs;
+static uint32_t newUs;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_old_byte_by_byte_download() {
+  uint16_t port = 0;
+  int listenFd = oldServer(&port);
+  TEST_ASSERT_TRUE(listenFd >= 0);
+
+  std::thread server([listenFd]() {
+    for (int i = 0; i < BENCH_RUNS; i++) {
+      int fd = accept(listenFd, NULL, NULL);
+      // the request is read but not parsed, a close with unread data would reset the connection
+      char request[256];
+      recv(fd, request, sizeof(request), 0);
+      oldDownloadMp3(WiFiClient(fd), String(BENCH_SOUND));
+    }
+  });
+
+  uint32_t runs[BENCH_RUNS];
+  std::string body;
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    runs[i] = download(port, "GET /download/3 HTTP/1.1\r\n\r\n", &body);
+    // the old println after the data is two bytes more than the Content-Length
+    TEST_ASSERT_EQUAL(sample.size() + 2, body.size());
+    TEST_ASSERT_TRUE(body.compare(0, sample.size(), sample) == 0);
+  }
+  server.join();
+  close(listenFd);
+
+  oldUs = median(runs, BENCH_RUNS);
+  report("byte by byte", oldUs);
+}
+
+void test_block_download() {
+  uint16_t port = 80 + BENCH_PORT_OFFSET;
+  std::string body;
+
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  while (download(port, "GET /info HTTP/1.1\r\nConnection: close\r\n\r\n", &body) == 0 && millis() - start < 5000) {
+    delay(50);
+  }
+
+  uint32_t runs[BENCH_RUNS];
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    runs[i] = download(port, "GET /download/3 HTTP/1.1\r\nConnection: close\r\n\r\n", &body);
+    TEST_ASSERT_EQUAL(sample.size(), body.size());
+    TEST_ASSERT_TRUE(body == sample);
+  }
+
+  newUs = median(runs, BENCH_RUNS);
+  report("block       ", newUs);
+}
+
+void test_blocks_are_faster() {
+  char message[64];
+  snprintf(message, sizeof(message), "speedup: %.1fx", (double) oldUs / (newUs > 0 ? newUs : 1));
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(oldUs, newUs);
+}
+
+int main() {
+  sample = readSample(BENCH_SOUND);
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  char path[64];
+  snprintf(path, sizeof(path), "%s/%d.mp3", dataDir, BENCH_SOUND);
+  FILE* out = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(out);
+  fwrite(sample.data(), 1, sample.size(), out);
+  fclose(out);
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(BENCH_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_old_byte_by_byte_download);
+  RUN_TEST(test_block_download);
+  RUN_TEST(test_blocks_are_faster);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
@@ -0,0 +1,258 @@
+/**
+   Tests of the status events of /events with the firmware running on the host with wifi on:
+   the changes within EVENTS_MIN_INTERVAL_MS go out as one push, a client which stops reading is
+   closed, and no more than EVENTS_MAX_CLIENTS clients listen at the same time.
+*/
+#include <unity.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "PlayerControl.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define EVENTS_PORT_OFFSET 25000                 // The server listens on 25080
+#define EVENTS_SEND_BUFFER 1                     // The smallest the host takes, small like the one of lwip
+#define EVENTS_STALL_MS 30000                    // How long a client which stops reading may stay
+
+// the player and the wifi switch of the firmware in main.cpp
+extern std::atomic<int> playingSound;
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/eventsXXXXXX";
+static uint16_t httpPort = 80 + EVENTS_PORT_OFFSET;
+static int listener = -1;                        // Reads all events
+static int stalled = -1;                         // Stops reading after the header
+
+static int httpConnect(int receiveBuffer = 0) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (receiveBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(httpPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  // a lost answer fails the test instead of hanging it
+  struct timeval timeout = {0, 100000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// reads until the text arrived or ms passed, false when the connection ended first
+static bool readUntil(int fd, std::string &received, const char* text, uint32_t ms) {
+  char buffer[1024];
+  uint32_t start = millis();
+
+  while (received.find(text) == std::string::npos) {
+    if (millis() - start > ms) {
+      return true;
+    }
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      return false;
+    }
+    if (len > 0) {
+      received.append(buffer, len);
+    }
+  }
+  return true;
+}
+
+// opens /events, returns the status code, the connection stays in fd
+static int openEvents(int &fd, std::string &received, int receiveBuffer = 0) {
+  fd = httpConnect(receiveBuffer);
+  if (fd < 0) {
+    return -1;
+  }
+  const char* request = "GET /events HTTP/1.1\r\n\r\n";
+  if (!sendAll(fd, request, strlen(request))) {
+    return -1;
+  }
+  readUntil(fd, received, "\r\n\r\n", 2000);
+  return received.size() > 12 ? atoi(received.c_str() + 9) : -1;
+}
+
+static int countOf(const std::string &text, const char* what) {
+  int count = 0;
+  for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+// spins until the player runs the sound, false after a second
+static bool waitPlaying(int sound) {
+  uint32_t start = millis();
+  while (playingSound != sound) {
+    if (millis() - start > 1000) {
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_server_answers() {
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  int fd;
+  while ((fd = httpConnect()) < 0 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+}
+
+void test_first_push_has_the_whole_status() {
+  std::string received;
+  TEST_ASSERT_EQUAL(200, openEvents(listener, received));
+  TEST_ASSERT_TRUE(received.find("text/event-stream") != std::string::npos);
+
+  TEST_ASSERT_TRUE(readUntil(listener, received, "event: levels", 2000));
+  TEST_ASSERT_EQUAL(1, countOf(received, "event: sound"));
+  TEST_ASSERT_EQUAL(1, countOf(received, "event: files"));
+  TEST_ASSERT_EQUAL(1, countOf(received, "event: levels"));
+}
+
+void test_burst_of_changes_is_one_push() {
+  // the push of the first sound starts a new interval
+  std::string received;
+  TEST_ASSERT_TRUE(playerPlay(1, 0, micros()));
+  TEST_ASSERT_TRUE(readUntil(listener, received, "\"sound\" : 1", 2000));
+  TEST_ASSERT_EQUAL(1, countOf(received, "event: sound"));
+
+  // three changes well within the interval, the last sound plays for seconds
+  uint32_t start = millis();
+  TEST_ASSERT_TRUE(playerPlay(2, 0, micros()));
+  TEST_ASSERT_TRUE(waitPlaying(2));
+  TEST_ASSERT_TRUE(playerPlay(1, 0, micros()));
+  TEST_ASSERT_TRUE(waitPlaying(1));
+  TEST_ASSERT_TRUE(playerPlay(3, 0, micros()));
+  TEST_ASSERT_TRUE(waitPlaying(3));
+  TEST_ASSERT_LESS_THAN(EVENTS_MIN_INTERVAL_MS / 2, millis() - start);
+
+  received.clear();
+  readUntil(listener, received, "never sent", 3 * EVENTS_MIN_INTERVAL_MS);
+  TEST_ASSERT_EQUAL(1, countOf(received, "event: sound"));
+  TEST_ASSERT_TRUE(received.find("\"sound\" : 3") != std::string::npos);
+  TEST_ASSERT_TRUE(playerStop(micros()));
+}
+
+void test_third_client_is_refused() {
+  std::string received;
+  TEST_ASSERT_EQUAL(200, openEvents(stalled, received, 1));
+
+  int refused;
+  received.clear();
+  TEST_ASSERT_EQUAL(404, openEvents(refused, received));
+  close(refused);
+}
+
+void test_client_which_stops_reading_is_closed() {
+  // the stalled client takes no more pushes, the changes fill its socket until the server gives up
+  // a new client is only taken once it is gone
+  uint32_t start = millis();
+  uint32_t lastProbe = start;
+  int sound = 1;
+  bool taken = false;
+  while (!taken && millis() - start < EVENTS_STALL_MS) {
+    TEST_ASSERT_TRUE(playerPlay(sound, 0, micros()));
+    sound = 3 - sound;
+    delay(EVENTS_MIN_INTERVAL_MS);
+
+    if (millis() - lastProbe >= 1000) {
+      lastProbe = millis();
+      int probe;
+      std::string received;
+      taken = openEvents(probe, received) == 200;
+      close(probe);
+    }
+  }
+  TEST_ASSERT_TRUE(playerStop(micros()));
+  char message[64];
+  snprintf(message, sizeof(message), "closed after %u ms", (unsigned) (millis() - start));
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(taken);
+
+  // what was in the socket is still there, then the connection ends
+  std::string received;
+  TEST_ASSERT_FALSE(readUntil(stalled, received, "never sent", 5000));
+  close(stalled);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 3; n++) {
+    char command[128];
+    snprintf(command, sizeof(command), "cp " SAMPLEDATA_DIR "%d.mp3 %s/", n, dataDir);
+    TEST_ASSERT_EQUAL(0, system(command));
+  }
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(EVENTS_PORT_OFFSET);
+  nativeSetSendBuffer(EVENTS_SEND_BUFFER);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_server_answers);
+  RUN_TEST(test_first_push_has_the_whole_status);
+  RUN_TEST(test_burst_of_changes_is_one_push);
+  RUN_TEST(test_third_client_is_refused);
+  RUN_TEST(test_client_which_stops_reading_is_closed);
+  int failures = UNITY_END();
+
+  close(listener);
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
@@ -0,0 +1,264 @@
+/**
+   Benchmark of the status events of /events against polling /info once a second, on the loopback
+   with the firmware running on the host with wifi on.
+   The three clients run at the same time while a sound is triggered every 2 s: polling with a new
+   connection each time, polling on a kept open connection with If-None-Match, and listening to
+   /events.  Counted are the requests the board parses and the bytes each way.
+*/
+#include <unity.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "PlayerControl.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_PORT_OFFSET 26000                  // The server listens on 26080
+#define BENCH_MS 10000                           // How long the clients run
+#define POLL_INTERVAL_MS 1000                    // How often the pollers ask for /info
+#define TRIGGER_INTERVAL_MS 2000                 // How often a sound is started
+
+// the wifi switch of the firmware in main.cpp
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/eventsbenchXXXXXX";
+static uint16_t httpPort = 80 + BENCH_PORT_OFFSET;
+
+// what one client cost
+struct clientResult_struct {
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t bytesUp;
+  uint32_t bytesDown;
+};
+
+static int httpConnect() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(httpPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  // a lost answer fails the test instead of hanging it
+  struct timeval timeout = {0, 100000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+static bool sendAll(int fd, const std::string &data, clientResult_struct &result) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    ssize_t sent = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    pos += sent;
+  }
+  result.requests++;
+  result.bytesUp += data.size();
+  return true;
+}
+
+// the value of a header, empty when it is missing
+static std::string headerOf(const std::string &response, const char* name) {
+  size_t pos = response.find(name);
+  if (pos == std::string::npos) {
+    return "";
+  }
+  pos += strlen(name);
+  return response.substr(pos, response.find("\r\n", pos) - pos);
+}
+
+// reads one response up to the end of its Content-Length, returns the status code and its header
+static int readResponse(int fd, std::string &received, std::string &header, clientResult_struct &result) {
+  char buffer[1024];
+  size_t headerEnd;
+  size_t want = 0;
+  uint32_t start = millis();
+
+  // a 304 has no body and no Content-Length
+  while ((headerEnd = received.find("\r\n\r\n")) == std::string::npos ||
+         received.size() < (want = headerEnd + 4 + atoi(headerOf(received.substr(0, headerEnd), "Content-Length: ").c_str()))) {
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) || millis() - start > 2000) {
+      return -1;
+    }
+    if (len > 0) {
+      received.append(buffer, len);
+      result.bytesDown += len;
+    }
+  }
+  int status = atoi(received.c_str() + 9);
+  header = received.substr(0, headerEnd);
+  received.erase(0, want);
+  return status;
+}
+
+static void pollClient(bool keepAlive, uint32_t until, clientResult_struct* result) {
+  int fd = -1;
+  std::string received;
+  std::string etag;
+
+  while (millis() < until) {
+    if (fd < 0) {
+      fd = httpConnect();
+      received.clear();
+    }
+    std::string request = "GET /info HTTP/1.1\r\n";
+    if (keepAlive && etag != "") {
+      request += "If-None-Match: " + etag + "\r\n";
+    }
+    request += keepAlive ? "\r\n" : "Connection: close\r\n\r\n";
+
+    std::string header;
+    int status = fd >= 0 && sendAll(fd, request, *result) ? readResponse(fd, received, header, *result) : -1;
+    if (status == 200) {
+      etag = headerOf(header, "ETag: ");
+    } else if (status != 304) {
+      result->failures++;
+    }
+    if (!keepAlive || status < 0) {
+      close(fd);
+      fd = -1;
+    }
+    delay(POLL_INTERVAL_MS);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+static void eventsClient(uint32_t until, clientResult_struct* result, uint32_t* pushes) {
+  int fd = httpConnect();
+  if (fd < 0 || !sendAll(fd, "GET /events HTTP/1.1\r\n\r\n", *result)) {
+    result->failures++;
+    return;
+  }
+
+  // every push is a single write, so what one read gets is one push
+  char buffer[1024];
+  while (millis() < until) {
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len > 0) {
+      result->bytesDown += len;
+      (*pushes)++;
+    } else if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+      result->failures++;
+      break;
+    }
+  }
+  close(fd);
+}
+
+static void report(const char* name, const clientResult_struct &result) {
+  char message[128];
+  snprintf(message, sizeof(message), "%s: %3u requests, %u failed, %6u B up, %6u B down", name, result.requests,
+           result.failures, result.bytesUp, result.bytesDown);
+  TEST_MESSAGE(message);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_server_answers() {
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  int fd;
+  while ((fd = httpConnect()) < 0 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+}
+
+void test_events_against_polling() {
+  clientResult_struct pollNew = {0, 0, 0, 0};
+  clientResult_struct pollKeepAlive = {0, 0, 0, 0};
+  clientResult_struct events = {0, 0, 0, 0};
+  uint32_t pushes = 0;
+
+  uint32_t until = millis() + BENCH_MS;
+  std::thread pollers[] = {
+    std::thread(pollClient, false, until, &pollNew),
+    std::thread(pollClient, true, until, &pollKeepAlive),
+    std::thread(eventsClient, until, &events, &pushes),
+  };
+  int sound = 1;
+  while (millis() < until) {
+    TEST_ASSERT_TRUE(playerPlay(sound, 0, micros()));
+    sound = 3 - sound;
+    delay(TRIGGER_INTERVAL_MS);
+  }
+  for (std::thread &poller : pollers) {
+    poller.join();
+  }
+  TEST_ASSERT_TRUE(playerStop(micros()));
+
+  report("polling, new connection ", pollNew);
+  report("polling, keep-alive     ", pollKeepAlive);
+  report("events                  ", events);
+  char message[96];
+  snprintf(message, sizeof(message), "%u pushes in %u s", pushes, BENCH_MS / 1000);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_EQUAL(0, pollNew.failures + pollKeepAlive.failures + events.failures);
+  // one request for the whole time, the pushes of the changes cost less than the answers to the polls
+  TEST_ASSERT_EQUAL(1, events.requests);
+  TEST_ASSERT_GREATER_THAN(events.requests, pollKeepAlive.requests);
+  TEST_ASSERT_LESS_THAN(pollNew.bytesDown, events.bytesDown);
+  TEST_ASSERT_LESS_THAN(pollKeepAlive.bytesUp, events.bytesUp);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 2; n++) {
+    char command[128];
+    snprintf(command, sizeof(command), "cp " SAMPLEDATA_DIR "%d.mp3 %s/", n, dataDir);
+    TEST_ASSERT_EQUAL(0, system(command));
+  }
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(BENCH_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_server_answers);
+  RUN_TEST(test_events_against_polling);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
@@ -0,0 +1,125 @@
+/**
+   Benchmark of the mp3 feed: the old path read 60 bytes from the file and called handlebyte() for each
+   of them, which queued a 32 byte chunk with xQueueSend() every 32 bytes.  mp3loop() now copies each
+   read of BUFFER_SIZE bytes into the ring buffer in one go.
+   Both paths run in one thread, the consumer drains after each read, so only the cost of the feed
+   itself is measured.  The host queue is a mutex and a condition variable, the numbers are only
+   good for comparing the two paths.
+*/
+#include <unity.h>
+#include <chrono>
+
+#include "Arduino.h"
+#include "Configuration.h"
+#include "RingBuffer.h"
+
+#define OLD_READ_SIZE 60                         // BUFFER_SIZE before the block feed
+#define BENCH_FILE_SIZE (15 * 1024)              // A multiple of both read sizes
+#define BENCH_BYTES (1024UL * BENCH_FILE_SIZE)   // Bytes fed through each path
+#define OLD_QUEUE_SIZE 400                       // Items in the old data queue
+
+struct benchChunk_struct {
+  int datatyp;
+  uint8_t buf[32];
+};
+
+static uint8_t fileData[BENCH_FILE_SIZE];
+static uint8_t ringStorage[RINGBUF_SIZE];
+
+static QueueHandle_t queue;
+static benchChunk_struct outchunk;
+static uint8_t* outqp = outchunk.buf;
+static uint32_t checksum;
+
+void setUp() {
+  for (size_t i = 0; i < sizeof(fileData); i++) {
+    fileData[i] = (uint8_t) (i * 7);
+  }
+  checksum = 0;
+}
+
+void tearDown() {
+}
+
+// stands in for the sdi transfer, touches every byte the consumer gets
+static uint32_t sum(const uint8_t* data, size_t len) {
+  uint32_t result = 0;
+  for (size_t i = 0; i < len; i++) {
+    result += data[i];
+  }
+  return result;
+}
+
+// the old per byte path of main.cpp
+static void handlebyte(uint8_t b) {
+  *outqp++ = b;
+  if (outqp == outchunk.buf + sizeof(outchunk.buf)) {
+    xQueueSend(queue, &outchunk, 200);
+    outqp = outchunk.buf;
+  }
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double benchPerByte() {
+  queue = xQueueCreate(OLD_QUEUE_SIZE, sizeof(benchChunk_struct));
+  benchChunk_struct inchunk;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t fed = 0; fed < BENCH_BYTES; fed += OLD_READ_SIZE) {
+    const uint8_t* read = fileData + fed % BENCH_FILE_SIZE;
+    for (int i = 0; i < OLD_READ_SIZE; i++) {
+      handlebyte(read[i]);
+    }
+    // a receive on an empty host queue waits in the kernel, the sound task would sleep there too
+    while (uxQueueMessagesWaiting(queue) > 0) {
+      xQueueReceive(queue, &inchunk, 0);
+      checksum += sum(inchunk.buf, sizeof(inchunk.buf));
+    }
+  }
+  double seconds = secondsSince(start);
+
+  vQueueDelete(queue);
+  return BENCH_BYTES / seconds;
+}
+
+static double benchBlock() {
+  RingBuffer ring(ringStorage, sizeof(ringStorage));
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t fed = 0; fed < BENCH_BYTES; fed += BUFFER_SIZE) {
+    ring.write(fileData + fed % BENCH_FILE_SIZE, BUFFER_SIZE);
+    uint8_t* data;
+    size_t len;
+    while ((len = ring.peek(&data)) > 0) {
+      checksum += sum(data, len);
+      ring.consume(len);
+    }
+  }
+  double seconds = secondsSince(start);
+
+  return BENCH_BYTES / seconds;
+}
+
+void test_block_feed_is_faster() {
+  double perByte = benchPerByte();
+  uint32_t expected = checksum;
+  checksum = 0;
+  double block = benchBlock();
+
+  char line[120];
+  snprintf(line, sizeof(line), "per byte + queue: %.1f MB/s, block + ring buffer: %.1f MB/s, %.1fx",
+           perByte / 1e6, block / 1e6, block / perByte);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(block > perByte);
+  // both paths delivered the same bytes
+  TEST_ASSERT_EQUAL_UINT32(expected, checksum);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_block_feed_is_faster);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+/**
+   Tests of the start of the file catalogue with the files a restart leaves in the middle of an upload:
+   an upload whose sound is missing is put in place, one next to its sound is removed.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "StreamString.h"
+#include "FileCatalogue.h"
+
+static char dataDir[] = "/tmp/catalogueXXXXXX";
+static FileCatalogue catalogue;
+
+static std::string hostPath(const char* name) {
+  return std::string(dataDir) + "/" + name;
+}
+
+static void writeFile(const char* name, const std::string &data) {
+  FILE* file = fopen(hostPath(name).c_str(), "wb");
+  TEST_ASSERT_NOT_NULL(file);
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+}
+
+// the content of the file, "missing" when there is none
+static std::string readFile(const char* name) {
+  FILE* file = fopen(hostPath(name).c_str(), "rb");
+  if (file == NULL) {
+    return "missing";
+  }
+  std::string data;
+  char buffer[256];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, len);
+  }
+  fclose(file);
+  return data;
+}
+
+void setUp() {
+  char command[64];
+  snprintf(command, sizeof(command), "rm -f %s/*", dataDir);
+  system(command);
+}
+
+void tearDown() {
+}
+
+void test_upload_without_its_sound_is_put_in_place() {
+  // the old sound was removed, the restart came before the rename
+  writeFile(UPLOAD_TEMP_PREFIX "1.mp3", "new sound");
+  writeFile(UPLOAD_TEMP_PREFIX "1.idx", "new index");
+  writeFile("1.idx", "old index");
+
+  catalogue.begin();
+
+  TEST_ASSERT_TRUE(readFile("1.mp3") == "new sound");
+  TEST_ASSERT_TRUE(readFile("1.idx") == "new index");
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "1.mp3") == "missing");
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "1.idx") == "missing");
+  TEST_ASSERT_TRUE(catalogue.contains("/1.mp3"));
+}
+
+void test_index_follows_its_renamed_sound() {
+  writeFile("2.mp3", "new sound");
+  writeFile("2.idx", "old index");
+  writeFile(UPLOAD_TEMP_PREFIX "2.idx", "new index");
+
+  catalogue.begin();
+
+  TEST_ASSERT_TRUE(readFile("2.idx") == "new index");
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "2.idx") == "missing");
+}
+
+void test_upload_next_to_its_sound_is_removed() {
+  writeFile("3.mp3", "old sound");
+  writeFile("3.idx", "old index");
+  writeFile(UPLOAD_TEMP_PREFIX "3.mp3", "half a ");
+  writeFile(UPLOAD_TEMP_PREFIX "3.idx", "new index");
+
+  catalogue.begin();
+
+  TEST_ASSERT_TRUE(readFile("3.mp3") == "old sound");
+  TEST_ASSERT_TRUE(readFile("3.idx") == "old index");
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "3.mp3") == "missing");
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "3.idx") == "missing");
+  TEST_ASSERT_FALSE(catalogue.contains(UPLOAD_TEMP_PREFIX "3.mp3"));
+}
+
+void test_new_sound_is_kept() {
+  // a sound which was not there before, its index was not written yet
+  writeFile(UPLOAD_TEMP_PREFIX "4.mp3", "new sound");
+  writeFile(UPLOAD_TEMP_PREFIX "5.wav", "RIFF");
+
+  catalogue.begin();
+
+  TEST_ASSERT_TRUE(readFile("4.mp3") == "new sound");
+  TEST_ASSERT_TRUE(readFile("4.idx") == "missing");
+  TEST_ASSERT_TRUE(readFile("5.wav") == "RIFF");
+  TEST_ASSERT_TRUE(catalogue.contains("/4.mp3"));
+  TEST_ASSERT_TRUE(catalogue.contains("/5.wav"));
+}
+
+void test_index_without_a_sound_is_removed() {
+  writeFile(UPLOAD_TEMP_PREFIX "6.idx", "new index");
+
+  catalogue.begin();
+
+  TEST_ASSERT_TRUE(readFile(UPLOAD_TEMP_PREFIX "6.idx") == "missing");
+  TEST_ASSERT_TRUE(readFile("6.idx") == "missing");
+}
+
+void test_hashes_are_kept_with_the_size_of_the_upload() {
+  writeFile("7.mp3", "stored");
+  writeFile("8.mp3", "changed since");
+  writeFile("hashes.lst", "0000abcd 6 9 /7.mp3\n00001234 6 9 /8.mp3\n");
+
+  catalogue.begin();
+  StreamString manifest;
+  catalogue.printManifest(manifest);
+  std::string list = manifest.c_str();
+
+  TEST_ASSERT_TRUE(list.find("\"/7.mp3\", \"size\" : 6, \"uploadSize\" : 9, \"hash\" : \"0000abcd\"") != std::string::npos);
+  // the file has another size than when its hash was taken
+  TEST_ASSERT_TRUE(list.find("\"/8.mp3\", \"size\" : 13, \"uploadSize\" : null, \"hash\" : null") != std::string::npos);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  nativeSetDataDir(dataDir);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_upload_without_its_sound_is_put_in_place);
+  RUN_TEST(test_index_follows_its_renamed_sound);
+  RUN_TEST(test_upload_next_to_its_sound_is_removed);
+  RUN_TEST(test_new_sound_is_kept);
+  RUN_TEST(test_index_without_a_sound_is_removed);
+  RUN_TEST(test_hashes_are_kept_with_the_size_of_the_upload);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
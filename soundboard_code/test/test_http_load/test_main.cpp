@@ -0,0 +1,579 @@
+/**
+   Runs the firmware on the host with wifi on and puts load on the http server while a long sound
+   plays: two clients upload files and two download them, all at the same time, like four phones
+   on the soundboard. The http server shares loop() with the wifi handling, the sound task has to
+   keep the simulated vs1053 fed anyway, any underrun is a gap in the sound.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "HeapStats.h"
+#include "PlayerControl.h"
+#include "Vs1053Sim.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define LOAD_PORT_OFFSET 21000                   // The server listens on 21080
+#define LOAD_MS 4000                             // How long the clients keep going
+#define LOAD_SOUND 3                             // Plays for 15 s
+#define SHORT_SOUND 10                           // A button sound which fits its cached head, it plays without the file
+#define HEAP_ROUNDS 20                           // Rounds of requests which must not take the heap, below HTTP_KEEPALIVE_MAX
+
+// the player and the wifi switch of the firmware in main.cpp
+extern Vs1053Sim vs1053player;
+extern std::atomic<int> playingSound;
+extern bool turnWifiOn;
+extern uint8_t* streambufdata;
+
+static char dataDir[] = "/tmp/httploadXXXXXX";
+
+static std::string readSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  std::string data;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return data;
+  }
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.append(buffer, len);
+  }
+  fclose(file);
+  return data;
+}
+
+// copies a sample as sound number as, cut to size bytes
+static void copySample(int n, int as, size_t size = std::string::npos) {
+  std::string data = readSample(n).substr(0, size);
+  TEST_ASSERT_TRUE(data.size() > 0);
+
+  char to[64];
+  snprintf(to, sizeof(to), "%s/%d.mp3", dataDir, as);
+  FILE* out = fopen(to, "wb");
+  TEST_ASSERT_NOT_NULL(out);
+  fwrite(data.data(), 1, data.size(), out);
+  fclose(out);
+}
+
+static int httpConnect() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(80 + LOAD_PORT_OFFSET);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// sends a request with "Connection: close" and reads the answer to its end, returns the status code
+static int httpRequest(const std::string &request, std::string* body, std::string* headers = NULL) {
+  int fd = httpConnect();
+  if (fd < 0) {
+    return -1;
+  }
+  if (!sendAll(fd, request.data(), request.size())) {
+    close(fd);
+    return -1;
+  }
+
+  std::string response;
+  char buffer[16384];
+  ssize_t len;
+  while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, len);
+  }
+  close(fd);
+
+  size_t headerEnd = response.find("\r\n\r\n");
+  if (response.compare(0, 9, "HTTP/1.1 ") != 0 || headerEnd == std::string::npos) {
+    return -1;
+  }
+  *body = response.substr(headerEnd + 4);
+  if (headers != NULL) {
+    *headers = response.substr(0, headerEnd + 2);
+  }
+  return atoi(response.c_str() + 9);
+}
+
+static int httpGet(const char* path, std::string* body) {
+  return httpRequest(std::string("GET ") + path + " HTTP/1.1\r\nConnection: close\r\n\r\n", body);
+}
+
+static int httpUpload(const char* fileName, const std::string &data, std::string* body) {
+  const char* boundary = "----loadtest";
+  std::string form = std::string("--") + boundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"" +
+                     fileName + "\"\r\nContent-Type: audio/mpeg\r\n\r\n" + data + "\r\n--" + boundary + "--\r\n";
+  char header[256];
+  snprintf(header, sizeof(header), "POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=%s\r\n"
+           "Content-Length: %u\r\nConnection: close\r\n\r\n", boundary, (unsigned int) form.size());
+  return httpRequest(header + form, body);
+}
+
+// the results of one client
+struct clientResult_struct {
+  uint32_t requests;
+  uint32_t failures;
+  uint64_t bytes;
+  uint32_t maxMs;
+};
+
+static void uploadClient(const char* fileName, const std::string &data, uint32_t until, clientResult_struct* result) {
+  while ((int32_t) (millis() - until) < 0) {
+    std::string body;
+    uint32_t start = millis();
+    int status = httpUpload(fileName, data, &body);
+    uint32_t ms = millis() - start;
+
+    result->requests++;
+    if (status != 200 || body.find("\"name\": \"") == std::string::npos) {
+      result->failures++;
+    }
+    result->bytes += data.size();
+    result->maxMs = ms > result->maxMs ? ms : result->maxMs;
+  }
+}
+
+static void downloadClient(const char* path, const std::string &expected, uint32_t until, clientResult_struct* result) {
+  while ((int32_t) (millis() - until) < 0) {
+    std::string body;
+    uint32_t start = millis();
+    int status = httpGet(path, &body);
+    uint32_t ms = millis() - start;
+
+    result->requests++;
+    if (status != 200 || body != expected) {
+      result->failures++;
+    }
+    result->bytes += body.size();
+    result->maxMs = ms > result->maxMs ? ms : result->maxMs;
+  }
+}
+
+static void report(const char* name, const clientResult_struct &result) {
+  char message[128];
+  snprintf(message, sizeof(message), "%s: %u requests, %u failed, %u KB/s, longest %u ms", name, result.requests,
+           result.failures, (unsigned int) (result.bytes * 1000 / 1024 / LOAD_MS), result.maxMs);
+  TEST_MESSAGE(message);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_server_answers() {
+  std::string body;
+
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  int status;
+  while ((status = httpGet("/info", &body)) != 200 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_EQUAL(200, status);
+}
+
+// sends a request on a kept open connection and reads its response into a fixed buffer, without the heap
+// returns the status code, the response stays in response
+static int keepAliveRequest(int fd, const char* request, char* response, size_t size) {
+  if (!sendAll(fd, request, strlen(request))) {
+    return -1;
+  }
+  size_t len = 0;
+  const char* headerEnd = NULL;
+  size_t want = 0;
+  while (want == 0 || len < want) {
+    ssize_t got = recv(fd, response + len, size - 1 - len, 0);
+    if (got <= 0) {
+      return -1;
+    }
+    len += got;
+    response[len] = 0;
+    if (headerEnd == NULL && (headerEnd = strstr(response, "\r\n\r\n")) != NULL) {
+      const char* contentLength = strstr(response, "Content-Length: ");
+      want = headerEnd + 4 - response + (contentLength == NULL ? 0 : atoi(contentLength + 16));
+    }
+  }
+  return atoi(response + 9);
+}
+
+void test_requests_do_not_take_the_heap() {
+  int fd = httpConnect();
+  TEST_ASSERT_TRUE(fd >= 0);
+  static char response[8192];
+
+  // the first round opens files and fills the caches, it may allocate
+  TEST_ASSERT_EQUAL(200, keepAliveRequest(fd, "GET /info HTTP/1.1\r\n\r\n", response, sizeof(response)));
+  const char* etag = strstr(response, "ETag: ");
+  TEST_ASSERT_NOT_NULL(etag);
+  char infoRequest[96];
+  snprintf(infoRequest, sizeof(infoRequest), "GET /info HTTP/1.1\r\nIf-None-Match: %.10s\r\n\r\n", etag + 6);
+  char playRequest[48];
+  snprintf(playRequest, sizeof(playRequest), "GET /play/%d HTTP/1.1\r\n\r\n", SHORT_SOUND);
+  const char* requests[] = {playRequest, infoRequest, "GET /stats HTTP/1.1\r\n\r\n",
+                            "GET /favicon.ico HTTP/1.1\r\n\r\n"};
+  int statuses[] = {200, 304, 200, 404};
+  for (size_t i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(statuses[i], keepAliveRequest(fd, requests[i], response, sizeof(response)));
+  }
+  delay(200);
+
+  uint32_t allocations = heapAllocations();
+  for (int round = 0; round < HEAP_ROUNDS; round++) {
+    for (size_t i = 0; i < 4; i++) {
+      TEST_ASSERT_EQUAL(statuses[i], keepAliveRequest(fd, requests[i], response, sizeof(response)));
+    }
+  }
+  // the player takes the last sound on its own task
+  delay(100);
+  uint32_t taken = heapAllocations() - allocations;
+  close(fd);
+  TEST_ASSERT_TRUE(playerStop(micros()));
+
+  char message[96];
+  snprintf(message, sizeof(message), "%u requests on one connection, %u allocations", HEAP_ROUNDS * 4, taken);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL(0, taken);
+}
+
+void test_no_gaps_while_four_clients_upload_and_download() {
+  std::string upload1 = readSample(1);
+  std::string upload2 = readSample(6);
+  std::string download1 = readSample(5);
+  std::string download2 = readSample(4);
+
+  uint32_t underruns = vs1053player.underruns;
+  uint32_t overflows = vs1053player.overflows;
+  uint32_t midFrameStarts = vs1053player.midFrameStarts;
+  uint32_t strayBytes = vs1053player.strayBytes;
+
+  TEST_ASSERT_TRUE(playerPlay(LOAD_SOUND, 0, micros()));
+  delay(300);
+  TEST_ASSERT_EQUAL(LOAD_SOUND, playingSound);
+  uint32_t decoded = vs1053player.decodedBytes;
+
+  clientResult_struct results[4];
+  memset(results, 0, sizeof(results));
+  uint32_t until = millis() + LOAD_MS;
+  std::thread clients[] = {
+    std::thread(uploadClient, "7.mp3", std::cref(upload1), until, &results[0]),
+    std::thread(uploadClient, "8.mp3", std::cref(upload2), until, &results[1]),
+    std::thread(downloadClient, "/download/5", std::cref(download1), until, &results[2]),
+    std::thread(downloadClient, "/download/4", std::cref(download2), until, &results[3]),
+  };
+  for (size_t i = 0; i < 4; i++) {
+    clients[i].join();
+  }
+
+  // still the same sound, and it was played at its bitrate all the time
+  TEST_ASSERT_EQUAL(LOAD_SOUND, playingSound);
+  uint32_t playedBytes = vs1053player.decodedBytes - decoded;
+  TEST_ASSERT_TRUE(playerStop(micros()));
+
+  report("upload 7.mp3  ", results[0]);
+  report("upload 8.mp3  ", results[1]);
+  report("download /5   ", results[2]);
+  report("download /4   ", results[3]);
+  char message[128];
+  snprintf(message, sizeof(message), "sound: %u bytes decoded in %u ms, %u underruns", playedBytes, LOAD_MS,
+           vs1053player.underruns - underruns);
+  TEST_MESSAGE(message);
+
+  for (size_t i = 0; i < 4; i++) {
+    TEST_ASSERT_GREATER_THAN(0, results[i].requests);
+    TEST_ASSERT_EQUAL(0, results[i].failures);
+  }
+  TEST_ASSERT_EQUAL(underruns, vs1053player.underruns);
+  TEST_ASSERT_EQUAL(overflows, vs1053player.overflows);
+  TEST_ASSERT_EQUAL(midFrameStarts, vs1053player.midFrameStarts);
+  TEST_ASSERT_EQUAL(strayBytes, vs1053player.strayBytes);
+  // 128 kbit/s are 16 bytes per ms, a little less is decoded around the clients starting and stopping
+  TEST_ASSERT_GREATER_THAN(LOAD_MS * 16 * 9 / 10, playedBytes);
+}
+
+void test_uploads_were_stored() {
+  std::string body;
+
+  TEST_ASSERT_EQUAL(200, httpGet("/download/7", &body));
+  TEST_ASSERT_GREATER_THAN(0, body.size());
+  TEST_ASSERT_EQUAL(200, httpGet("/download/8", &body));
+  TEST_ASSERT_GREATER_THAN(0, body.size());
+
+  // no temp file is left
+  char path[64];
+  snprintf(path, sizeof(path), "%s/" UPLOAD_TEMP_PREFIX "7.mp3", dataDir);
+  TEST_ASSERT_EQUAL(-1, access(path, F_OK));
+}
+
+void test_only_sounds_can_be_uploaded() {
+  const char* names[] = {"hashes.lst", "~3.mp3", "3.idx", "3.mp3.idx", "index.html", ".mp3", "123456.mp3"};
+  std::string body;
+
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    TEST_ASSERT_EQUAL(404, httpUpload(names[i], "not a sound", &body));
+    TEST_ASSERT_TRUE(body.find("Not a sound file") != std::string::npos);
+
+    // nothing was written, not even a temp file
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", dataDir, names[i]);
+    FILE* file = fopen(path, "rb");
+    if (file != NULL) {
+      char content[16] = {0};
+      fread(content, 1, sizeof(content) - 1, file);
+      fclose(file);
+      TEST_ASSERT_TRUE(strcmp(content, "not a sound") != 0);
+    }
+    snprintf(path, sizeof(path), "%s/~%s", dataDir, names[i]);
+    TEST_ASSERT_EQUAL(-1, access(path, F_OK));
+  }
+
+  // a wav is a sound too
+  TEST_ASSERT_EQUAL(200, httpUpload("9.wav", "RIFF", &body));
+}
+
+// the value of the ETag header, empty when there is none
+static std::string etagOf(const std::string &headers) {
+  size_t at = headers.find("ETag: ");
+  if (at == std::string::npos) {
+    return "";
+  }
+  return headers.substr(at + 6, headers.find("\r\n", at) - at - 6);
+}
+
+void test_manifest_is_cached_until_the_files_change() {
+  std::string body;
+  std::string headers;
+
+  TEST_ASSERT_EQUAL(200, httpRequest("GET /manifest HTTP/1.1\r\nConnection: close\r\n\r\n", &body, &headers));
+  std::string etag = etagOf(headers);
+  TEST_ASSERT_EQUAL(10, etag.size());
+  TEST_ASSERT_TRUE(body.find("\"/9.wav\"") != std::string::npos);
+
+  // the client has it already
+  std::string request = "GET /manifest HTTP/1.1\r\nIf-None-Match: " + etag + "\r\nConnection: close\r\n\r\n";
+  TEST_ASSERT_EQUAL(304, httpRequest(request, &body, &headers));
+  TEST_ASSERT_EQUAL(0, body.size());
+  TEST_ASSERT_TRUE(etagOf(headers) == etag);
+
+  // an upload changes the list and its tag
+  TEST_ASSERT_EQUAL(200, httpUpload("10.wav", "RIFF", &body));
+  TEST_ASSERT_EQUAL(200, httpRequest(request, &body, &headers));
+  TEST_ASSERT_TRUE(etagOf(headers) != etag);
+  TEST_ASSERT_TRUE(body.find("\"/10.wav\", \"size\" : 4, \"uploadSize\" : 4, \"hash\" : \"") != std::string::npos);
+
+  // the filter drops the junk in front of the frames, the hash is the one of the upload and goes with its size
+  std::string sound = std::string(100, '\0') + readSample(2);
+  TEST_ASSERT_EQUAL(200, httpUpload("11.mp3", sound, &body));
+  TEST_ASSERT_EQUAL(200, httpRequest("GET /manifest HTTP/1.1\r\nConnection: close\r\n\r\n", &body, &headers));
+  char entry[96];
+  snprintf(entry, sizeof(entry), "\"/11.mp3\", \"size\" : %u, \"uploadSize\" : %u,", (unsigned int) sound.size() - 100,
+           (unsigned int) sound.size());
+  TEST_ASSERT_TRUE(body.find(entry) != std::string::npos);
+}
+
+void test_info_is_cached_until_the_files_change() {
+  std::string body;
+  std::string headers;
+
+  TEST_ASSERT_EQUAL(200, httpRequest("GET /info HTTP/1.1\r\nConnection: close\r\n\r\n", &body, &headers));
+  std::string etag = etagOf(headers);
+  TEST_ASSERT_EQUAL(10, etag.size());
+  TEST_ASSERT_TRUE(body.find("\"/10.wav\"") != std::string::npos);
+
+  std::string request = "GET /info HTTP/1.1\r\nIf-None-Match: " + etag + "\r\nConnection: close\r\n\r\n";
+  TEST_ASSERT_EQUAL(304, httpRequest(request, &body, &headers));
+  TEST_ASSERT_EQUAL(0, body.size());
+  TEST_ASSERT_TRUE(etagOf(headers) == etag);
+
+  // a delete changes the list and its tag
+  TEST_ASSERT_EQUAL(200, httpGet("/delete/10.wav", &body));
+  TEST_ASSERT_EQUAL(200, httpRequest(request, &body, &headers));
+  TEST_ASSERT_TRUE(etagOf(headers) != etag);
+  TEST_ASSERT_EQUAL(10, etagOf(headers).size());
+  TEST_ASSERT_TRUE(body.find("\"/10.wav\"") == std::string::npos);
+}
+
+void test_stream_buffer_is_only_there_while_streaming() {
+  // more than the jitter buffer takes, the server has to wait for the player
+  std::string sound = readSample(4);
+  std::string body;
+  uint32_t strayBytes = vs1053player.strayBytes;
+  TEST_ASSERT_NULL(streambufdata);
+
+  char header[128];
+  snprintf(header, sizeof(header), "POST /stream HTTP/1.1\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+           (unsigned int) sound.size());
+  TEST_ASSERT_EQUAL(200, httpRequest(header + sound, &body));
+  TEST_ASSERT_TRUE(body.find("\"stopped\" : false") != std::string::npos);
+
+  // given back once the player is through with it
+  uint32_t start = millis();
+  while (streambufdata != NULL && millis() - start < 3000) {
+    delay(10);
+  }
+  TEST_ASSERT_NULL(streambufdata);
+  TEST_ASSERT_EQUAL(strayBytes, vs1053player.strayBytes);
+}
+
+void test_delete_waits_for_the_playing_sound() {
+  std::string body;
+  uint32_t strayBytes = vs1053player.strayBytes;
+  uint32_t midFrameStarts = vs1053player.midFrameStarts;
+
+  // 1.mp3 plays for about 1.8 s
+  TEST_ASSERT_TRUE(playerPlay(1, 0, micros()));
+  delay(200);
+  TEST_ASSERT_EQUAL(1, playingSound);
+  uint32_t start = millis();
+  TEST_ASSERT_EQUAL(200, httpGet("/delete/1.mp3", &body));
+  uint32_t waited = millis() - start;
+
+  char message[64];
+  snprintf(message, sizeof(message), "delete answered after %u ms", waited);
+  TEST_MESSAGE(message);
+  // the file was read to its end before it was removed
+  TEST_ASSERT_GREATER_THAN(500, waited);
+  TEST_ASSERT_EQUAL(strayBytes, vs1053player.strayBytes);
+  TEST_ASSERT_EQUAL(midFrameStarts, vs1053player.midFrameStarts);
+  char path[64];
+  snprintf(path, sizeof(path), "%s/1.mp3", dataDir);
+  TEST_ASSERT_EQUAL(-1, access(path, F_OK));
+  TEST_ASSERT_EQUAL(404, httpGet("/download/1", &body));
+}
+
+void test_upload_over_a_file_waits_for_its_download() {
+  // longer than the socket buffers of the host take, the download has to go on while the client waits
+  std::string oldSound;
+  for (int i = 0; i < 40; i++) {
+    oldSound += readSample(3);
+  }
+  std::string newSound = readSample(6);
+  char path[64];
+  snprintf(path, sizeof(path), "%s/12.mp3", dataDir);
+  FILE* out = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(out);
+  fwrite(oldSound.data(), 1, oldSound.size(), out);
+  fclose(out);
+
+  // a small receive buffer keeps the download going while the client does not read
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int size = 4096;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(80 + LOAD_PORT_OFFSET);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST_ASSERT_EQUAL(0, connect(fd, (struct sockaddr*) &addr, sizeof(addr)));
+  const char* request = "GET /download/12 HTTP/1.1\r\nConnection: close\r\n\r\n";
+  TEST_ASSERT_TRUE(sendAll(fd, request, strlen(request)));
+  std::string response;
+  char buffer[1024];
+  ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+  TEST_ASSERT_GREATER_THAN(0, len);
+  response.append(buffer, len);
+
+  std::atomic<int> uploadStatus(0);
+  std::thread upload([&newSound, &uploadStatus]() {
+    std::string body;
+    uploadStatus = httpUpload("12.mp3", newSound, &body);
+  });
+  delay(500);
+  // the old file is still downloaded
+  TEST_ASSERT_EQUAL(0, uploadStatus);
+
+  while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, len);
+  }
+  close(fd);
+  upload.join();
+
+  size_t headerEnd = response.find("\r\n\r\n");
+  TEST_ASSERT_TRUE(headerEnd != std::string::npos);
+  TEST_ASSERT_EQUAL(oldSound.size(), response.size() - headerEnd - 4);
+  TEST_ASSERT_TRUE(response.compare(headerEnd + 4, std::string::npos, oldSound) == 0);
+  TEST_ASSERT_EQUAL(200, uploadStatus);
+
+  // and the new one is there afterwards
+  std::string body;
+  TEST_ASSERT_EQUAL(200, httpGet("/download/12", &body));
+  TEST_ASSERT_GREATER_THAN(0, body.size());
+  TEST_ASSERT_TRUE(body.size() <= newSound.size());
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 6; n++) {
+    copySample(n, n);
+  }
+  copySample(2, SHORT_SOUND, SOUND_CACHE_HEAD_SIZE);
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(LOAD_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_server_answers);
+  RUN_TEST(test_requests_do_not_take_the_heap);
+  RUN_TEST(test_no_gaps_while_four_clients_upload_and_download);
+  RUN_TEST(test_uploads_were_stored);
+  RUN_TEST(test_only_sounds_can_be_uploaded);
+  RUN_TEST(test_manifest_is_cached_until_the_files_change);
+  RUN_TEST(test_info_is_cached_until_the_files_change);
+  RUN_TEST(test_stream_buffer_is_only_there_while_streaming);
+  RUN_TEST(test_delete_waits_for_the_playing_sound);
+  RUN_TEST(test_upload_over_a_file_waits_for_its_download);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
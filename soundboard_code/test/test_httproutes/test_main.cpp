@@ -0,0 +1,228 @@
+/**
+   Tests of the route table and the line parsing of the http server, and of the decoder of chunked bodies.
+*/
+#include <unity.h>
+#include <string.h>
+#include <string>
+
+#include "HttpRoutes.h"
+
+static httpRequestLine_struct request;
+
+static bool parse(const char* line) {
+  return httpParseRequestLine(line, strlen(line), request);
+}
+
+static bool viewIs(const httpView_struct &view, const char* text) {
+  return view.len == strlen(text) && memcmp(view.data, text, view.len) == 0;
+}
+
+// the action of the request line, NONE when no route takes it
+static httpClientAction_t route(const char* line) {
+  if (!parse(line)) {
+    return NONE;
+  }
+  const httpRoute_struct* found = httpFindRoute(request);
+  return found == NULL ? NONE : found->action;
+}
+
+static httpHeader_t header(const char* line, httpView_struct &value) {
+  return httpParseHeader(line, strlen(line), value);
+}
+
+static httpView_struct view(const char* text) {
+  httpView_struct result = { text, strlen(text) };
+  return result;
+}
+
+// decodes a whole chunked body fed in pieces of the given size, returns the data or "error"
+static std::string dechunk(const std::string &body, size_t piece) {
+  httpChunked_struct chunked;
+  httpChunkedBegin(chunked);
+  std::string data;
+  uint32_t left = 0;
+
+  for (size_t pos = 0; pos < body.size(); pos += piece) {
+    const uint8_t* block = (const uint8_t*) body.data() + pos;
+    size_t len = piece < body.size() - pos ? piece : body.size() - pos;
+
+    while (len > 0 && chunked.state != CHUNK_DONE) {
+      if (left > 0) {
+        size_t take = left < len ? left : len;
+        data.append((const char*) block, take);
+        block += take;
+        len -= take;
+        left -= take;
+        continue;
+      }
+      size_t used = httpChunkedFrame(chunked, block, len, left);
+      if (chunked.state == CHUNK_ERROR) {
+        return "error";
+      }
+      block += used;
+      len -= used;
+    }
+  }
+  return chunked.state == CHUNK_DONE ? data : "unfinished";
+}
+
+void setUp() {
+  memset(&request, 0, sizeof(request));
+}
+
+void tearDown() {
+}
+
+void test_request_line_is_split_into_views() {
+  TEST_ASSERT_TRUE(parse("GET /play/12/500 HTTP/1.1"));
+
+  TEST_ASSERT_TRUE(viewIs(request.method, "GET"));
+  TEST_ASSERT_TRUE(viewIs(request.path, "/play"));
+  TEST_ASSERT_TRUE(viewIs(request.param, "12/500"));
+  TEST_ASSERT_TRUE(request.http11);
+}
+
+void test_query_and_old_versions() {
+  TEST_ASSERT_TRUE(parse("GET /download/3?nocache=1 HTTP/1.0"));
+
+  TEST_ASSERT_TRUE(viewIs(request.path, "/download"));
+  TEST_ASSERT_TRUE(viewIs(request.param, "3"));
+  TEST_ASSERT_FALSE(request.http11);
+
+  TEST_ASSERT_TRUE(parse("GET /info?x=/y HTTP/1.1"));
+  TEST_ASSERT_TRUE(viewIs(request.path, "/info"));
+  TEST_ASSERT_EQUAL(0, request.param.len);
+}
+
+void test_lines_which_are_no_request() {
+  TEST_ASSERT_FALSE(parse("GET"));
+  TEST_ASSERT_FALSE(parse(" /info HTTP/1.1"));
+  TEST_ASSERT_FALSE(parse("GET /info"));
+  TEST_ASSERT_FALSE(parse("GET info HTTP/1.1"));
+  TEST_ASSERT_FALSE(parse("Host: 192.168.4.1"));
+}
+
+void test_every_route_is_found() {
+  TEST_ASSERT_EQUAL(PLAY, route("GET /play/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(DOWNLOAD, route("GET /download/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(DELETE, route("GET /delete/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(INFO, route("GET /info HTTP/1.1"));
+  TEST_ASSERT_EQUAL(RESTART, route("GET /restart HTTP/1.1"));
+  TEST_ASSERT_EQUAL(STATS, route("GET /stats HTTP/1.1"));
+  TEST_ASSERT_EQUAL(EVENTS, route("GET /events HTTP/1.1"));
+  TEST_ASSERT_EQUAL(MANIFEST, route("GET /manifest HTTP/1.1"));
+  TEST_ASSERT_EQUAL(UPLOAD_INIT, route("POST /upload HTTP/1.1"));
+  TEST_ASSERT_EQUAL(STREAM, route("POST /stream HTTP/1.1"));
+}
+
+void test_parameter_only_where_the_route_wants_one() {
+  TEST_ASSERT_EQUAL(NONE, route("GET /play HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /play/ HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /info/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("POST /upload/1.mp3 HTTP/1.1"));
+}
+
+void test_unknown_requests_have_no_route() {
+  TEST_ASSERT_EQUAL(NONE, route("POST /play/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /upload HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /playx/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /pla/1 HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET /INFO HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("get /info HTTP/1.1"));
+  TEST_ASSERT_EQUAL(NONE, route("GET / HTTP/1.1"));
+}
+
+void test_route_hash_is_the_one_of_the_compiler() {
+  static_assert(httpHash("GET /info") != httpHash("GET /info "), "the space counts");
+
+  TEST_ASSERT_TRUE(parse("GET /info HTTP/1.1"));
+  TEST_ASSERT_EQUAL_HEX32(httpHash("GET /info"), httpFindRoute(request)->hash);
+  // the empty string is the start value of fnv-1a
+  TEST_ASSERT_EQUAL_HEX32(2166136261UL, httpHash(""));
+}
+
+void test_headers_are_matched_without_case() {
+  httpView_struct value;
+
+  TEST_ASSERT_EQUAL(HEADER_CONNECTION, header("Connection: keep-alive", value));
+  TEST_ASSERT_TRUE(viewIs(value, "keep-alive"));
+  TEST_ASSERT_EQUAL(HEADER_CONTENT_TYPE, header("content-type:  text/plain \t", value));
+  TEST_ASSERT_TRUE(viewIs(value, "text/plain"));
+  TEST_ASSERT_EQUAL(HEADER_RANGE, header("RANGE:bytes=0-99", value));
+  TEST_ASSERT_TRUE(viewIs(value, "bytes=0-99"));
+  TEST_ASSERT_EQUAL(HEADER_IF_NONE_MATCH, header("If-None-Match: \"1a2b\"", value));
+  TEST_ASSERT_EQUAL(HEADER_CONTENT_LENGTH, header("Content-Length: 12", value));
+  TEST_ASSERT_EQUAL(HEADER_TRANSFER_ENCODING, header("Transfer-Encoding: chunked", value));
+}
+
+void test_other_headers() {
+  httpView_struct value;
+
+  TEST_ASSERT_EQUAL(HEADER_OTHER, header("Host: 192.168.4.1", value));
+  TEST_ASSERT_EQUAL(HEADER_OTHER, header("Connection-Foo: close", value));
+  TEST_ASSERT_EQUAL(HEADER_OTHER, header("Connection close", value));
+  TEST_ASSERT_EQUAL(HEADER_OTHER, header("", value));
+}
+
+void test_boundary_of_the_content_type() {
+  httpView_struct boundary;
+
+  TEST_ASSERT_TRUE(httpFindBoundary(view("multipart/form-data; boundary=----abc"), boundary));
+  TEST_ASSERT_TRUE(viewIs(boundary, "----abc"));
+  TEST_ASSERT_TRUE(httpFindBoundary(view("Multipart/Form-Data; charset=utf-8; Boundary= xyz ; a=b"), boundary));
+  TEST_ASSERT_TRUE(viewIs(boundary, "xyz"));
+  // a quoted boundary is passed on with its quotes, the parser takes them off
+  TEST_ASSERT_TRUE(httpFindBoundary(view("multipart/form-data; boundary=\"q r\""), boundary));
+  TEST_ASSERT_TRUE(viewIs(boundary, "\"q r\""));
+}
+
+void test_no_boundary() {
+  httpView_struct boundary;
+
+  TEST_ASSERT_FALSE(httpFindBoundary(view("text/plain; boundary=abc"), boundary));
+  TEST_ASSERT_FALSE(httpFindBoundary(view("multipart/form-data"), boundary));
+  TEST_ASSERT_FALSE(httpFindBoundary(view("multipart/form-data; boundary="), boundary));
+  TEST_ASSERT_FALSE(httpFindBoundary(view("multipart/form-data; boundary=;"), boundary));
+}
+
+void test_view_contains() {
+  TEST_ASSERT_TRUE(httpViewContains(view("keep-alive, Close"), "close"));
+  TEST_ASSERT_FALSE(httpViewContains(view("keep-alive"), "close"));
+  TEST_ASSERT_FALSE(httpViewContains(view("clos"), "close"));
+}
+
+void test_chunked_body_in_every_piece_size() {
+  std::string body = "5\r\nhello\r\n1A;name=value\r\nabcdefghijklmnopqrstuvwxyz\r\n0\r\nX-Trailer: 1\r\n\r\n";
+
+  for (size_t piece = 1; piece <= body.size(); piece++) {
+    std::string data = dechunk(body, piece);
+    TEST_ASSERT_EQUAL_STRING("helloabcdefghijklmnopqrstuvwxyz", data.c_str());
+  }
+}
+
+void test_chunked_body_errors() {
+  TEST_ASSERT_TRUE(dechunk("5x\r\nhello\r\n0\r\n\r\n", 64) == "error");
+  TEST_ASSERT_TRUE(dechunk("5\r\nhelloX\r\n0\r\n\r\n", 64) == "error");
+  // more than 32 bits of size
+  TEST_ASSERT_TRUE(dechunk("123456789\r\n", 64) == "error");
+  TEST_ASSERT_TRUE(dechunk("5\r\nhello\r\n0\r\n", 64) == "unfinished");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_request_line_is_split_into_views);
+  RUN_TEST(test_query_and_old_versions);
+  RUN_TEST(test_lines_which_are_no_request);
+  RUN_TEST(test_every_route_is_found);
+  RUN_TEST(test_parameter_only_where_the_route_wants_one);
+  RUN_TEST(test_unknown_requests_have_no_route);
+  RUN_TEST(test_route_hash_is_the_one_of_the_compiler);
+  RUN_TEST(test_headers_are_matched_without_case);
+  RUN_TEST(test_other_headers);
+  RUN_TEST(test_boundary_of_the_content_type);
+  RUN_TEST(test_no_boundary);
+  RUN_TEST(test_view_contains);
+  RUN_TEST(test_chunked_body_in_every_piece_size);
+  RUN_TEST(test_chunked_body_errors);
+  return UNITY_END();
+}
@@ -0,0 +1,320 @@
+/**
+   Benchmark of /info: the old httpGetInfo() walked the SPIFFS root and read the frame index of every
+   sound on each request, the server now keeps the body, builds it again from the FileCatalogue only
+   when the files changed, and answers a matching If-None-Match with 304.
+   The old walk runs here on the same File stand-ins as the firmware, without the stats of the sound
+   cache which it also printed.  It is timed in the process against the rebuild from the catalogue,
+   the median of BENCH_RUNS each.  The bytes on the wire are those of the firmware itself with wifi on,
+   answering the full /info and the 304 on a kept open connection.  Their times are mostly the wait
+   for the next loop(), which sleeps 1 ms on the host.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "SPIFFS.h"
+#include "WiFi.h"
+#include "StreamString.h"
+#include "FileCatalogue.h"
+#include "Mp3IndexFile.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_PORT_OFFSET 27000                  // The firmware listens on 27080
+#define BENCH_RUNS 90                            // Polls of the web ui
+#define BENCH_FILES 40                           // Sounds on the flash, the samples over again
+
+// the wifi switch of the firmware in main.cpp
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/infobenchXXXXXX";
+
+// the body of the old httpGetInfo(), without freeMem and the sound cache
+static void oldInfoBody(StreamString &body) {
+  body.println("{"); // main {}
+
+  body.print("\"version\" : \"");
+  body.print(VERSION);
+  body.println("\",");
+
+  body.print("\"name\" : \"");
+  body.print(NAME);
+  body.println("\",");
+
+  body.print("\"flashSize\" : ");
+  body.print(ESP.getFlashChipSize());
+  body.println(",");
+
+  uint64_t chipid = ESP.getEfuseMac();
+  body.print("\"chipId\" : \"");
+  body.printf("%04X", (uint16_t)(chipid >> 32));
+  body.printf("%08X", (uint32_t)chipid);
+  body.println("\",");
+
+  body.print("\"macAddress\" : \"");
+  body.print(WiFi.macAddress());
+  body.println("\",");
+
+  body.println("\"files\" : ["); // files {}
+  File root = SPIFFS.open("/", FILE_READ);
+  File file = root.openNextFile();
+  String sep = "";
+  mp3IndexHeader index;
+  while (file) {
+    String name = file.name();
+
+    // the frame indexes are shown as duration of their mp3
+    if (name.endsWith(".idx")) {
+      file.close();
+      file = root.openNextFile();
+      continue;
+    }
+
+    body.print(sep);
+    body.print("{\"name\" : \"");
+    body.print(name);
+    body.print("\",\"size\": ");
+    body.print((unsigned int) file.size());
+    if (Mp3IndexFile::readHeader(name, &index)) {
+      body.print(",\"duration\": ");
+      body.print(index.durationMs);
+      body.print(",\"frames\": ");
+      body.print(index.frameCount);
+      body.print(",\"bitrate\": ");
+      body.print(index.avgBitrate);
+    }
+    body.println("}");
+    file.close();
+
+    file = root.openNextFile();
+    sep = ",";
+  }
+  root.close();
+
+  body.println("]"); // eo file {}
+
+  body.println("}"); // eo main {}
+}
+
+// what httpBuildInfo() does when the files changed
+static void cachedInfoBody(StreamString &body) {
+  body.println("{"); // main {}
+
+  body.print("\"version\" : \"");
+  body.print(VERSION);
+  body.println("\",");
+
+  body.print("\"name\" : \"");
+  body.print(NAME);
+  body.println("\",");
+
+  body.print("\"flashSize\" : ");
+  body.print(ESP.getFlashChipSize());
+  body.println(",");
+
+  uint64_t chipid = ESP.getEfuseMac();
+  body.print("\"chipId\" : \"");
+  body.printf("%04X", (uint16_t)(chipid >> 32));
+  body.printf("%08X", (uint32_t)chipid);
+  body.println("\",");
+
+  body.print("\"macAddress\" : \"");
+  body.print(WiFi.macAddress());
+  body.println("\",");
+
+  body.print("\"files\" : ");
+  fileCatalogue.printJson(body);
+  body.println();
+
+  body.println("}"); // eo main {}
+}
+
+static int connectTo(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+// sends a request on a kept open connection and reads its response, returns the us it took
+static uint32_t request(int fd, const std::string &request, std::string* response) {
+  uint32_t start = micros();
+  send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+  response->clear();
+  char buffer[4096];
+  size_t headerEnd;
+  const char* length;
+  // a 304 has no body and no Content-Length
+  while ((headerEnd = response->find("\r\n\r\n")) == std::string::npos ||
+         ((length = strstr(response->c_str(), "Content-Length: ")) != NULL &&
+          response->size() < headerEnd + 4 + atoi(length + 16))) {
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len <= 0) {
+      return 0;
+    }
+    response->append(buffer, len);
+  }
+  return micros() - start;
+}
+
+static uint32_t median(uint32_t* values, size_t count) {
+  std::sort(values, values + count);
+  return values[count / 2];
+}
+
+static void report(const char* name, double us, size_t bytes) {
+  char message[128];
+  snprintf(message, sizeof(message), "%s: median %6.1f us, %5u bytes", name, us, (unsigned int) bytes);
+  TEST_MESSAGE(message);
+}
+
+static uint32_t oldTenthUs;                     // Medians of ten bodies
+static uint32_t rebuildTenthUs;
+static size_t fullBytes;
+static size_t notModifiedBytes;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// a run builds the body ten times, the rebuild takes only a few us
+void test_old_walk_of_the_flash() {
+  uint32_t runs[BENCH_RUNS];
+  size_t bytes = 0;
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    uint32_t start = micros();
+    for (int j = 0; j < 10; j++) {
+      StreamString body;
+      oldInfoBody(body);
+      bytes = body.length();
+    }
+    runs[i] = micros() - start;
+  }
+  TEST_ASSERT_GREATER_THAN(BENCH_FILES * 20, bytes);
+
+  oldTenthUs = median(runs, BENCH_RUNS);
+  report("old walk of the flash   ", oldTenthUs / 10.0, bytes);
+}
+
+void test_rebuild_from_the_catalogue() {
+  uint32_t runs[BENCH_RUNS];
+  size_t bytes = 0;
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    uint32_t start = micros();
+    for (int j = 0; j < 10; j++) {
+      StreamString body;
+      cachedInfoBody(body);
+      bytes = body.length();
+    }
+    runs[i] = micros() - start;
+  }
+  TEST_ASSERT_GREATER_THAN(BENCH_FILES * 20, bytes);
+
+  rebuildTenthUs = median(runs, BENCH_RUNS);
+  report("rebuild from catalogue  ", rebuildTenthUs / 10.0, bytes);
+}
+
+void test_cached_info_on_the_wire() {
+  uint16_t port = 80 + BENCH_PORT_OFFSET;
+
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  int fd;
+  while ((fd = connectTo(port)) < 0 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_TRUE(fd >= 0);
+
+  std::string response;
+  uint32_t fullRuns[BENCH_RUNS / 2];
+  uint32_t notModifiedRuns[BENCH_RUNS / 2];
+  TEST_ASSERT_GREATER_THAN(0, request(fd, "GET /info HTTP/1.1\r\n\r\n", &response));
+  size_t at = response.find("ETag: ");
+  TEST_ASSERT_TRUE(at != std::string::npos);
+  std::string etag = response.substr(at + 6, response.find("\r\n", at) - at - 6);
+  std::string conditional = "GET /info HTTP/1.1\r\nIf-None-Match: " + etag + "\r\n\r\n";
+
+  // below HTTP_KEEPALIVE_MAX requests on the connection
+  for (int i = 0; i < BENCH_RUNS / 2; i++) {
+    fullRuns[i] = request(fd, "GET /info HTTP/1.1\r\n\r\n", &response);
+    TEST_ASSERT_EQUAL(200, atoi(response.c_str() + 9));
+    fullBytes = response.size();
+    notModifiedRuns[i] = request(fd, conditional, &response);
+    TEST_ASSERT_EQUAL(304, atoi(response.c_str() + 9));
+    notModifiedBytes = response.size();
+  }
+  close(fd);
+
+  report("cached, full response   ", median(fullRuns, BENCH_RUNS / 2), fullBytes);
+  report("cached, 304             ", median(notModifiedRuns, BENCH_RUNS / 2), notModifiedBytes);
+}
+
+void test_cache_is_faster() {
+  char message[96];
+  snprintf(message, sizeof(message), "rebuild %.1fx faster than the walk, a 304 is %.0f%% of the bytes",
+           (double) oldTenthUs / (rebuildTenthUs > 0 ? rebuildTenthUs : 1), 100.0 * notModifiedBytes / fullBytes);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(oldTenthUs, rebuildTenthUs);
+  TEST_ASSERT_LESS_THAN(fullBytes / 4, notModifiedBytes);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= BENCH_FILES; n++) {
+    char command[128];
+    snprintf(command, sizeof(command), "cp " SAMPLEDATA_DIR "%d.mp3 %s/%d.mp3", 1 + (n - 1) % 6, dataDir, n);
+    TEST_ASSERT_EQUAL(0, system(command));
+  }
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(BENCH_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_old_walk_of_the_flash);
+  RUN_TEST(test_rebuild_from_the_catalogue);
+  RUN_TEST(test_cached_info_on_the_wire);
+  RUN_TEST(test_cache_is_faster);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
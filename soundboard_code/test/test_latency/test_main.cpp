@@ -0,0 +1,146 @@
+/**
+   Tests of the latency histograms and of the stage tracker behind the "latency" part of /stats.
+*/
+#include <unity.h>
+
+#include "LatencyStats.h"
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_small_values_get_a_bucket_each() {
+  for (uint32_t us = 0; us < (1UL << LATENCY_SUB_BITS); us++) {
+    TEST_ASSERT_EQUAL(us, LatencyHistogram::bucketOf(us));
+    TEST_ASSERT_EQUAL(us, LatencyHistogram::bucketUpperBound(us));
+  }
+}
+
+void test_every_value_is_inside_its_bucket() {
+  uint32_t values[] = {4, 5, 7, 8, 100, 999, 1000, 1024, 65535, 1000000, 0x7FFFFFFF, 0xFFFFFFFF};
+
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    uint16_t bucket = LatencyHistogram::bucketOf(values[i]);
+    TEST_ASSERT_LESS_THAN(LATENCY_BUCKETS, bucket);
+    TEST_ASSERT_GREATER_OR_EQUAL(values[i], LatencyHistogram::bucketUpperBound(bucket));
+    TEST_ASSERT_LESS_THAN(values[i], LatencyHistogram::bucketUpperBound(bucket - 1));
+  }
+}
+
+void test_bucket_error_stays_below_a_quarter() {
+  for (uint32_t us = 4; us < 2000000; us = us * 9 / 8 + 1) {
+    uint32_t upper = LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(us));
+    TEST_ASSERT_LESS_THAN((uint64_t) us * 5 / 4 + 1, upper);
+  }
+}
+
+void test_empty_histogram() {
+  LatencyHistogram histogram;
+
+  TEST_ASSERT_EQUAL(0, histogram.count());
+  TEST_ASSERT_EQUAL(0, histogram.percentile(50));
+  TEST_ASSERT_EQUAL(0, histogram.max());
+}
+
+void test_percentiles() {
+  LatencyHistogram histogram;
+
+  // 1..1000 us, so p50 is about 500 and p99 about 990
+  for (uint32_t us = 1; us <= 1000; us++) {
+    histogram.record(us);
+  }
+
+  TEST_ASSERT_EQUAL(1000, histogram.count());
+  TEST_ASSERT_EQUAL(1000, histogram.max());
+  TEST_ASSERT_UINT32_WITHIN(125, 500, histogram.percentile(50));
+  TEST_ASSERT_UINT32_WITHIN(240, 950, histogram.percentile(95));
+  TEST_ASSERT_UINT32_WITHIN(10, 1000, histogram.percentile(99));
+  TEST_ASSERT_EQUAL(1000, histogram.percentile(100));
+  TEST_ASSERT_TRUE(histogram.percentile(50) <= histogram.percentile(95));
+}
+
+void test_percentile_never_exceeds_the_max() {
+  LatencyHistogram histogram;
+
+  histogram.record(1025);
+  TEST_ASSERT_EQUAL(1025, histogram.percentile(50));
+  TEST_ASSERT_EQUAL(1025, histogram.percentile(99));
+}
+
+void test_reset() {
+  LatencyHistogram histogram;
+
+  histogram.record(10);
+  histogram.reset();
+  TEST_ASSERT_EQUAL(0, histogram.count());
+  TEST_ASSERT_EQUAL(0, histogram.percentile(99));
+}
+
+void test_stages_are_measured_from_the_trigger() {
+  LatencyTracker tracker;
+
+  tracker.start(1000);
+  tracker.mark(STAGE_OPENED, 1200);
+  tracker.mark(STAGE_QUEUED, 1500);
+  tracker.mark(STAGE_PLAYED, 3000);
+
+  TEST_ASSERT_EQUAL(200, tracker.histogram(STAGE_OPENED).max());
+  TEST_ASSERT_EQUAL(500, tracker.histogram(STAGE_QUEUED).max());
+  TEST_ASSERT_EQUAL(2000, tracker.histogram(STAGE_PLAYED).max());
+}
+
+void test_only_the_first_mark_counts() {
+  LatencyTracker tracker;
+
+  tracker.start(0);
+  TEST_ASSERT_TRUE(tracker.pending(STAGE_QUEUED));
+  tracker.mark(STAGE_QUEUED, 100);
+  TEST_ASSERT_FALSE(tracker.pending(STAGE_QUEUED));
+  // every later block of the same sound marks the stage again
+  tracker.mark(STAGE_QUEUED, 200);
+  tracker.mark(STAGE_QUEUED, 300);
+
+  TEST_ASSERT_EQUAL(1, tracker.histogram(STAGE_QUEUED).count());
+  TEST_ASSERT_EQUAL(100, tracker.histogram(STAGE_QUEUED).max());
+}
+
+void test_marks_without_a_trigger_are_ignored() {
+  LatencyTracker tracker;
+
+  tracker.mark(STAGE_PLAYED, 500);
+  TEST_ASSERT_EQUAL(0, tracker.histogram(STAGE_PLAYED).count());
+}
+
+void test_time_wraps() {
+  LatencyTracker tracker;
+
+  // micros() wraps after 71 minutes
+  tracker.start(0xFFFFFF00UL);
+  tracker.mark(STAGE_OPENED, 0x100);
+  TEST_ASSERT_EQUAL(0x200, tracker.histogram(STAGE_OPENED).max());
+}
+
+void test_stage_names() {
+  TEST_ASSERT_EQUAL_STRING("opened", LatencyTracker::stageName(STAGE_OPENED));
+  TEST_ASSERT_EQUAL_STRING("queued", LatencyTracker::stageName(STAGE_QUEUED));
+  TEST_ASSERT_EQUAL_STRING("played", LatencyTracker::stageName(STAGE_PLAYED));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_values_get_a_bucket_each);
+  RUN_TEST(test_every_value_is_inside_its_bucket);
+  RUN_TEST(test_bucket_error_stays_below_a_quarter);
+  RUN_TEST(test_empty_histogram);
+  RUN_TEST(test_percentiles);
+  RUN_TEST(test_percentile_never_exceeds_the_max);
+  RUN_TEST(test_reset);
+  RUN_TEST(test_stages_are_measured_from_the_trigger);
+  RUN_TEST(test_only_the_first_mark_counts);
+  RUN_TEST(test_marks_without_a_trigger_are_ignored);
+  RUN_TEST(test_time_wraps);
+  RUN_TEST(test_stage_names);
+  return UNITY_END();
+}
@@ -0,0 +1,109 @@
+/**
+   Benchmark of the polyphony mixer: how many voices at MIXER_SAMPLE_RATE one core can mix.
+   The sources hand out samples from memory, so only mix() and its saturating kernel are measured,
+   not the reading of the wav files.
+*/
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+
+#include "Configuration.h"
+#include "PcmMixer.h"
+
+#define BENCH_SAMPLES (MIXER_SAMPLE_RATE * 20)   // 20 seconds of the mix
+#define BENCH_BLOCK 512                          // Samples per mix() call, like mixLoop()
+
+// loops over a loud noise, so the saturation is hit often
+class NoiseSource : public PcmSource {
+  public:
+    NoiseSource() {
+      uint32_t seed = 12345;
+      for (size_t i = 0; i < sizeof(_samples) / sizeof(_samples[0]); i++) {
+        seed = seed * 1103515245 + 12345;
+        _samples[i] = (int16_t) (seed >> 16);
+      }
+    }
+
+    size_t read(int16_t* samples, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        samples[i] = _samples[(_pos + i) & 1023];
+      }
+      _pos += count;
+      return count;
+    }
+
+    void close() {
+    }
+
+  private:
+    int16_t _samples[1024];
+    size_t _pos = 0;
+};
+
+static NoiseSource sources[MIXER_MAX_VOICES];
+static int16_t out[BENCH_BLOCK];
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// samples of the mix per second with the given number of voices playing
+static double mixRate(uint8_t voices) {
+  PcmMixer mixer(voices);
+  for (uint8_t i = 0; i < voices; i++) {
+    mixer.startVoice(mixer.allocVoice(), &sources[i]);
+  }
+
+  int32_t check = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t done = 0; done < BENCH_SAMPLES; done += BENCH_BLOCK) {
+    mixer.mix(out, BENCH_BLOCK);
+    check += out[done & (BENCH_BLOCK - 1)];
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // keeps the compiler from dropping the mix
+  TEST_ASSERT_TRUE(check != 0x7FFFFFFF);
+  return BENCH_SAMPLES / seconds;
+}
+
+void test_mix_throughput() {
+  char line[120];
+
+  for (uint8_t voices = 1; voices <= MIXER_MAX_VOICES; voices *= 2) {
+    double rate = mixRate(voices);
+    snprintf(line, sizeof(line), "%u voices: %.1f Msamples/s mixed, %.2f Mvoice-samples/s, %.0fx real time",
+             voices, rate / 1e6, rate * voices / 1e6, rate / MIXER_SAMPLE_RATE);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(rate > MIXER_SAMPLE_RATE);
+  }
+}
+
+void test_saturate_kernel_throughput() {
+  static int16_t dst[4096];
+  static int16_t src[4096];
+  for (size_t i = 0; i < 4096; i++) {
+    src[i] = (int16_t) (i * 97);
+  }
+
+  const size_t rounds = 20000;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < rounds; i++) {
+    PcmMixer::mixSaturate(dst, src, 4096);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  char line[80];
+  snprintf(line, sizeof(line), "mixSaturate: %.0f Msamples/s", rounds * 4096 / seconds / 1e6);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(dst[1] != 0x1234 || dst[2] != 0x1234);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mix_throughput);
+  RUN_TEST(test_saturate_kernel_throughput);
+  return UNITY_END();
+}
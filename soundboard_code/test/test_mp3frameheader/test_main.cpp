@@ -0,0 +1,123 @@
+/**
+   Tests of the mpeg audio frame header parser with headers of every version and layer.
+*/
+#include <unity.h>
+
+#include "Mp3FrameHeader.h"
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_mpeg1_layer3() {
+  // 128 kbit/s, 44100 Hz, joint stereo, what most of the sounds are
+  const uint8_t header[] = {0xFF, 0xFB, 0x90, 0x64};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(MPEG_1, info.version);
+  TEST_ASSERT_EQUAL(3, info.layer);
+  TEST_ASSERT_FALSE(info.crc);
+  TEST_ASSERT_EQUAL(128, info.bitrate);
+  TEST_ASSERT_EQUAL(44100, info.sampleRate);
+  TEST_ASSERT_FALSE(info.mono);
+  TEST_ASSERT_EQUAL(417, info.frameLength);
+  TEST_ASSERT_EQUAL(1152, info.samplesPerFrame);
+  TEST_ASSERT_EQUAL(32, info.sideInfoSize);
+}
+
+void test_padding_adds_a_byte() {
+  const uint8_t header[] = {0xFF, 0xFB, 0x92, 0x64};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(418, info.frameLength);
+}
+
+void test_mpeg2_layer3_mono() {
+  // 32 kbit/s, 16000 Hz
+  const uint8_t header[] = {0xFF, 0xF3, 0x48, 0xC4};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(MPEG_2, info.version);
+  TEST_ASSERT_EQUAL(3, info.layer);
+  TEST_ASSERT_EQUAL(32, info.bitrate);
+  TEST_ASSERT_EQUAL(16000, info.sampleRate);
+  TEST_ASSERT_TRUE(info.mono);
+  TEST_ASSERT_EQUAL(144, info.frameLength);
+  TEST_ASSERT_EQUAL(576, info.samplesPerFrame);
+  TEST_ASSERT_EQUAL(9, info.sideInfoSize);
+}
+
+void test_mpeg25_layer3() {
+  // 8 kbit/s, 8000 Hz
+  const uint8_t header[] = {0xFF, 0xE3, 0x18, 0x00};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(MPEG_25, info.version);
+  TEST_ASSERT_EQUAL(8, info.bitrate);
+  TEST_ASSERT_EQUAL(8000, info.sampleRate);
+  TEST_ASSERT_EQUAL(72, info.frameLength);
+  TEST_ASSERT_EQUAL(576, info.samplesPerFrame);
+  TEST_ASSERT_EQUAL(17, info.sideInfoSize);
+}
+
+void test_mpeg1_layer2_with_crc() {
+  // 192 kbit/s, 48000 Hz
+  const uint8_t header[] = {0xFF, 0xFC, 0xA4, 0x00};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(2, info.layer);
+  TEST_ASSERT_TRUE(info.crc);
+  TEST_ASSERT_EQUAL(192, info.bitrate);
+  TEST_ASSERT_EQUAL(48000, info.sampleRate);
+  TEST_ASSERT_EQUAL(576, info.frameLength);
+  TEST_ASSERT_EQUAL(1152, info.samplesPerFrame);
+  TEST_ASSERT_EQUAL(0, info.sideInfoSize);
+}
+
+void test_mpeg1_layer1() {
+  // 288 kbit/s, 44100 Hz, the length counts 4 byte slots
+  const uint8_t header[] = {0xFF, 0xFF, 0x90, 0x00};
+  mp3FrameInfo info;
+
+  TEST_ASSERT_TRUE(parseMp3FrameHeader(header, &info));
+  TEST_ASSERT_EQUAL(1, info.layer);
+  TEST_ASSERT_EQUAL(288, info.bitrate);
+  TEST_ASSERT_EQUAL(312, info.frameLength);
+  TEST_ASSERT_EQUAL(384, info.samplesPerFrame);
+}
+
+void test_invalid_headers() {
+  const uint8_t headers[][4] = {
+    {0xFF, 0x1B, 0x90, 0x64},                    // no frame sync
+    {0xFE, 0xFB, 0x90, 0x64},                    // no frame sync
+    {0xFF, 0xEB, 0x90, 0x64},                    // reserved version
+    {0xFF, 0xF9, 0x90, 0x64},                    // reserved layer
+    {0xFF, 0xFB, 0x00, 0x64},                    // free format
+    {0xFF, 0xFB, 0xF0, 0x64},                    // bad bitrate
+    {0xFF, 0xFB, 0x9C, 0x64}                     // reserved sample rate
+  };
+  mp3FrameInfo info;
+
+  for (size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++) {
+    TEST_ASSERT_FALSE(parseMp3FrameHeader(headers[i], &info));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mpeg1_layer3);
+  RUN_TEST(test_padding_adds_a_byte);
+  RUN_TEST(test_mpeg2_layer3_mono);
+  RUN_TEST(test_mpeg25_layer3);
+  RUN_TEST(test_mpeg1_layer2_with_crc);
+  RUN_TEST(test_mpeg1_layer1);
+  RUN_TEST(test_invalid_headers);
+  return UNITY_END();
+}
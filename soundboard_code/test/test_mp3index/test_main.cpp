@@ -0,0 +1,153 @@
+/**
+   Tests of the frame index with the files in sampledata/: the index is built the way an upload feeds it,
+   written next to the sound and used to start in the middle of it like /play/<sound>/<ms> does.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Mp3FrameIndex.h"
+#include "Mp3IndexFile.h"
+#include "Vs1053Sim.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+static uint8_t* sample;
+static size_t sampleSize;
+static Mp3FrameIndex frameIndex;
+static char dataDir[] = "/tmp/mp3indexXXXXXX";
+
+// reads sampledata/<n>.mp3 into sample and indexes it in odd sized pieces like an upload
+static void loadSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  FILE* file = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(file);
+  fseek(file, 0, SEEK_END);
+  sampleSize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  free(sample);
+  sample = (uint8_t*) malloc(sampleSize);
+  TEST_ASSERT_EQUAL(sampleSize, fread(sample, 1, sampleSize, file));
+  fclose(file);
+
+  frameIndex.reset();
+  for (size_t pos = 0; pos < sampleSize; pos += 1460) {
+    frameIndex.feed(sample + pos, sampleSize - pos < 1460 ? sampleSize - pos : 1460);
+  }
+  frameIndex.finish();
+}
+
+// true when the frame starts at or before the time and the next one after it
+static bool playsAt(uint32_t frame, uint32_t ms) {
+  const mp3IndexHeader &header = frameIndex.header();
+  // compared in samples * 1000, no rounding
+  uint64_t at = (uint64_t) ms * header.sampleRate;
+  uint64_t start = (uint64_t) frame * header.samplesPerFrame * 1000;
+  return start <= at && at < start + (uint64_t) header.samplesPerFrame * 1000;
+}
+
+void setUp() {
+  sample = NULL;
+  sampleSize = 0;
+}
+
+void tearDown() {
+  free(sample);
+  sample = NULL;
+  Mp3IndexFile::remove("/3.mp3");
+}
+
+void test_every_entry_is_a_frame_header() {
+  for (int n = 1; n <= 6; n++) {
+    loadSample(n);
+    const mp3IndexHeader &header = frameIndex.header();
+
+    TEST_ASSERT_GREATER_THAN(0, header.frameCount);
+    TEST_ASSERT_GREATER_THAN(0, header.entryCount);
+    TEST_ASSERT_LESS_OR_EQUAL(MP3_INDEX_MAX_ENTRIES, header.entryCount);
+    for (uint16_t i = 0; i < header.entryCount; i++) {
+      mp3FrameInfo info;
+      uint32_t offset = frameIndex.entries()[i];
+      TEST_ASSERT_LESS_THAN(sampleSize, offset + MP3_HEADER_SIZE);
+      TEST_ASSERT_TRUE(parseMp3FrameHeader(sample + offset, &info));
+      TEST_ASSERT_EQUAL(header.sampleRate, info.sampleRate);
+      if (i) {
+        TEST_ASSERT_GREATER_THAN(frameIndex.entries()[i - 1], offset);
+      }
+    }
+  }
+}
+
+void test_frame_at_time() {
+  loadSample(3);
+  const mp3IndexHeader &header = frameIndex.header();
+
+  TEST_ASSERT_EQUAL(0, Mp3FrameIndex::frameAt(header, 0));
+  TEST_ASSERT_EQUAL(header.frameCount, Mp3FrameIndex::frameAt(header, header.durationMs));
+  TEST_ASSERT_EQUAL(header.frameCount, Mp3FrameIndex::frameAt(header, 0xFFFFFFFF));
+  for (uint32_t ms = 0; ms < header.durationMs; ms += 97) {
+    uint32_t frame = Mp3FrameIndex::frameAt(header, ms);
+    TEST_ASSERT_LESS_THAN(header.frameCount, frame);
+    TEST_ASSERT_TRUE(playsAt(frame, ms));
+  }
+}
+
+void test_seek_inside_a_sample() {
+  loadSample(3);
+  const mp3IndexHeader &header = frameIndex.header();
+  TEST_ASSERT_TRUE(Mp3IndexFile::write("/3.mp3", frameIndex));
+
+  uint32_t ms = header.durationMs / 2;
+  uint32_t offset;
+  TEST_ASSERT_TRUE(Mp3IndexFile::timeOffset("/3.mp3", ms, &offset));
+
+  // an entry of the index, at most one stride before the time
+  uint16_t entry = 0;
+  while (entry < header.entryCount && frameIndex.entries()[entry] != offset) {
+    entry++;
+  }
+  TEST_ASSERT_LESS_THAN(header.entryCount, entry);
+  TEST_ASSERT_GREATER_THAN(0, entry);
+  uint32_t frame = Mp3FrameIndex::frameAt(header, ms);
+  TEST_ASSERT_TRUE(playsAt(frame, ms));
+  TEST_ASSERT_EQUAL(frame / header.stride, entry);
+
+  // the vs1053 gets a frame header first, no garbage until it syncs
+  Vs1053Sim sim(0, 0, 0);
+  sim.begin();
+  sim.startSong();
+  sim.playChunk(sample + offset, 4096);
+  TEST_ASSERT_EQUAL(0, sim.midFrameStarts);
+}
+
+void test_seek_past_the_end_fails() {
+  loadSample(3);
+  TEST_ASSERT_TRUE(Mp3IndexFile::write("/3.mp3", frameIndex));
+
+  uint32_t offset;
+  TEST_ASSERT_FALSE(Mp3IndexFile::timeOffset("/3.mp3", frameIndex.header().durationMs + 1000, &offset));
+  // without an index there is nothing to seek with
+  TEST_ASSERT_FALSE(Mp3IndexFile::timeOffset("/4.mp3", 1000, &offset));
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  nativeSetDataDir(dataDir);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_every_entry_is_a_frame_header);
+  RUN_TEST(test_frame_at_time);
+  RUN_TEST(test_seek_inside_a_sample);
+  RUN_TEST(test_seek_past_the_end_fails);
+  int failures = UNITY_END();
+
+  rmdir(dataDir);
+  return failures;
+}
@@ -0,0 +1,290 @@
+/**
+   Tests of the filter which strips tags and the leading silence from an uploaded mp3.
+   Built frames check each rule on its own, the files in sampledata/ check that a real upload comes out
+   as whole frames however the network splits it.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "Mp3UploadFilter.h"
+#include "Mp3FrameIndex.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define FRAME_SIZE 417                           // 128 kbit/s, 44100 Hz, no padding
+#define SIDE_INFO_BIT 20                         // First granule after main_data_begin, private bits and scfsi
+#define GRANULE_BITS 59
+
+typedef std::vector<uint8_t> bytes_t;
+
+static bytes_t output;
+
+static void collect(void* ctx, const uint8_t* data, size_t len) {
+  ((bytes_t*) ctx)->insert(((bytes_t*) ctx)->end(), data, data + len);
+}
+
+static void setBits(uint8_t* data, uint32_t bit, uint8_t count, uint32_t value) {
+  for (uint8_t i = 0; i < count; i++, bit++) {
+    uint8_t mask = 0x80 >> (bit & 7);
+    if (value & (1UL << (count - 1 - i))) {
+      data[bit >> 3] |= mask;
+    } else {
+      data[bit >> 3] &= ~mask;
+    }
+  }
+}
+
+// a mpeg 1 layer 3 stereo frame, every granule with the given part2_3_length and global_gain
+static void addFrame(bytes_t &file, uint16_t part23, uint8_t gain, uint8_t fill) {
+  uint8_t frame[FRAME_SIZE];
+  memset(frame, fill, sizeof(frame));
+  frame[0] = 0xFF;
+  frame[1] = 0xFB;
+  frame[2] = 0x90;
+  frame[3] = 0x64;
+
+  uint8_t* side = frame + MP3_HEADER_SIZE;
+  memset(side, 0, 32);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint32_t bit = SIDE_INFO_BIT + i * GRANULE_BITS;
+    setBits(side, bit, 12, part23);
+    setBits(side, bit + 12 + 9, 8, gain);
+  }
+  file.insert(file.end(), frame, frame + sizeof(frame));
+}
+
+static void addAudible(bytes_t &file, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    addFrame(file, 1000, 150, (uint8_t) (0x10 + i));
+  }
+}
+
+static void addSilent(bytes_t &file, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    addFrame(file, 0, 0, (uint8_t) (0x80 + i));
+  }
+}
+
+static void addId3v2(bytes_t &file, uint32_t size) {
+  const uint8_t header[] = {'I', 'D', '3', 3, 0, 0, (uint8_t) (size >> 21 & 0x7F), (uint8_t) (size >> 14 & 0x7F),
+                            (uint8_t) (size >> 7 & 0x7F), (uint8_t) (size & 0x7F)};
+  file.insert(file.end(), header, header + sizeof(header));
+  file.insert(file.end(), size, 0x55);
+}
+
+// runs the file through a filter in pieces of the given size
+static void filter(Mp3UploadFilter &filter, const bytes_t &file, size_t piece) {
+  for (size_t pos = 0; pos < file.size(); pos += piece) {
+    filter.feed(file.data() + pos, file.size() - pos < piece ? file.size() - pos : piece);
+  }
+  filter.finish();
+}
+
+static void assertOutput(const bytes_t &expected) {
+  TEST_ASSERT_EQUAL(expected.size(), output.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected.data(), output.data(), expected.size());
+}
+
+static void assertCounted(const Mp3UploadFilter &filter, size_t fileSize) {
+  TEST_ASSERT_EQUAL(fileSize, filter.bytesIn);
+  TEST_ASSERT_EQUAL(output.size(), filter.bytesOut);
+  TEST_ASSERT_EQUAL(filter.bytesIn, filter.bytesOut + filter.tagBytes + filter.silentBytes);
+}
+
+void setUp() {
+  output.clear();
+}
+
+void tearDown() {
+}
+
+void test_frames_pass_unchanged() {
+  bytes_t file;
+  addAudible(file, 5);
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  assertOutput(file);
+  assertCounted(mp3Filter, file.size());
+}
+
+void test_id3v2_tag_is_dropped() {
+  bytes_t frames;
+  addAudible(frames, 3);
+  bytes_t file;
+  addId3v2(file, 3000);
+  file.insert(file.end(), frames.begin(), frames.end());
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  assertOutput(frames);
+  TEST_ASSERT_EQUAL(3010, mp3Filter.tagBytes);
+  assertCounted(mp3Filter, file.size());
+}
+
+void test_tags_are_kept_when_asked() {
+  bytes_t file;
+  addId3v2(file, 300);
+  addAudible(file, 3);
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(false, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  assertOutput(file);
+  TEST_ASSERT_EQUAL(0, mp3Filter.tagBytes);
+}
+
+void test_junk_and_trailing_tags_are_dropped() {
+  bytes_t frames;
+  addAudible(frames, 4);
+  bytes_t file(7, 0x00);
+  file.insert(file.end(), frames.begin(), frames.end());
+  // id3v1 and an ape tag after the last frame
+  bytes_t tag(128, 0x20);
+  memcpy(tag.data(), "TAG", 3);
+  file.insert(file.end(), tag.begin(), tag.end());
+  memcpy(tag.data(), "APE", 3);
+  file.insert(file.end(), tag.begin(), tag.end());
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  assertOutput(frames);
+  TEST_ASSERT_EQUAL(7 + 256, mp3Filter.tagBytes);
+  assertCounted(mp3Filter, file.size());
+}
+
+void test_leading_silence_keeps_the_last_silent_frame() {
+  bytes_t file;
+  addSilent(file, 5);
+  addAudible(file, 3);
+  addSilent(file, 2);
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  // the audible frame may take bits from the reservoir of the frame before it, silence later on stays
+  bytes_t expected(file.begin() + 4 * FRAME_SIZE, file.end());
+  assertOutput(expected);
+  TEST_ASSERT_EQUAL(4 * FRAME_SIZE, mp3Filter.silentBytes);
+  assertCounted(mp3Filter, file.size());
+}
+
+void test_silence_gain_threshold() {
+  bytes_t file;
+  // coded data, but too quiet for a gain threshold of 100
+  addFrame(file, 500, 60, 0x01);
+  addFrame(file, 500, 60, 0x02);
+  addFrame(file, 500, 120, 0x03);
+  Mp3UploadFilter mp3Filter;
+
+  mp3Filter.begin(true, true, 0, collect, &output);
+  filter(mp3Filter, file, 1460);
+  assertOutput(file);
+
+  output.clear();
+  mp3Filter.begin(true, true, 100, collect, &output);
+  filter(mp3Filter, file, 1460);
+  bytes_t expected(file.begin() + FRAME_SIZE, file.end());
+  assertOutput(expected);
+  TEST_ASSERT_EQUAL(FRAME_SIZE, mp3Filter.silentBytes);
+}
+
+void test_silent_file_keeps_its_last_frame() {
+  bytes_t file;
+  addSilent(file, 4);
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, true, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  bytes_t expected(file.begin() + 3 * FRAME_SIZE, file.end());
+  assertOutput(expected);
+  assertCounted(mp3Filter, file.size());
+}
+
+void test_trimming_can_be_turned_off() {
+  bytes_t file;
+  addSilent(file, 3);
+  addAudible(file, 2);
+  Mp3UploadFilter mp3Filter;
+  mp3Filter.begin(true, false, 0, collect, &output);
+
+  filter(mp3Filter, file, 1460);
+
+  assertOutput(file);
+  TEST_ASSERT_EQUAL(0, mp3Filter.silentBytes);
+}
+
+void test_sample_files_in_any_pieces() {
+  const size_t pieces[] = {1, 3, 417, 1460, 4096};
+
+  for (int n = 1; n <= 6; n++) {
+    char path[64];
+    snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+    FILE* in = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(in);
+    bytes_t file;
+    uint8_t buffer[4096];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+      file.insert(file.end(), buffer, buffer + len);
+    }
+    fclose(in);
+
+    Mp3FrameIndex before;
+    before.feed(file.data(), file.size());
+    uint32_t framesBefore = before.finish().frameCount;
+
+    bytes_t first;
+    for (size_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+      output.clear();
+      Mp3UploadFilter mp3Filter;
+      mp3Filter.begin(true, true, 0, collect, &output);
+      filter(mp3Filter, file, pieces[i]);
+      assertCounted(mp3Filter, file.size());
+
+      if (i == 0) {
+        first = output;
+      } else {
+        assertOutput(first);
+      }
+    }
+
+    // what is left starts with a frame and is frames only, at most the silent ones are gone
+    mp3FrameInfo info;
+    TEST_ASSERT_TRUE(parseMp3FrameHeader(output.data(), &info));
+    Mp3FrameIndex after;
+    after.feed(output.data(), output.size());
+    const mp3IndexHeader &header = after.finish();
+    TEST_ASSERT_GREATER_THAN(0, header.frameCount);
+    TEST_ASSERT_LESS_OR_EQUAL(framesBefore, header.frameCount);
+    TEST_ASSERT_EQUAL(output.size(), header.audioBytes);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_pass_unchanged);
+  RUN_TEST(test_id3v2_tag_is_dropped);
+  RUN_TEST(test_tags_are_kept_when_asked);
+  RUN_TEST(test_junk_and_trailing_tags_are_dropped);
+  RUN_TEST(test_leading_silence_keeps_the_last_silent_frame);
+  RUN_TEST(test_silence_gain_threshold);
+  RUN_TEST(test_silent_file_keeps_its_last_frame);
+  RUN_TEST(test_trimming_can_be_turned_off);
+  RUN_TEST(test_sample_files_in_any_pieces);
+  return UNITY_END();
+}
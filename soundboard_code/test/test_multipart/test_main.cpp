@@ -0,0 +1,229 @@
+/**
+   Tests of the multipart/form-data parser of the uploads.  The bodies are fed in every split the
+   socket could make, the file data has to come out unchanged and without the CRLF of the delimiter.
+*/
+#include <unity.h>
+#include <string.h>
+#include <string>
+
+#include "MultipartParser.h"
+
+#define BOUNDARY "----WebKitFormBoundary7MA4YWxkTrZu0gW"
+
+static MultipartParser parser;
+static std::string fileNames;                    // The names of the parts, separated by '|'
+static std::string fileData;                     // The data of the wanted parts
+static bool wantParts;
+
+static bool onPart(void*, const char* fileName) {
+  fileNames += fileName;
+  fileNames += '|';
+  return wantParts;
+}
+
+static void onData(void*, const uint8_t* data, size_t len) {
+  fileData.append((const char*) data, len);
+}
+
+static std::string part(const char* fileName, const std::string &data) {
+  return std::string("--" BOUNDARY "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"") + fileName +
+         "\"\r\nContent-Type: audio/mpeg\r\n\r\n" + data + "\r\n";
+}
+
+static std::string closing() {
+  return "--" BOUNDARY "--\r\n";
+}
+
+// feeds the body in pieces of the given size, returns the bytes used
+static size_t feedInPieces(const std::string &body, size_t piece) {
+  size_t used = 0;
+  for (size_t pos = 0; pos < body.size() && !parser.done(); pos += piece) {
+    size_t len = piece < body.size() - pos ? piece : body.size() - pos;
+    used += parser.feed((const uint8_t*) body.data() + pos, len);
+  }
+  return used;
+}
+
+// data which looks like the start of the delimiter again and again
+static std::string trickyData() {
+  std::string data;
+  for (int i = 0; i < 40; i++) {
+    data += (char) (i * 37);
+    data += "\r\n--";
+    data += std::string(BOUNDARY).substr(0, i % 30);
+    data += "\r\r\n-";
+  }
+  return data;
+}
+
+void setUp() {
+  fileNames.clear();
+  fileData.clear();
+  wantParts = true;
+  TEST_ASSERT_TRUE(parser.begin(BOUNDARY, onPart, onData, NULL));
+}
+
+void tearDown() {
+}
+
+void test_one_file() {
+  std::string body = part("1.mp3", "ID3 and some data") + closing();
+
+  // the CRLF after the closing delimiter is left over
+  TEST_ASSERT_EQUAL(body.size() - 2, parser.feed((const uint8_t*) body.data(), body.size()));
+
+  TEST_ASSERT_TRUE(parser.done());
+  TEST_ASSERT_EQUAL_STRING("1.mp3|", fileNames.c_str());
+  TEST_ASSERT_EQUAL_STRING("ID3 and some data", fileData.c_str());
+  TEST_ASSERT_EQUAL(1, parser.parts);
+  TEST_ASSERT_EQUAL(17, parser.dataBytes);
+  TEST_ASSERT_EQUAL(body.size() - 2, parser.bytesIn);
+}
+
+void test_every_piece_size_gives_the_same_data() {
+  std::string data = trickyData();
+  std::string body = "preamble\r\n" + part("2.mp3", data) + closing();
+
+  for (size_t piece = 1; piece <= body.size(); piece++) {
+    setUp();
+    feedInPieces(body, piece);
+
+    TEST_ASSERT_TRUE(parser.done());
+    TEST_ASSERT_EQUAL(data.size(), fileData.size());
+    TEST_ASSERT_TRUE(data == fileData);
+  }
+}
+
+void test_delimiter_split_at_every_position() {
+  std::string data(300, 'x');
+  std::string body = part("3.mp3", data) + closing();
+  // the delimiter which ends the data
+  size_t at = body.find("\r\n--" BOUNDARY "--");
+
+  for (size_t split = at; split <= at + strlen("\r\n--" BOUNDARY "--"); split++) {
+    setUp();
+    parser.feed((const uint8_t*) body.data(), split);
+    parser.feed((const uint8_t*) body.data() + split, body.size() - split);
+
+    TEST_ASSERT_TRUE(parser.done());
+    TEST_ASSERT_TRUE(data == fileData);
+  }
+}
+
+void test_first_delimiter_without_a_crlf_before() {
+  std::string body = part("4.mp3", "abc") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL_STRING("4.mp3|", fileNames.c_str());
+  TEST_ASSERT_EQUAL_STRING("abc", fileData.c_str());
+}
+
+void test_fields_without_a_file_name_are_skipped() {
+  std::string body = "--" BOUNDARY "\r\nContent-Disposition: form-data; name=\"volume\"\r\n\r\n80\r\n" +
+                     part("5.mp3", "sound") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL(2, parser.parts);
+  TEST_ASSERT_EQUAL_STRING("5.mp3|", fileNames.c_str());
+  TEST_ASSERT_EQUAL_STRING("sound", fileData.c_str());
+}
+
+void test_unwanted_parts_are_not_passed_on() {
+  std::string body = part("hashes.lst", "00000000 0 /1.mp3\n") + closing();
+  wantParts = false;
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_TRUE(parser.done());
+  TEST_ASSERT_EQUAL_STRING("hashes.lst|", fileNames.c_str());
+  TEST_ASSERT_EQUAL(0, fileData.size());
+  TEST_ASSERT_EQUAL(0, parser.dataBytes);
+}
+
+void test_every_file_of_the_form_is_offered() {
+  std::string body = part("6.mp3", "first") + part("7.mp3", "second") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL(2, parser.parts);
+  TEST_ASSERT_EQUAL_STRING("6.mp3|7.mp3|", fileNames.c_str());
+  TEST_ASSERT_EQUAL_STRING("firstsecond", fileData.c_str());
+}
+
+void test_bytes_after_the_closing_delimiter_are_not_used() {
+  std::string body = part("8.mp3", "data") + "--" BOUNDARY "--";
+  std::string next = "\r\nGET /info HTTP/1.1\r\n\r\n";
+  std::string all = body + next;
+
+  size_t used = parser.feed((const uint8_t*) all.data(), all.size());
+
+  TEST_ASSERT_TRUE(parser.done());
+  TEST_ASSERT_EQUAL(body.size(), used);
+  TEST_ASSERT_EQUAL(0, parser.feed((const uint8_t*) next.data(), next.size()));
+}
+
+void test_path_of_the_file_name_is_dropped() {
+  std::string body = part("C:\\Users\\me\\sounds/9.mp3", "x") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL_STRING("9.mp3|", fileNames.c_str());
+}
+
+void test_file_name_without_quotes() {
+  std::string body = "--" BOUNDARY "\r\ncontent-disposition: form-data; name=file; filename=10.mp3; x=y\r\n\r\nabc\r\n" + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL_STRING("10.mp3|", fileNames.c_str());
+  TEST_ASSERT_EQUAL_STRING("abc", fileData.c_str());
+}
+
+void test_long_file_name_is_cut() {
+  std::string name(100, 'a');
+  std::string body = part(name.c_str(), "x") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_EQUAL(MULTIPART_MAX_NAME + 1, fileNames.size());
+}
+
+void test_quoted_boundary() {
+  TEST_ASSERT_TRUE(parser.begin("\"" BOUNDARY "\"", onPart, onData, NULL));
+  std::string body = part("11.mp3", "quoted") + closing();
+
+  parser.feed((const uint8_t*) body.data(), body.size());
+
+  TEST_ASSERT_TRUE(parser.done());
+  TEST_ASSERT_EQUAL_STRING("quoted", fileData.c_str());
+}
+
+void test_invalid_boundaries() {
+  std::string tooLong(MULTIPART_MAX_BOUNDARY + 1, 'b');
+
+  TEST_ASSERT_FALSE(parser.begin("", onPart, onData, NULL));
+  TEST_ASSERT_FALSE(parser.begin("\"\"", onPart, onData, NULL));
+  TEST_ASSERT_FALSE(parser.begin(tooLong.c_str(), onPart, onData, NULL));
+  // nothing is parsed after an invalid boundary
+  TEST_ASSERT_EQUAL(0, parser.feed((const uint8_t*) "--b\r\n", 5));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_one_file);
+  RUN_TEST(test_every_piece_size_gives_the_same_data);
+  RUN_TEST(test_delimiter_split_at_every_position);
+  RUN_TEST(test_first_delimiter_without_a_crlf_before);
+  RUN_TEST(test_fields_without_a_file_name_are_skipped);
+  RUN_TEST(test_unwanted_parts_are_not_passed_on);
+  RUN_TEST(test_every_file_of_the_form_is_offered);
+  RUN_TEST(test_bytes_after_the_closing_delimiter_are_not_used);
+  RUN_TEST(test_path_of_the_file_name_is_dropped);
+  RUN_TEST(test_file_name_without_quotes);
+  RUN_TEST(test_long_file_name_is_cut);
+  RUN_TEST(test_quoted_boundary);
+  RUN_TEST(test_invalid_boundaries);
+  return UNITY_END();
+}
@@ -0,0 +1,187 @@
+/**
+   Tests of the mixer of the polyphony mode: saturation, voices ending, voice stealing and the wav header.
+*/
+#include <unity.h>
+#include <string.h>
+
+#include "PcmMixer.h"
+
+// plays count samples of a constant value
+class ConstSource : public PcmSource {
+  public:
+    ConstSource(int16_t value, size_t count) : _value(value), _left(count) {}
+
+    size_t read(int16_t* samples, size_t count) {
+      if (count > _left) {
+        count = _left;
+      }
+      for (size_t i = 0; i < count; i++) {
+        samples[i] = _value;
+      }
+      _left -= count;
+      return count;
+    }
+
+    void close() {
+      closed = true;
+    }
+
+    bool closed = false;
+
+  private:
+    int16_t _value;
+    size_t _left;
+};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_mix_saturates() {
+  int16_t dst[] = {30000, -30000, 100, 32767, -32768};
+  const int16_t src[] = {30000, -30000, -200, 1, -1};
+
+  PcmMixer::mixSaturate(dst, src, 5);
+
+  TEST_ASSERT_EQUAL_INT16(32767, dst[0]);
+  TEST_ASSERT_EQUAL_INT16(-32768, dst[1]);
+  TEST_ASSERT_EQUAL_INT16(-100, dst[2]);
+  TEST_ASSERT_EQUAL_INT16(32767, dst[3]);
+  TEST_ASSERT_EQUAL_INT16(-32768, dst[4]);
+}
+
+void test_no_voice_is_silence() {
+  PcmMixer mixer(4);
+  int16_t out[16];
+  memset(out, 0x55, sizeof(out));
+
+  TEST_ASSERT_FALSE(mixer.mix(out, 16));
+  for (int i = 0; i < 16; i++) {
+    TEST_ASSERT_EQUAL_INT16(0, out[i]);
+  }
+}
+
+void test_voices_are_added() {
+  PcmMixer mixer(4);
+  ConstSource a(1000, 1000);
+  ConstSource b(-300, 1000);
+  int16_t out[600];
+
+  mixer.startVoice(mixer.allocVoice(), &a);
+  mixer.startVoice(mixer.allocVoice(), &b);
+
+  // more than one block of the mixer
+  TEST_ASSERT_TRUE(mixer.mix(out, 600));
+  TEST_ASSERT_EQUAL(2, mixer.activeVoices());
+  TEST_ASSERT_EQUAL_INT16(700, out[0]);
+  TEST_ASSERT_EQUAL_INT16(700, out[599]);
+}
+
+void test_a_voice_ends_with_its_sound() {
+  PcmMixer mixer(2);
+  ConstSource shortSound(500, 100);
+  ConstSource longSound(10, 1000);
+  int16_t out[200];
+
+  mixer.startVoice(mixer.allocVoice(), &shortSound);
+  mixer.startVoice(mixer.allocVoice(), &longSound);
+
+  mixer.mix(out, 200);
+  TEST_ASSERT_EQUAL_INT16(510, out[99]);
+  TEST_ASSERT_EQUAL_INT16(10, out[100]);
+  TEST_ASSERT_TRUE(shortSound.closed);
+  TEST_ASSERT_FALSE(longSound.closed);
+  TEST_ASSERT_EQUAL(1, mixer.activeVoices());
+}
+
+void test_oldest_voice_is_stolen() {
+  PcmMixer mixer(2);
+  ConstSource first(1, 10000);
+  ConstSource second(2, 10000);
+  ConstSource third(4, 10000);
+  int16_t out[8];
+
+  mixer.startVoice(mixer.allocVoice(), &first);
+  mixer.startVoice(mixer.allocVoice(), &second);
+  mixer.startVoice(mixer.allocVoice(), &third);
+
+  TEST_ASSERT_EQUAL(1, mixer.steals);
+  TEST_ASSERT_TRUE(first.closed);
+  TEST_ASSERT_FALSE(second.closed);
+  mixer.mix(out, 8);
+  TEST_ASSERT_EQUAL_INT16(6, out[0]);
+}
+
+void test_voice_is_stolen_only_when_the_new_sound_starts() {
+  PcmMixer mixer(2);
+  ConstSource first(1, 10000);
+  ConstSource second(2, 10000);
+  ConstSource third(4, 10000);
+  int16_t out[8];
+
+  mixer.startVoice(mixer.allocVoice(), &first);
+  mixer.startVoice(mixer.allocVoice(), &second);
+
+  // the new sound could not be opened, the oldest plays on
+  uint8_t voice = mixer.allocVoice();
+  TEST_ASSERT_EQUAL(0, mixer.steals);
+  TEST_ASSERT_FALSE(first.closed);
+  TEST_ASSERT_TRUE(mixer.uses(&first));
+  mixer.mix(out, 8);
+  TEST_ASSERT_EQUAL_INT16(3, out[0]);
+
+  mixer.startVoice(voice, &third);
+  TEST_ASSERT_EQUAL(1, mixer.steals);
+  TEST_ASSERT_TRUE(first.closed);
+  TEST_ASSERT_FALSE(mixer.uses(&first));
+  TEST_ASSERT_TRUE(mixer.uses(&third));
+  mixer.mix(out, 8);
+  TEST_ASSERT_EQUAL_INT16(6, out[0]);
+}
+
+void test_voice_count_is_limited() {
+  PcmMixer mixer(MIXER_MAX_VOICES + 4);
+  TEST_ASSERT_EQUAL(MIXER_MAX_VOICES, mixer.voices());
+}
+
+void test_stop_all_closes_the_sources() {
+  PcmMixer mixer(3);
+  ConstSource a(1, 100);
+  ConstSource b(1, 100);
+
+  mixer.startVoice(mixer.allocVoice(), &a);
+  mixer.startVoice(mixer.allocVoice(), &b);
+  mixer.stopAll();
+
+  TEST_ASSERT_TRUE(a.closed);
+  TEST_ASSERT_TRUE(b.closed);
+  TEST_ASSERT_EQUAL(0, mixer.activeVoices());
+}
+
+void test_wav_header() {
+  uint8_t header[WAV_HEADER_SIZE];
+  const uint8_t expected[WAV_HEADER_SIZE] = {
+    'R', 'I', 'F', 'F', 0xFF, 0xFF, 0xFF, 0xFF, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
+    16, 0, 0, 0, 1, 0, 1, 0, 0x22, 0x56, 0, 0, 0x44, 0xAC, 0, 0,
+    2, 0, 16, 0, 'd', 'a', 't', 'a', 0xFF, 0xFF, 0xFF, 0xFF
+  };
+
+  PcmMixer::wavHeader(header, 22050, 1);
+  TEST_ASSERT_EQUAL_MEMORY(expected, header, WAV_HEADER_SIZE);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mix_saturates);
+  RUN_TEST(test_no_voice_is_silence);
+  RUN_TEST(test_voices_are_added);
+  RUN_TEST(test_a_voice_ends_with_its_sound);
+  RUN_TEST(test_oldest_voice_is_stolen);
+  RUN_TEST(test_voice_is_stolen_only_when_the_new_sound_starts);
+  RUN_TEST(test_voice_count_is_limited);
+  RUN_TEST(test_stop_all_closes_the_sources);
+  RUN_TEST(test_wav_header);
+  return UNITY_END();
+}
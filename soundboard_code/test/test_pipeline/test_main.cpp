@@ -0,0 +1,203 @@
+/**
+   Runs the whole playback pipeline on the host: setup() starts the player and the sound task, loop()
+   runs in a thread of its own like the arduino loop task and the sounds come from sampledata/.
+   The simulated vs1053 takes the data in real time, its counters show underruns, overflows, sounds
+   which did not start on a frame and data which came after a stop.
+   The decoder is run at several bitrates, up to the highest mp3 bitrate the feeding has to keep up.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "PlayerControl.h"
+#include "Vs1053Sim.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define PIPELINE_TIMEOUT_MS 20000                // Longest a sound may take in a test
+
+// the player of the firmware in main.cpp
+extern Vs1053Sim vs1053player;
+extern std::atomic<int> playingSound;
+
+static char dataDir[] = "/tmp/pipelineXXXXXX";
+
+// the sim counters before a run
+struct simCounters_struct {
+  uint32_t decodedBytes;
+  uint32_t underruns;
+  uint32_t overflows;
+  uint32_t cancels;
+  uint32_t midFrameStarts;
+  uint32_t strayBytes;
+};
+
+static simCounters_struct before;
+
+static void copySample(int n) {
+  char from[64];
+  char to[64];
+  snprintf(from, sizeof(from), SAMPLEDATA_DIR "%d.mp3", n);
+  snprintf(to, sizeof(to), "%s/%d.mp3", dataDir, n);
+
+  FILE* in = fopen(from, "rb");
+  FILE* out = fopen(to, "wb");
+  TEST_ASSERT_NOT_NULL(in);
+  TEST_ASSERT_NOT_NULL(out);
+  char buffer[4096];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    fwrite(buffer, 1, len, out);
+  }
+  fclose(in);
+  fclose(out);
+}
+
+static void snapshot() {
+  before.decodedBytes = vs1053player.decodedBytes;
+  before.underruns = vs1053player.underruns;
+  before.overflows = vs1053player.overflows;
+  before.cancels = vs1053player.cancels;
+  before.midFrameStarts = vs1053player.midFrameStarts;
+  before.strayBytes = vs1053player.strayBytes;
+}
+
+// waits until the player has started and finished a sound and the vs1053 has decoded the tail of it,
+// returns the ms it took
+static uint32_t waitPlayed() {
+  uint32_t start = millis();
+  while (playingSound < 0 && millis() - start < 1000) {
+    delay(1);
+  }
+  while (playingSound >= 0 && millis() - start < PIPELINE_TIMEOUT_MS) {
+    delay(1);
+  }
+  TEST_ASSERT_EQUAL(-1, playingSound);
+
+  // the ring buffer and the FIFO still hold the end of the sound
+  uint32_t decoded;
+  uint32_t last = millis();
+  do {
+    decoded = vs1053player.decodedBytes;
+    delay(10);
+    if (vs1053player.decodedBytes != decoded) {
+      last = millis();
+    }
+  } while (millis() - last < 200 && millis() - start < PIPELINE_TIMEOUT_MS);
+  return last - start;
+}
+
+static void assertClean() {
+  TEST_ASSERT_EQUAL(before.overflows, vs1053player.overflows);
+  TEST_ASSERT_EQUAL(before.midFrameStarts, vs1053player.midFrameStarts);
+  TEST_ASSERT_EQUAL(before.strayBytes, vs1053player.strayBytes);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_sounds_play_without_underruns() {
+  // 320 kbit/s is the highest mp3 bitrate, the faster runs show the headroom and may underrun
+  const uint32_t bitrates[] = {128000, 320000, 640000, 1000000};
+
+  for (size_t i = 0; i < sizeof(bitrates) / sizeof(bitrates[0]); i++) {
+    // the sound task leaves the sim alone while nothing plays
+    vs1053player.setBitrate(bitrates[i]);
+    snapshot();
+
+    TEST_ASSERT_TRUE(playerPlay(1, 0, micros()));
+    uint32_t ms = waitPlayed();
+
+    char message[128];
+    snprintf(message, sizeof(message), "%7u bit/s: %5u ms, %u bytes decoded, %u underruns, start latency %u us",
+             bitrates[i], ms, vs1053player.decodedBytes - before.decodedBytes,
+             vs1053player.underruns - before.underruns, vs1053player.startLatencyUs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_OR_EQUAL(28612, vs1053player.decodedBytes - before.decodedBytes);
+    if (bitrates[i] <= 320000) {
+      TEST_ASSERT_EQUAL(before.underruns, vs1053player.underruns);
+    }
+    TEST_ASSERT_LESS_THAN(50000, vs1053player.startLatencyUs);
+    assertClean();
+  }
+  vs1053player.setBitrate(VS1053_SIM_BITRATE);
+}
+
+void test_retrigger_cancels_cleanly() {
+  snapshot();
+
+  // every press cuts the sound before, the last one plays to the end
+  const uint16_t sounds[] = {6, 3, 6, 4, 5, 2};
+  for (size_t i = 0; i < sizeof(sounds) / sizeof(sounds[0]); i++) {
+    TEST_ASSERT_TRUE(playerPlay(sounds[i], 0, micros()));
+    delay(150);
+  }
+  waitPlayed();
+
+  TEST_ASSERT_GREATER_OR_EQUAL(before.cancels + 5, vs1053player.cancels);
+  assertClean();
+}
+
+void test_start_in_the_middle_needs_an_index() {
+  snapshot();
+
+  // the copied files have no index, the sound starts at its beginning
+  TEST_ASSERT_TRUE(playerPlay(2, 500, micros()));
+  waitPlayed();
+
+  TEST_ASSERT_GREATER_OR_EQUAL(10031, vs1053player.decodedBytes - before.decodedBytes);
+  assertClean();
+}
+
+void test_stop_while_playing() {
+  snapshot();
+
+  TEST_ASSERT_TRUE(playerPlay(3, 0, micros()));
+  delay(300);
+  uint32_t start = millis();
+  TEST_ASSERT_TRUE(playerStop(micros()));
+  waitPlayed();
+
+  // 3.mp3 plays for 15 s, the stop ends it at once
+  TEST_ASSERT_LESS_THAN(1000, millis() - start);
+  assertClean();
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 6; n++) {
+    copySample(n);
+  }
+  nativeSetDataDir(dataDir);
+
+  setup();
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sounds_play_without_underruns);
+  RUN_TEST(test_retrigger_cancels_cleanly);
+  RUN_TEST(test_start_in_the_middle_needs_an_index);
+  RUN_TEST(test_stop_while_playing);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
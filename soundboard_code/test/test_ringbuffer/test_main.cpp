@@ -0,0 +1,187 @@
+/**
+   Tests of the ring buffer between mp3loop() and the sound task.
+   The stress test runs a producer and a consumer in two std::threads the way the player task and the
+   sound task use it and checks that every byte arrives once and in order.
+*/
+#include <unity.h>
+#include <string.h>
+#include <thread>
+
+#include "RingBuffer.h"
+
+#define TEST_RING_SIZE 64
+#define STRESS_RING_SIZE 8192
+#define STRESS_BYTES (64UL << 20)                // Bytes passed through the stress test
+
+static uint8_t storage[TEST_RING_SIZE];
+
+void setUp() {
+  memset(storage, 0, sizeof(storage));
+}
+
+void tearDown() {
+}
+
+void test_empty_buffer() {
+  RingBuffer ring(storage, sizeof(storage));
+  uint8_t* data;
+
+  TEST_ASSERT_EQUAL(0, ring.readAvailable());
+  TEST_ASSERT_EQUAL(TEST_RING_SIZE, ring.writeAvailable());
+  TEST_ASSERT_EQUAL(0, ring.peek(&data));
+}
+
+void test_write_and_read() {
+  RingBuffer ring(storage, sizeof(storage));
+  const uint8_t in[] = "0123456789";
+  uint8_t out[16];
+
+  TEST_ASSERT_EQUAL(10, ring.write(in, 10));
+  TEST_ASSERT_EQUAL(10, ring.readAvailable());
+  TEST_ASSERT_EQUAL(TEST_RING_SIZE - 10, ring.writeAvailable());
+  TEST_ASSERT_EQUAL(10, ring.read(out, sizeof(out)));
+  TEST_ASSERT_EQUAL_MEMORY(in, out, 10);
+  TEST_ASSERT_EQUAL(0, ring.readAvailable());
+}
+
+void test_write_stops_when_full() {
+  RingBuffer ring(storage, sizeof(storage));
+  uint8_t in[TEST_RING_SIZE + 10];
+  memset(in, 0x55, sizeof(in));
+
+  TEST_ASSERT_EQUAL(TEST_RING_SIZE, ring.write(in, sizeof(in)));
+  TEST_ASSERT_EQUAL(0, ring.writeAvailable());
+  TEST_ASSERT_EQUAL(0, ring.write(in, 1));
+}
+
+void test_wrap_around() {
+  RingBuffer ring(storage, sizeof(storage));
+  uint8_t in[48];
+  uint8_t out[48];
+  uint8_t* data;
+
+  for (size_t i = 0; i < sizeof(in); i++) {
+    in[i] = (uint8_t) i;
+  }
+
+  // move the positions close to the end of the storage
+  ring.write(in, 40);
+  ring.read(out, 40);
+
+  TEST_ASSERT_EQUAL(48, ring.write(in, 48));
+  // peek only hands out the part up to the end of the storage
+  TEST_ASSERT_EQUAL(TEST_RING_SIZE - 40, ring.peek(&data));
+  TEST_ASSERT_EQUAL(48, ring.read(out, sizeof(out)));
+  TEST_ASSERT_EQUAL_MEMORY(in, out, 48);
+}
+
+void test_write_position_tags_commands() {
+  RingBuffer ring(storage, sizeof(storage));
+  uint8_t in[20] = {0};
+
+  ring.write(in, 12);
+  size_t stopAt = ring.writePosition();
+  ring.write(in, 8);
+
+  TEST_ASSERT_EQUAL(12, stopAt);
+  TEST_ASSERT_EQUAL(0, ring.readPosition());
+  ring.consume(12);
+  TEST_ASSERT_EQUAL(stopAt, ring.readPosition());
+}
+
+void test_discard_to() {
+  RingBuffer ring(storage, sizeof(storage));
+  uint8_t in[30] = {0};
+
+  ring.write(in, 30);
+  ring.discardTo(20);
+  TEST_ASSERT_EQUAL(10, ring.readAvailable());
+
+  // neither backwards nor past the written data
+  ring.discardTo(10);
+  TEST_ASSERT_EQUAL(10, ring.readAvailable());
+  ring.discardTo(31);
+  TEST_ASSERT_EQUAL(10, ring.readAvailable());
+
+  ring.flush();
+  TEST_ASSERT_EQUAL(0, ring.readAvailable());
+  TEST_ASSERT_EQUAL(TEST_RING_SIZE, ring.writeAvailable());
+}
+
+static uint8_t pattern(size_t position) {
+  return (uint8_t) (position * 31 + (position >> 9));
+}
+
+void test_spsc_stress() {
+  static uint8_t stressStorage[STRESS_RING_SIZE];
+  RingBuffer ring(stressStorage, sizeof(stressStorage));
+  size_t errors = 0;
+
+  // the producer writes odd sized blocks like mp3loop(), the consumer takes what is there like the sound task
+  std::thread producer([&ring]() {
+    uint8_t block[1021];
+    size_t position = 0;
+
+    while (position < STRESS_BYTES) {
+      size_t len = sizeof(block) - position % 97;
+      if (len > STRESS_BYTES - position) {
+        len = STRESS_BYTES - position;
+      }
+      for (size_t i = 0; i < len; i++) {
+        block[i] = pattern(position + i);
+      }
+
+      size_t done = 0;
+      while (done < len) {
+        done += ring.write(block + done, len - done);
+        if (done < len) {
+          std::this_thread::yield();
+        }
+      }
+      position += len;
+    }
+  });
+
+  std::thread consumer([&ring, &errors]() {
+    size_t position = 0;
+
+    while (position < STRESS_BYTES) {
+      uint8_t* data;
+      size_t len = ring.peek(&data);
+      if (len == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      // at most 32 bytes at a time, the size of a sdi transfer
+      if (len > 32) {
+        len = 32;
+      }
+      for (size_t i = 0; i < len; i++) {
+        if (data[i] != pattern(position + i)) {
+          errors++;
+        }
+      }
+      ring.consume(len);
+      position += len;
+    }
+  });
+
+  producer.join();
+  consumer.join();
+
+  TEST_ASSERT_EQUAL(0, errors);
+  TEST_ASSERT_EQUAL(0, ring.readAvailable());
+  TEST_ASSERT_EQUAL(STRESS_BYTES, ring.readPosition());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_buffer);
+  RUN_TEST(test_write_and_read);
+  RUN_TEST(test_write_stops_when_full);
+  RUN_TEST(test_wrap_around);
+  RUN_TEST(test_write_position_tags_commands);
+  RUN_TEST(test_discard_to);
+  RUN_TEST(test_spsc_stress);
+  return UNITY_END();
+}
@@ -0,0 +1,285 @@
+/**
+   Benchmark of the round trip of a /play trigger, with a new connection for every trigger and with one
+   connection kept open.  The firmware runs on the host with wifi on.
+   On the loopback a tcp handshake costs next to nothing, so the triggers are also sent through a proxy
+   which delays every piece of data by LINK_DELAY_US in each direction and holds back a new connection
+   for one round trip, like the handshake over wifi.  A trigger is done when its whole response is read.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_PORT_OFFSET 23000                  // The firmware listens on 23080
+#define BENCH_TRIGGERS 50
+#define LINK_DELAY_US 5000                       // One way delay of the proxy
+
+// the wifi switch of the firmware in main.cpp
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/triggerXXXXXX";
+static uint16_t serverPort = 80 + BENCH_PORT_OFFSET;
+static uint16_t proxyPort;
+
+static int connectTo(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// reads one response, up to the end of its Content-Length, returns the status code
+// every response of the server has one, what came after it stays in received for the next response
+static int readResponse(int fd, std::string &received, std::string* body = NULL) {
+  char buffer[1024];
+  size_t headerEnd;
+  size_t want = 0;
+
+  while ((headerEnd = received.find("\r\n\r\n")) == std::string::npos ||
+         received.size() < (want = headerEnd + 4 + atoi(strstr(received.c_str(), "Content-Length: ") + 16))) {
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len <= 0) {
+      return -1;
+    }
+    received.append(buffer, len);
+  }
+  if (body != NULL) {
+    *body = received.substr(headerEnd + 4, want - headerEnd - 4);
+  }
+  int status = atoi(received.c_str() + 9);
+  received.erase(0, want);
+  return status;
+}
+
+// ### the proxy ###
+
+static void relay(int from, int to) {
+  char buffer[4096];
+  ssize_t len;
+  while ((len = recv(from, buffer, sizeof(buffer), 0)) > 0) {
+    usleep(LINK_DELAY_US);
+    if (!sendAll(to, buffer, len)) {
+      break;
+    }
+  }
+  shutdown(to, SHUT_WR);
+}
+
+static void proxyConnection(int client) {
+  // the handshake over the link, the request waits in the socket meanwhile
+  usleep(2 * LINK_DELAY_US);
+  int server = connectTo(serverPort);
+  if (server >= 0) {
+    std::thread toServer(relay, client, server);
+    relay(server, client);
+    toServer.join();
+    close(server);
+  }
+  close(client);
+}
+
+static bool startProxy() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || bind(fd, (struct sockaddr*) &addr, len) != 0 || listen(fd, 8) != 0 ||
+      getsockname(fd, (struct sockaddr*) &addr, &len) != 0) {
+    return false;
+  }
+  proxyPort = ntohs(addr.sin_port);
+
+  std::thread([fd]() {
+    for (;;) {
+      int client = accept(fd, NULL, NULL);
+      if (client >= 0) {
+        int on = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        std::thread(proxyConnection, client).detach();
+      }
+    }
+  }).detach();
+  return true;
+}
+
+// ### the triggers ###
+
+static const char* triggers[] = {"/play/1", "/play/2"};
+
+// every trigger on a new connection, returns the median round trip in us
+static uint32_t triggerClose(uint16_t port) {
+  uint32_t runs[BENCH_TRIGGERS];
+
+  for (int i = 0; i < BENCH_TRIGGERS; i++) {
+    char request[64];
+    snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nConnection: close\r\n\r\n", triggers[i % 2]);
+
+    uint32_t start = micros();
+    int fd = connectTo(port);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_TRUE(sendAll(fd, request, strlen(request)));
+    std::string received;
+    TEST_ASSERT_EQUAL(200, readResponse(fd, received));
+    runs[i] = micros() - start;
+    close(fd);
+  }
+  std::sort(runs, runs + BENCH_TRIGGERS);
+  return runs[BENCH_TRIGGERS / 2];
+}
+
+// all triggers on one connection, returns the median round trip in us
+static uint32_t triggerKeepAlive(uint16_t port) {
+  uint32_t runs[BENCH_TRIGGERS];
+
+  int fd = connectTo(port);
+  TEST_ASSERT_TRUE(fd >= 0);
+  std::string received;
+  for (int i = 0; i < BENCH_TRIGGERS; i++) {
+    char request[64];
+    snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\n\r\n", triggers[i % 2]);
+
+    uint32_t start = micros();
+    TEST_ASSERT_TRUE(sendAll(fd, request, strlen(request)));
+    TEST_ASSERT_EQUAL(200, readResponse(fd, received));
+    runs[i] = micros() - start;
+  }
+  close(fd);
+  std::sort(runs, runs + BENCH_TRIGGERS);
+  return runs[BENCH_TRIGGERS / 2];
+}
+
+static void report(const char* name, uint32_t us) {
+  char message[96];
+  snprintf(message, sizeof(message), "%s: %6u us per trigger", name, us);
+  TEST_MESSAGE(message);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_server_answers() {
+  // the server is started by loop() once wifi is up
+  uint32_t start = millis();
+  int fd;
+  while ((fd = connectTo(serverPort)) < 0 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+}
+
+void test_loopback_round_trip() {
+  uint32_t closeUs = triggerClose(serverPort);
+  uint32_t keepAliveUs = triggerKeepAlive(serverPort);
+
+  report("loopback, new connection", closeUs);
+  report("loopback, keep-alive    ", keepAliveUs);
+  // both wait for the next loop(), which sleeps 1 ms
+}
+
+void test_round_trip_over_a_slow_link() {
+  TEST_ASSERT_TRUE(startProxy());
+
+  uint32_t closeUs = triggerClose(proxyPort);
+  uint32_t keepAliveUs = triggerKeepAlive(proxyPort);
+
+  report("5 ms link, new connection", closeUs);
+  report("5 ms link, keep-alive    ", keepAliveUs);
+  // one round trip less, the handshake
+  TEST_ASSERT_LESS_THAN(closeUs, keepAliveUs + LINK_DELAY_US);
+  TEST_ASSERT_GREATER_OR_EQUAL(2 * LINK_DELAY_US, keepAliveUs);
+}
+
+void test_pipelined_triggers_are_answered_in_order() {
+  int fd = connectTo(serverPort);
+  TEST_ASSERT_TRUE(fd >= 0);
+
+  // all requests in one write, the answers come back one after the other
+  const char* requests = "GET /play/1 HTTP/1.1\r\n\r\nGET /play/2/100 HTTP/1.1\r\n\r\nGET /play/1/200 HTTP/1.1\r\n\r\n";
+  const char* answers[] = {"Playing sound: 1 from 0 ms\r\n", "Playing sound: 2 from 100 ms\r\n", "Playing sound: 1 from 200 ms\r\n"};
+  TEST_ASSERT_TRUE(sendAll(fd, requests, strlen(requests)));
+  std::string received;
+  for (size_t i = 0; i < 3; i++) {
+    std::string body;
+    TEST_ASSERT_EQUAL(200, readResponse(fd, received, &body));
+    TEST_ASSERT_EQUAL_STRING(answers[i], body.c_str());
+  }
+  close(fd);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 2; n++) {
+    char command[128];
+    snprintf(command, sizeof(command), "cp " SAMPLEDATA_DIR "%d.mp3 %s/", n, dataDir);
+    TEST_ASSERT_EQUAL(0, system(command));
+  }
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(BENCH_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_server_answers);
+  RUN_TEST(test_loopback_round_trip);
+  RUN_TEST(test_round_trip_over_a_slow_link);
+  RUN_TEST(test_pipelined_triggers_are_answered_in_order);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
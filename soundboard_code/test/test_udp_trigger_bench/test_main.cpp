@@ -0,0 +1,295 @@
+/**
+   Benchmark of a trigger over udp against the same trigger over http, on the loopback with the
+   firmware running on the host with wifi on.
+   Each path is timed twice: to the answer of the board, and to the player having started the sound,
+   which is what the audience hears.  The http triggers use a kept open connection and a new one each.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "TriggerProtocol.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+#define BENCH_PORT_OFFSET 24000                  // The http server listens on 24080, udp is not moved
+#define BENCH_TRIGGERS 50
+
+// the player and the wifi switch of the firmware in main.cpp
+extern std::atomic<int> playingSound;
+extern bool turnWifiOn;
+
+static char dataDir[] = "/tmp/udptriggerXXXXXX";
+static uint16_t httpPort = 80 + BENCH_PORT_OFFSET;
+static uint32_t sequence = 1;
+
+// the medians of one path in us
+struct pathResult_struct {
+  uint32_t answerUs;
+  uint32_t playingUs;
+};
+
+static int connectTo(uint16_t port, int type) {
+  int fd = socket(AF_INET, type, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  if (type == SOCK_STREAM) {
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  } else {
+    // a lost answer fails the test instead of hanging it
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// reads one response, up to the end of its Content-Length, returns the status code
+static int readResponse(int fd, std::string &received) {
+  char buffer[1024];
+  size_t headerEnd;
+  size_t want = 0;
+
+  while ((headerEnd = received.find("\r\n\r\n")) == std::string::npos ||
+         received.size() < (want = headerEnd + 4 + atoi(strstr(received.c_str(), "Content-Length: ") + 16))) {
+    ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+    if (len <= 0) {
+      return -1;
+    }
+    received.append(buffer, len);
+  }
+  int status = atoi(received.c_str() + 9);
+  received.erase(0, want);
+  return status;
+}
+
+// sends a command and waits for its answer, returns the status or -1
+static int udpCommand(int fd, triggerPacket_struct &packet) {
+  uint8_t data[TRIGGER_PACKET_SIZE];
+  triggerEncode(packet, data);
+  if (send(fd, data, sizeof(data), 0) != (ssize_t) sizeof(data)) {
+    return -1;
+  }
+  uint8_t answer[TRIGGER_PACKET_SIZE + 1];
+  ssize_t len = recv(fd, answer, sizeof(answer), 0);
+  triggerPacket_struct reply;
+  if (len <= 0 || !triggerParse(answer, len, reply) || reply.command != (packet.command | TRIGGER_ACK) ||
+      reply.sequence != packet.sequence) {
+    return -1;
+  }
+  return reply.value;
+}
+
+static triggerPacket_struct playPacket(uint16_t sound) {
+  triggerPacket_struct packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.command = TRIGGER_PLAY;
+  packet.flags = TRIGGER_FLAG_ACK;
+  packet.sound = sound;
+  packet.sequence = sequence++;
+  return packet;
+}
+
+// spins until the player runs the sound, returns the us since start or 0 after a second
+static uint32_t waitPlaying(int sound, uint32_t start) {
+  while (playingSound != sound) {
+    if (micros() - start > 1000000) {
+      return 0;
+    }
+  }
+  return micros() - start;
+}
+
+static uint32_t median(uint32_t* values) {
+  std::sort(values, values + BENCH_TRIGGERS);
+  return values[BENCH_TRIGGERS / 2];
+}
+
+// the sounds alternate, so every trigger changes the playing sound
+static pathResult_struct triggerUdp() {
+  uint32_t answers[BENCH_TRIGGERS];
+  uint32_t playing[BENCH_TRIGGERS];
+
+  int fd = connectTo(TRIGGER_UDP_PORT, SOCK_DGRAM);
+  TEST_ASSERT_TRUE(fd >= 0);
+  for (int i = 0; i < BENCH_TRIGGERS; i++) {
+    int sound = 1 + i % 2;
+    triggerPacket_struct packet = playPacket(sound);
+
+    uint32_t start = micros();
+    TEST_ASSERT_EQUAL(TRIGGER_OK, udpCommand(fd, packet));
+    answers[i] = micros() - start;
+    playing[i] = waitPlaying(sound, start);
+    TEST_ASSERT_GREATER_THAN(0, playing[i]);
+  }
+  close(fd);
+
+  pathResult_struct result = {median(answers), median(playing)};
+  return result;
+}
+
+static pathResult_struct triggerHttp(bool keepAlive) {
+  uint32_t answers[BENCH_TRIGGERS];
+  uint32_t playing[BENCH_TRIGGERS];
+
+  int fd = keepAlive ? connectTo(httpPort, SOCK_STREAM) : -1;
+  std::string received;
+  for (int i = 0; i < BENCH_TRIGGERS; i++) {
+    int sound = 1 + i % 2;
+    char request[64];
+    snprintf(request, sizeof(request), "GET /play/%d HTTP/1.1\r\n%s\r\n", sound, keepAlive ? "" : "Connection: close\r\n");
+
+    uint32_t start = micros();
+    if (!keepAlive) {
+      fd = connectTo(httpPort, SOCK_STREAM);
+      received.clear();
+    }
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_TRUE(sendAll(fd, request, strlen(request)));
+    TEST_ASSERT_EQUAL(200, readResponse(fd, received));
+    answers[i] = micros() - start;
+    playing[i] = waitPlaying(sound, start);
+    TEST_ASSERT_GREATER_THAN(0, playing[i]);
+    if (!keepAlive) {
+      close(fd);
+    }
+  }
+  if (keepAlive) {
+    close(fd);
+  }
+
+  pathResult_struct result = {median(answers), median(playing)};
+  return result;
+}
+
+static void report(const char* name, const pathResult_struct &result) {
+  char message[128];
+  snprintf(message, sizeof(message), "%s: answer %6u us, playing %6u us", name, result.answerUs, result.playingUs);
+  TEST_MESSAGE(message);
+}
+
+static pathResult_struct udp;
+static pathResult_struct httpKeepAlive;
+static pathResult_struct httpClose;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_server_answers() {
+  // the server and the udp task are started by loop() once wifi is up
+  uint32_t start = millis();
+  int fd;
+  while ((fd = connectTo(httpPort, SOCK_STREAM)) < 0 && millis() - start < 5000) {
+    delay(50);
+  }
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+}
+
+void test_udp_trigger() {
+  udp = triggerUdp();
+  report("udp                  ", udp);
+}
+
+void test_http_trigger() {
+  httpKeepAlive = triggerHttp(true);
+  httpClose = triggerHttp(false);
+  report("http, keep-alive     ", httpKeepAlive);
+  report("http, new connection ", httpClose);
+}
+
+void test_udp_is_answered_first() {
+  char message[96];
+  snprintf(message, sizeof(message), "answer %.1fx, playing %.1fx faster than http keep-alive",
+           (double) httpKeepAlive.answerUs / (udp.answerUs > 0 ? udp.answerUs : 1),
+           (double) httpKeepAlive.playingUs / (udp.playingUs > 0 ? udp.playingUs : 1));
+  TEST_MESSAGE(message);
+  // the udp task answers at once, the http server waits for the next loop()
+  TEST_ASSERT_LESS_THAN(httpKeepAlive.answerUs, udp.answerUs);
+  TEST_ASSERT_LESS_THAN(httpClose.answerUs, udp.answerUs);
+}
+
+void test_copies_are_answered_as_duplicates() {
+  int fd = connectTo(TRIGGER_UDP_PORT, SOCK_DGRAM);
+  TEST_ASSERT_TRUE(fd >= 0);
+  triggerPacket_struct packet = playPacket(1);
+
+  TEST_ASSERT_EQUAL(TRIGGER_OK, udpCommand(fd, packet));
+  TEST_ASSERT_EQUAL(TRIGGER_DUPLICATE, udpCommand(fd, packet));
+  TEST_ASSERT_EQUAL(TRIGGER_DUPLICATE, udpCommand(fd, packet));
+  close(fd);
+}
+
+int main() {
+  TEST_ASSERT_NOT_NULL(mkdtemp(dataDir));
+  for (int n = 1; n <= 2; n++) {
+    char command[128];
+    snprintf(command, sizeof(command), "cp " SAMPLEDATA_DIR "%d.mp3 %s/", n, dataDir);
+    TEST_ASSERT_EQUAL(0, system(command));
+  }
+  nativeSetDataDir(dataDir);
+  nativeSetPortOffset(BENCH_PORT_OFFSET);
+
+  setup();
+  turnWifiOn = true;
+  std::thread([]() {
+    for (;;) {
+      loop();
+      delay(1);
+    }
+  }).detach();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_server_answers);
+  RUN_TEST(test_udp_trigger);
+  RUN_TEST(test_http_trigger);
+  RUN_TEST(test_udp_is_answered_first);
+  RUN_TEST(test_copies_are_answered_as_duplicates);
+  int failures = UNITY_END();
+
+  char command[64];
+  snprintf(command, sizeof(command), "rm -rf %s", dataDir);
+  system(command);
+  return failures;
+}
@@ -0,0 +1,94 @@
+/**
+   Tests of the simulated vs1053 with the files in sampledata/, in virtual time.
+*/
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Vs1053Sim.h"
+
+#ifndef SAMPLEDATA_DIR
+#define SAMPLEDATA_DIR "../sampledata/"
+#endif
+
+static uint8_t* sample;
+static size_t sampleSize;
+
+// reads sampledata/<n>.mp3 into sample
+static void loadSample(int n) {
+  char path[64];
+  snprintf(path, sizeof(path), SAMPLEDATA_DIR "%d.mp3", n);
+
+  FILE* file = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(file);
+  fseek(file, 0, SEEK_END);
+  sampleSize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  free(sample);
+  sample = (uint8_t*) malloc(sampleSize);
+  TEST_ASSERT_EQUAL(sampleSize, fread(sample, 1, sampleSize, file));
+  fclose(file);
+}
+
+void setUp() {
+  sample = NULL;
+  sampleSize = 0;
+}
+
+void tearDown() {
+  free(sample);
+  sample = NULL;
+}
+
+void test_cancel_then_next_song_starts_on_a_header() {
+  Vs1053Sim sim(0, 0, 0);
+  sim.begin();
+
+  loadSample(1);
+  sim.startSong();
+  sim.playChunk(sample, 6000);
+  sim.cancelSong();
+
+  loadSample(2);
+  sim.startSong();
+  sim.playChunk(sample, 4096);
+
+  TEST_ASSERT_EQUAL(1, sim.cancels);
+  // only the reset of begin(), no soft reset was needed
+  TEST_ASSERT_EQUAL(1, sim.resets);
+  TEST_ASSERT_EQUAL(0, sim.midFrameStarts);
+  TEST_ASSERT_EQUAL(0, sim.strayBytes);
+}
+
+void test_start_inside_a_frame_is_counted() {
+  Vs1053Sim sim(0, 0, 0);
+  sim.begin();
+
+  loadSample(3);
+  sim.startSong();
+  sim.playChunk(sample + sampleSize / 2, 1024);
+
+  TEST_ASSERT_EQUAL(1, sim.midFrameStarts);
+}
+
+void test_old_data_after_a_cancel_is_counted() {
+  Vs1053Sim sim(0, 0, 0);
+  sim.begin();
+
+  loadSample(4);
+  sim.startSong();
+  sim.playChunk(sample, 3000);
+  sim.cancelSong();
+  // the rest of the old song, the player has to drop it
+  sim.playChunk(sample + 3000, 500);
+
+  TEST_ASSERT_EQUAL(500, sim.strayBytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_cancel_then_next_song_starts_on_a_header);
+  RUN_TEST(test_start_inside_a_frame_is_counted);
+  RUN_TEST(test_old_data_after_a_cancel_is_counted);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+/**
+   Checks the bytes Vs1053Esp32 clocks out on a mock SPI bus: what is sent while the data select
+   is low has to be the sound, unchanged, however it is split into chunks and bursts.
+   The mock sorts every byte by the chip selects at the time it goes out, DREQ is held high.
+*/
+#include <unity.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "NativeHal.h"
+#include "Configuration.h"
+#include "Vs1053Esp32.h"
+
+static std::vector<uint8_t> sdiBytes;            // Sent in data mode
+static std::vector<uint8_t> sciBytes;            // Sent in control mode
+static size_t unselectedBytes;                   // Sent with no or both selects low
+
+static Vs1053Esp32* player;
+static uint8_t sound[4000];
+
+static void spiTap(const uint8_t* data, size_t len) {
+  bool dataMode = digitalRead(VS1053_DCS) == LOW;
+  bool controlMode = digitalRead(VS1053_CS) == LOW;
+
+  if (dataMode && !controlMode) {
+    sdiBytes.insert(sdiBytes.end(), data, data + len);
+  } else if (controlMode && !dataMode) {
+    sciBytes.insert(sciBytes.end(), data, data + len);
+  } else {
+    unselectedBytes += len;
+  }
+}
+
+void setUp() {
+  sdiBytes.clear();
+  sciBytes.clear();
+  unselectedBytes = 0;
+  for (size_t i = 0; i < sizeof(sound); i++) {
+    sound[i] = (uint8_t) (i * 13 + (i >> 8));
+  }
+}
+
+void tearDown() {
+}
+
+void test_play_chunk_sends_the_data_unchanged() {
+  uint32_t transactions = player->sdiTransactions;
+
+  // odd lengths, the driver splits them into 32 byte pieces
+  player->playChunk(sound, 1000);
+  player->playChunk(sound + 1000, 3000);
+
+  TEST_ASSERT_EQUAL(sizeof(sound), sdiBytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(sound, sdiBytes.data(), sizeof(sound));
+  TEST_ASSERT_EQUAL(2, player->sdiTransactions - transactions);
+  TEST_ASSERT_EQUAL(0, unselectedBytes);
+}
+
+void test_burst_sends_the_data_unchanged_in_one_transaction() {
+  uint32_t transactions = player->sdiTransactions;
+
+  // like the sound task: up to 32 bytes per chunk, shorter ones at the end of the ring buffer
+  player->beginBurst();
+  size_t pos = 0;
+  while (pos < sizeof(sound)) {
+    size_t len = (pos % 160 == 128) ? 7 : 32;
+    if (len > sizeof(sound) - pos) {
+      len = sizeof(sound) - pos;
+    }
+    player->playBurstChunk(sound + pos, len);
+    pos += len;
+  }
+  player->endBurst();
+
+  TEST_ASSERT_EQUAL(sizeof(sound), sdiBytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(sound, sdiBytes.data(), sizeof(sound));
+  TEST_ASSERT_EQUAL(1, player->sdiTransactions - transactions);
+  TEST_ASSERT_EQUAL(0, unselectedBytes);
+  // the data select is released at the end of the burst
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(VS1053_DCS));
+}
+
+void test_control_bytes_do_not_mix_into_the_data() {
+  uint8_t volume = player->getVolume() == 50 ? 60 : 50;
+
+  player->beginBurst();
+  player->playBurstChunk(sound, 32);
+  player->endBurst();
+  player->setVolume(volume);
+  player->playChunk(sound + 32, 32);
+
+  TEST_ASSERT_EQUAL(64, sdiBytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(sound, sdiBytes.data(), 64);
+  // write SCI_VOL, left and right the same
+  uint8_t value = map(volume, 0, 100, 0xF8, 0x00);
+  uint8_t expected[] = {2, 0x0B, value, value};
+  TEST_ASSERT_EQUAL(sizeof(expected), sciBytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected, sciBytes.data(), sizeof(expected));
+}
+
+void test_start_song_sends_fill_bytes_only() {
+  player->startSong();
+
+  TEST_ASSERT_EQUAL(10, sdiBytes.size());
+  for (size_t i = 1; i < sdiBytes.size(); i++) {
+    TEST_ASSERT_EQUAL(sdiBytes[0], sdiBytes[i]);
+  }
+}
+
+int main() {
+  // nothing on the bus answers, DREQ is pulled high so the driver never waits
+  pinMode(VS1053_DREQ, INPUT_PULLUP);
+  player = new Vs1053Esp32(VS1053_CS, VS1053_DCS, VS1053_DREQ);
+  player->begin();
+  nativeSetSpiTap(spiTap);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_play_chunk_sends_the_data_unchanged);
+  RUN_TEST(test_burst_sends_the_data_unchanged_in_one_transaction);
+  RUN_TEST(test_control_bytes_do_not_mix_into_the_data);
+  RUN_TEST(test_start_song_sends_fill_bytes_only);
+  return UNITY_END();
+}